@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "imkcpp.hpp"
+
+// Worst case input a hostile or buggy peer can send, with send / receive windows of range(0) segments.
+// Items are segment headers, so items/s should stay roughly flat as the window grows, see ImKcpp::input() for the bounds.
+namespace adversarial {
+    using namespace imkcpp;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+    constexpr size_t HEADER_SIZE = serializer::fixed_size<SegmentHeader>();
+    constexpr u32 INTERVAL = 10;
+
+    /// Packs segments into as few datagrams of at most MTU bytes as possible.
+    class Datagrams final {
+        std::vector<std::vector<std::byte>> datagrams{};
+
+    public:
+        void add(SegmentHeader header, const std::span<const std::byte> payload = {}) {
+            header.conv = Conv{1};
+            header.len = PayloadLen(static_cast<u32>(payload.size()));
+
+            if (this->datagrams.empty() || this->datagrams.back().size() + HEADER_SIZE + payload.size() > MTU) {
+                this->datagrams.emplace_back();
+                this->datagrams.back().reserve(MTU);
+            }
+
+            std::vector<std::byte>& datagram = this->datagrams.back();
+            size_t offset = datagram.size();
+            datagram.resize(offset + HEADER_SIZE + payload.size());
+
+            serializer::serialize(header, datagram, offset);
+            std::memcpy(datagram.data() + offset, payload.data(), payload.size());
+        }
+
+        void clear() {
+            this->datagrams.clear();
+        }
+
+        [[nodiscard]] size_t size() const {
+            return this->datagrams.size();
+        }
+
+        [[nodiscard]] auto begin() const { return this->datagrams.begin(); }
+        [[nodiscard]] auto end() const { return this->datagrams.end(); }
+    };
+
+    void configure(ImKcpp<MTU>& kcp, const u32 window) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(INTERVAL);
+        kcp.set_congestion_window_enabled(false);
+        kcp.set_send_window(window);
+        kcp.set_receive_window(window);
+    }
+
+    /// Puts window single segment messages in flight.
+    void fill_send_window(ImKcpp<MTU>& kcp, const u32 window, u32& current) {
+        const std::array<std::byte, 8> message{};
+
+        for (u32 i = 0; i < window; ++i) {
+            (void)kcp.send(message);
+        }
+
+        current += INTERVAL;
+        kcp.update(current, [](std::span<const std::byte>) { });
+    }
+}
+
+// Fills the receive window in reverse order, so every PUSH lands in front of all buffered segments,
+// then sends the first sequence number which releases the whole window to the receive queue.
+void BM_imkcpp_adversarial_reverse_push(benchmark::State& state) {
+    using namespace adversarial;
+
+    const auto window = static_cast<u32>(state.range(0));
+
+    ImKcpp<MTU> kcp(Conv{1});
+    configure(kcp, window);
+
+    const std::array<std::byte, 8> payload{};
+    std::array<std::byte, 8> buffer{};
+
+    Datagrams datagrams;
+    u32 base = 0;
+    u32 current = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        datagrams.clear();
+
+        for (u32 i = window; i > 0; --i) {
+            datagrams.add(SegmentHeader{ .cmd = commands::PUSH, .wnd = static_cast<u16>(window), .ts = current, .sn = base + i - 1 }, payload);
+        }
+        state.ResumeTiming();
+
+        for (const auto& datagram : datagrams) {
+            benchmark::DoNotOptimize(kcp.input(datagram));
+        }
+
+        state.PauseTiming();
+        while (kcp.recv(buffer).has_value()) { }
+
+        // Sends the scheduled acks so the ack list doesn't grow between iterations
+        current += INTERVAL;
+        kcp.update(current, [](std::span<const std::byte>) { });
+        base += window;
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * window));
+    state.counters["datagrams"] = benchmark::Counter(static_cast<double>(state.iterations() * datagrams.size()), benchmark::Counter::kIsRate);
+}
+
+// Fills the receive window with header only PUSHes, first every odd sequence number, then the even ones from the back,
+// so each of those lands between buffered segments, until the first one releases the whole window.
+void BM_imkcpp_adversarial_interleaved_push(benchmark::State& state) {
+    using namespace adversarial;
+
+    const auto window = static_cast<u32>(state.range(0));
+
+    ImKcpp<MTU> kcp(Conv{1});
+    configure(kcp, window);
+
+    std::array<std::byte, 8> buffer{};
+
+    Datagrams datagrams;
+    u32 base = 0;
+    u32 current = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        datagrams.clear();
+
+        for (u32 offset = 1; offset < window; offset += 2) {
+            datagrams.add(SegmentHeader{ .cmd = commands::PUSH, .wnd = static_cast<u16>(window), .ts = current, .sn = base + offset });
+        }
+
+        for (u32 offset = window; offset > 0; offset -= 2) {
+            datagrams.add(SegmentHeader{ .cmd = commands::PUSH, .wnd = static_cast<u16>(window), .ts = current, .sn = base + offset - 2 });
+        }
+        state.ResumeTiming();
+
+        for (const auto& datagram : datagrams) {
+            benchmark::DoNotOptimize(kcp.input(datagram));
+        }
+
+        state.PauseTiming();
+        while (kcp.recv(buffer).has_value()) { }
+
+        // Sends the scheduled acks so the ack list doesn't grow between iterations
+        current += INTERVAL;
+        kcp.update(current, [](std::span<const std::byte>) { });
+        base += window;
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * window));
+    state.counters["datagrams"] = benchmark::Counter(static_cast<double>(state.iterations() * datagrams.size()), benchmark::Counter::kIsRate);
+}
+
+// Selectively acknowledges a full send window in a shuffled order, as many ACKs per datagram as fit.
+void BM_imkcpp_adversarial_ack_flood(benchmark::State& state) {
+    using namespace adversarial;
+
+    const auto window = static_cast<u32>(state.range(0));
+
+    ImKcpp<MTU> kcp(Conv{1});
+    configure(kcp, window);
+
+    std::vector<u32> order(window);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+
+    Datagrams datagrams;
+    u32 current = 0;
+    u32 base = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fill_send_window(kcp, window, current);
+
+        datagrams.clear();
+        for (const u32 offset : order) {
+            datagrams.add(SegmentHeader{ .cmd = commands::ACK, .wnd = static_cast<u16>(window), .ts = current, .sn = base + offset, .una = base });
+        }
+        state.ResumeTiming();
+
+        for (const auto& datagram : datagrams) {
+            benchmark::DoNotOptimize(kcp.input(datagram));
+        }
+
+        base += window;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * window));
+    state.counters["datagrams"] = benchmark::Counter(static_cast<double>(state.iterations() * datagrams.size()), benchmark::Counter::kIsRate);
+}
+
+// Maximal datagrams of header only ACKs for sequence numbers inside the window which were already acknowledged,
+// so every header searches a half full send buffer and finds nothing. The state doesn't change, the same datagram is replayed.
+void BM_imkcpp_adversarial_header_only(benchmark::State& state) {
+    using namespace adversarial;
+
+    const auto window = static_cast<u32>(state.range(0));
+
+    ImKcpp<MTU> kcp(Conv{1});
+    configure(kcp, window);
+
+    constexpr u32 base = 0;
+    u32 current = 0;
+    fill_send_window(kcp, window, current);
+
+    // Acknowledges every other segment, the segment at base stays so una doesn't move
+    Datagrams holes;
+    for (u32 offset = 1; offset < window; offset += 2) {
+        holes.add(SegmentHeader{ .cmd = commands::ACK, .wnd = static_cast<u16>(window), .ts = current, .sn = base + offset, .una = base });
+    }
+
+    for (const auto& datagram : holes) {
+        (void)kcp.input(datagram);
+    }
+
+    Datagrams flood;
+    for (size_t i = 0; i < MTU / HEADER_SIZE; ++i) {
+        const u32 offset = static_cast<u32>(i * 2 + 1) % window;
+        flood.add(SegmentHeader{ .cmd = commands::ACK, .wnd = static_cast<u16>(window), .ts = current, .sn = base + offset, .una = base });
+    }
+
+    const std::vector<std::byte>& datagram = *flood.begin();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kcp.input(datagram));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (MTU / HEADER_SIZE)));
+}
+
+BENCHMARK(BM_imkcpp_adversarial_reverse_push)->Unit(benchmark::kMicrosecond)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK(BM_imkcpp_adversarial_interleaved_push)->Unit(benchmark::kMicrosecond)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK(BM_imkcpp_adversarial_ack_flood)->Unit(benchmark::kMicrosecond)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK(BM_imkcpp_adversarial_header_only)->RangeMultiplier(4)->Range(64, 4096);
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "imkcpp.hpp"
+
+// Counts heap allocations of send(), input(), recv() and update() in a steady state transfer.
+// Global operator new / delete are replaced, which is why this is built as its own executable, imkcpp_allocation_benchmarks.
+// Counters are allocations and bytes per call of each operation, broken down by message size and window.
+
+namespace {
+    std::atomic<size_t> allocation_count{0};
+    std::atomic<size_t> allocation_bytes{0};
+
+    /// Every replaced operator new ends up here, aligned ones included, so that nothing escapes the count.
+    void* allocate(const std::size_t size, const std::size_t alignment) noexcept {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return std::malloc(size == 0 ? 1 : size);
+        }
+
+        // aligned_alloc() wants a multiple of the alignment
+        return std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment);
+    }
+
+    // Kept out of line, otherwise GCC sees free() inlined next to operator new and warns with -Wmismatched-new-delete
+    [[gnu::noinline]] void deallocate(void* ptr) noexcept {
+        std::free(ptr);
+    }
+}
+
+void* operator new(const std::size_t size) {
+    if (void* ptr = allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+    if (void* ptr = allocate(size, static_cast<std::size_t>(alignment))) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+namespace {
+    using namespace imkcpp;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+    constexpr u32 INTERVAL = 10;
+
+    struct OperationCount final {
+        size_t calls = 0;
+        size_t allocations = 0;
+        size_t bytes = 0;
+
+        /// Runs fn and attributes the allocations it makes to this operation.
+        template <typename F>
+        void measure(F&& fn) {
+            const size_t count_before = allocation_count.load(std::memory_order_relaxed);
+            const size_t bytes_before = allocation_bytes.load(std::memory_order_relaxed);
+
+            fn();
+
+            this->calls++;
+            this->allocations += allocation_count.load(std::memory_order_relaxed) - count_before;
+            this->bytes += allocation_bytes.load(std::memory_order_relaxed) - bytes_before;
+        }
+
+        void report(benchmark::State& state, const char* name) const {
+            const double calls = static_cast<double>(std::max<size_t>(this->calls, 1));
+
+            state.counters[std::string(name) + " allocs"] = static_cast<double>(this->allocations) / calls;
+            state.counters[std::string(name) + " B"] = static_cast<double>(this->bytes) / calls;
+        }
+    };
+
+    /// Datagrams in flight, reused so that the harness itself doesn't allocate once warmed up.
+    struct Wire final {
+        std::vector<std::byte> bytes{};
+        std::vector<size_t> ends{};
+
+        Wire() {
+            this->bytes.reserve(1 << 22);
+            this->ends.reserve(1 << 14);
+        }
+
+        void push(const std::span<const std::byte> data) {
+            this->bytes.insert(this->bytes.end(), data.begin(), data.end());
+            this->ends.push_back(this->bytes.size());
+        }
+
+        template <typename F>
+        void drain(F&& fn) {
+            size_t begin = 0;
+
+            for (const size_t end : this->ends) {
+                fn(std::span<const std::byte>(this->bytes.data() + begin, end - begin));
+                begin = end;
+            }
+
+            this->bytes.clear();
+            this->ends.clear();
+        }
+    };
+}
+
+// A sender and a receiver exchange messages of range(0) bytes, with send and receive windows of range(1) segments.
+// Each iteration sends as many messages as half the window holds, flushes, delivers, reads and acknowledges them.
+void BM_imkcpp_allocations(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    const auto window = static_cast<u32>(state.range(1));
+
+    ImKcpp<MTU> sender(Conv{1});
+    ImKcpp<MTU> receiver(Conv{1});
+
+    for (ImKcpp<MTU>* kcp : {&sender, &receiver}) {
+        kcp->set_nodelay(1);
+        kcp->set_interval(INTERVAL);
+        kcp->set_congestion_window_enabled(false);
+        kcp->set_send_window(window);
+        kcp->set_receive_window(window);
+    }
+
+    const u32 messages_per_iteration = std::max<u32>(1, window / 2 / static_cast<u32>(sender.estimate_segments_count(size)));
+
+    std::vector<std::byte> message(size, std::byte{1});
+    std::vector<std::byte> buffer(size);
+
+    Wire to_receiver{};
+    Wire to_sender{};
+
+    const output_callback_t sender_output = [&to_receiver](const std::span<const std::byte> data) { to_receiver.push(data); };
+    const output_callback_t receiver_output = [&to_sender](const std::span<const std::byte> data) { to_sender.push(data); };
+
+    OperationCount send{};
+    OperationCount input{};
+    OperationCount recv{};
+    OperationCount update{};
+
+    u32 current = 0;
+
+    const auto step = [&] {
+        for (u32 i = 0; i < messages_per_iteration; ++i) {
+            send.measure([&] { benchmark::DoNotOptimize(sender.send(message)); });
+        }
+
+        current += INTERVAL;
+
+        update.measure([&] { sender.update(current, sender_output); });
+
+        to_receiver.drain([&](const std::span<const std::byte> data) {
+            input.measure([&] { benchmark::DoNotOptimize(receiver.input(data)); });
+        });
+
+        bool received = true;
+        while (received) {
+            recv.measure([&] { received = receiver.recv(buffer).has_value(); });
+        }
+
+        update.measure([&] { receiver.update(current, receiver_output); });
+
+        to_sender.drain([&](const std::span<const std::byte> data) {
+            input.measure([&] { benchmark::DoNotOptimize(sender.input(data)); });
+        });
+    };
+
+    // Lets the buffers grow to their steady state size first
+    for (u32 i = 0; i < 100; ++i) {
+        step();
+    }
+
+    send = input = recv = update = OperationCount{};
+
+    for (auto _ : state) {
+        step();
+    }
+
+    send.report(state, "send");
+    input.report(state, "input");
+    recv.report(state, "recv");
+    update.report(state, "update");
+    state.SetItemsProcessed(static_cast<int64_t>(send.calls));
+}
+
+BENCHMARK(BM_imkcpp_allocations)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{64, 1024, 16 * 1024}, {32, 256}});
@@ -0,0 +1,42 @@
+#include "benchmark/benchmark.h"
+#include "imkcpp.hpp"
+
+// Packs segments with range(0) bytes of payload, capped at the MSS, into datagrams of the given MTU, flushing whenever the next one doesn't fit.
+template <size_t MTU>
+void BM_imkcpp_flusher_emplace(benchmark::State& state) {
+    using namespace imkcpp;
+
+    constexpr size_t SEGMENTS_PER_ITERATION = 1024;
+    constexpr size_t HEADER_SIZE = serializer::fixed_size<SegmentHeader>();
+
+    const auto size = std::min<size_t>(static_cast<size_t>(state.range(0)), MTU_TO_MSS<MTU>());
+
+    Flusher<MTU> flusher;
+    SegmentData data(size);
+
+    SegmentHeader header{};
+    header.cmd = commands::PUSH;
+    header.len = PayloadLen(static_cast<u32>(size));
+
+    size_t datagrams = 0;
+    const output_callback_t output = [&datagrams](const std::span<const std::byte>) { datagrams++; };
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < SEGMENTS_PER_ITERATION; ++i) {
+            header.sn = i;
+
+            (void)flusher.flush_if_does_not_fit(output, HEADER_SIZE + size);
+            flusher.emplace(header, data);
+        }
+
+        (void)flusher.flush_if_not_empty(output);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * SEGMENTS_PER_ITERATION));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * SEGMENTS_PER_ITERATION * (HEADER_SIZE + size)));
+    state.counters["datagrams"] = benchmark::Counter(static_cast<double>(datagrams), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_TEMPLATE(BM_imkcpp_flusher_emplace, 512)->Unit(benchmark::kMicrosecond)->Arg(0)->Arg(64)->Arg(1400);
+BENCHMARK_TEMPLATE(BM_imkcpp_flusher_emplace, 1400)->Unit(benchmark::kMicrosecond)->Arg(0)->Arg(64)->Arg(1400);
+BENCHMARK_TEMPLATE(BM_imkcpp_flusher_emplace, 8192)->Unit(benchmark::kMicrosecond)->Arg(0)->Arg(64)->Arg(1400);
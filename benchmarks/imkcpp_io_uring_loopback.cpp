@@ -0,0 +1,95 @@
+#include "benchmark/benchmark.h"
+
+#if defined(__linux__)
+
+#include "transport/linux_io_uring.hpp"
+
+// Same transfer as BM_imkcpp_udp_loopback, but over the io_uring transport.
+// Reports datagrams per second, goodput and io_uring_enter calls per datagram.
+void BM_imkcpp_io_uring_loopback(benchmark::State& state) {
+    using namespace imkcpp;
+    using namespace imkcpp::transport;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+    constexpr u32 CONNECTIONS = 8;
+    constexpr size_t MESSAGE_SIZE = 16 * 1024;
+    constexpr u32 MESSAGES_PER_ITERATION = 8;
+
+    IoUringConfig config;
+    config.bind_address = UdpAddress::ipv4("127.0.0.1", 0).value();
+    config.recv_buffers = static_cast<u16>(state.range(0));
+    config.send_buffers = static_cast<u32>(state.range(0));
+
+    IoUringConfig server_config = config;
+    server_config.accept_connections = true;
+
+    auto server_result = IoUringTransport<MTU>::open(server_config);
+    auto client_result = IoUringTransport<MTU>::open(config);
+
+    if (!server_result.has_value() || !client_result.has_value()) {
+        state.SkipWithError("io_uring with provided buffer rings is not available");
+        return;
+    }
+
+    auto& server = *server_result.value();
+    auto& client = *client_result.value();
+
+    const auto configure = [](ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        kcp.set_fastresend(2);
+        kcp.set_congestion_window_enabled(false);
+        kcp.set_send_window(1024);
+        kcp.set_receive_window(1024);
+    };
+
+    u64 delivered = 0;
+
+    server.set_accept_callback([&configure](IoUringTransport<MTU>&, Conv, ImKcpp<MTU>& kcp) { configure(kcp); });
+    server.set_receive_callback([&delivered](IoUringTransport<MTU>& transport, const Conv conv) {
+        std::array<std::byte, MESSAGE_SIZE> buffer{};
+
+        while (transport.recv(conv, buffer).has_value()) {
+            delivered++;
+        }
+    });
+
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        configure(*client.connect(Conv{i}, server.local_address()).value());
+    }
+
+    const std::vector<std::byte> message(MESSAGE_SIZE, std::byte{1});
+    u64 expected = 0;
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < CONNECTIONS; ++i) {
+            for (u32 j = 0; j < MESSAGES_PER_ITERATION; ++j) {
+                (void)client.send(Conv{i}, message);
+            }
+        }
+
+        expected += CONNECTIONS * MESSAGES_PER_ITERATION;
+
+        while (delivered < expected) {
+            client.poll(1);
+            server.poll(1);
+        }
+    }
+
+    const auto& client_stats = client.get_stats();
+    const auto& server_stats = server.get_stats();
+    const double datagrams = static_cast<double>(client_stats.datagrams_sent + server_stats.datagrams_sent);
+
+    state.SetBytesProcessed(static_cast<int64_t>(delivered * MESSAGE_SIZE));
+    state.counters["pps"] = benchmark::Counter(datagrams, benchmark::Counter::kIsRate);
+    state.counters["Gbit"] = benchmark::Counter(static_cast<double>(delivered * MESSAGE_SIZE * 8) / 1e9, benchmark::Counter::kIsRate);
+    state.counters["syscalls/datagram"] = static_cast<double>(client_stats.enter_syscalls + server_stats.enter_syscalls) / datagrams;
+}
+
+BENCHMARK(BM_imkcpp_io_uring_loopback)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Arg(64)
+    ->Arg(256);
+
+#endif
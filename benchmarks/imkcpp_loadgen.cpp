@@ -0,0 +1,388 @@
+// Load generator: drives N client / server connection pairs over loopback UDP and reports
+// messages per second, goodput, CPU time per message and latency percentiles.
+//
+// The server runs on its own thread and, by default, echoes every message, so latency is the round trip
+// of a message through both connections. Messages carry the time they were due to be sent, so when a rate
+// is given the latency includes time spent waiting behind a full send window (no coordinated omission).
+//
+// Usage: imkcpp_loadgen [options]
+//   --connections N     connection pairs (default 16)
+//   --duration S        seconds to send for (default 5)
+//   --rate N            messages per second over all connections, 0 sends as fast as the window allows (default 0)
+//   --mix SIZE:WEIGHT,...   message size mix in bytes (default 1024:1), sizes from 16 to 65536
+//   --window N          send and receive window in segments (default 1024)
+//   --interval N        update interval in ms (default 10)
+//   --outstanding N     messages per connection waiting to be sent or acknowledged before sending pauses (default 64)
+//   --batch N           datagrams per sendmmsg / recvmmsg (default 64)
+//   --gso               enable UDP GSO / GRO
+//   --no-echo           the server only counts messages, latency is then measured one way
+//   --seed N            seed of the size mix (default 1)
+
+#include <cstdio>
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "transport/linux_udp.hpp"
+#include "simulator/network_simulator.hpp"
+#include "latency.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::transport;
+
+namespace {
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+    constexpr size_t MIN_MESSAGE_SIZE = 16;
+    constexpr size_t MAX_MESSAGE_SIZE = 65536;
+
+    using clock = std::chrono::steady_clock;
+
+    struct SizeWeight final {
+        size_t size = 0;
+        double weight = 0.0;
+    };
+
+    struct Options final {
+        u32 connections = 16;
+        double duration = 5.0;
+        double rate = 0.0;
+        std::vector<SizeWeight> mix{ {1024, 1.0} };
+        u32 window = 1024;
+        u32 interval = 10;
+        u32 outstanding = 64;
+        size_t batch = 64;
+        bool gso = false;
+        bool echo = true;
+        u64 seed = 1;
+    };
+
+    bool parse_mix(const char* text, std::vector<SizeWeight>& mix) {
+        mix.clear();
+
+        const std::string spec(text);
+        size_t start = 0;
+
+        while (start < spec.size()) {
+            const size_t end = std::min(spec.find(',', start), spec.size());
+            const std::string item = spec.substr(start, end - start);
+            const size_t colon = item.find(':');
+
+            const size_t size = std::strtoul(item.c_str(), nullptr, 10);
+            const double weight = colon == std::string::npos ? 1.0 : std::strtod(item.c_str() + colon + 1, nullptr);
+
+            if (size < MIN_MESSAGE_SIZE || size > MAX_MESSAGE_SIZE || weight <= 0.0) {
+                return false;
+            }
+
+            mix.push_back({size, weight});
+            start = end + 1;
+        }
+
+        return !mix.empty();
+    }
+
+    bool parse(const int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const auto next = [&]() -> const char* {
+                return i + 1 < argc ? argv[++i] : "";
+            };
+
+            const std::string arg = argv[i];
+
+            if (arg == "--connections") {
+                options.connections = static_cast<u32>(std::strtoul(next(), nullptr, 10));
+            } else if (arg == "--duration") {
+                options.duration = std::strtod(next(), nullptr);
+            } else if (arg == "--rate") {
+                options.rate = std::strtod(next(), nullptr);
+            } else if (arg == "--mix") {
+                if (!parse_mix(next(), options.mix)) {
+                    return false;
+                }
+            } else if (arg == "--window") {
+                options.window = static_cast<u32>(std::strtoul(next(), nullptr, 10));
+            } else if (arg == "--interval") {
+                options.interval = static_cast<u32>(std::strtoul(next(), nullptr, 10));
+            } else if (arg == "--outstanding") {
+                options.outstanding = static_cast<u32>(std::strtoul(next(), nullptr, 10));
+            } else if (arg == "--batch") {
+                options.batch = std::strtoul(next(), nullptr, 10);
+            } else if (arg == "--gso") {
+                options.gso = true;
+            } else if (arg == "--no-echo") {
+                options.echo = false;
+            } else if (arg == "--seed") {
+                options.seed = std::strtoull(next(), nullptr, 10);
+            } else {
+                return false;
+            }
+        }
+
+        return options.connections > 0 && options.duration > 0.0 && options.rate >= 0.0 &&
+               options.window > 0 && options.interval > 0 && options.outstanding > 0 && options.batch > 0;
+    }
+
+    double cpu_seconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+    }
+
+    u64 now_ns() {
+        return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count());
+    }
+
+    /// Messages start with the time they were due to be sent, the rest is filler.
+    void stamp(std::vector<std::byte>& message, const u64 due_ns) {
+        std::memcpy(message.data(), &due_ns, sizeof(due_ns));
+    }
+
+    u64 read_stamp(const std::span<const std::byte> message) {
+        u64 due_ns = 0;
+        std::memcpy(&due_ns, message.data(), sizeof(due_ns));
+        return due_ns;
+    }
+
+    void configure(const Options& options, ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(options.interval);
+        kcp.set_fastresend(2);
+        kcp.set_congestion_window_enabled(false);
+        kcp.set_send_window(options.window);
+        kcp.set_receive_window(options.window);
+    }
+
+    /// Client side state of one connection.
+    struct Connection final {
+        u64 next_due_ns = 0;
+        u32 outstanding = 0;
+    };
+
+    int run(const Options& options) {
+        UdpConfig config;
+        config.bind_address = UdpAddress::ipv4("127.0.0.1", 0).value();
+        config.batch_size = options.batch;
+        config.gso = options.gso;
+        config.gro = options.gso;
+
+        UdpConfig server_config = config;
+        server_config.accept_connections = true;
+
+        auto server_result = UdpTransport<MTU>::open(server_config);
+        auto client_result = UdpTransport<MTU>::open(config);
+
+        if (!server_result.has_value() || !client_result.has_value()) {
+            std::fprintf(stderr, "UDP sockets are not available\n");
+            return 1;
+        }
+
+        auto& server = *server_result.value();
+        auto& client = *client_result.value();
+
+        // Server side, only touched by the server thread once it runs
+        u64 server_messages = 0;
+        u64 server_bytes = 0;
+        LatencyHistogram one_way_us{};
+        std::vector<std::byte> server_buffer(MAX_MESSAGE_SIZE);
+
+        server.set_accept_callback([&options](UdpTransport<MTU>&, Conv, ImKcpp<MTU>& kcp) { configure(options, kcp); });
+        server.set_receive_callback([&](UdpTransport<MTU>& transport, const Conv conv) {
+            while (const auto size = transport.recv(conv, server_buffer)) {
+                const std::span<const std::byte> message(server_buffer.data(), size.value());
+
+                server_messages++;
+                server_bytes += message.size();
+
+                if (options.echo) {
+                    (void)transport.send(conv, message);
+                } else {
+                    one_way_us.record(static_cast<u32>((now_ns() - read_stamp(message)) / 1000));
+                }
+            }
+        });
+
+        // Client side
+        std::vector<Connection> connections(options.connections);
+        u64 echoed_messages = 0;
+        u64 echoed_bytes = 0;
+        LatencyHistogram round_trip_us{};
+        std::vector<std::byte> client_buffer(MAX_MESSAGE_SIZE);
+
+        client.set_receive_callback([&](UdpTransport<MTU>& transport, const Conv conv) {
+            while (const auto size = transport.recv(conv, client_buffer)) {
+                round_trip_us.record(static_cast<u32>((now_ns() - read_stamp(std::span(client_buffer).first(size.value()))) / 1000));
+                connections[conv.get()].outstanding--;
+                echoed_messages++;
+                echoed_bytes += size.value();
+            }
+        });
+
+        for (u32 i = 0; i < options.connections; ++i) {
+            configure(options, *client.connect(Conv{i}, server.local_address()).value());
+        }
+
+        std::atomic<bool> stop{false};
+        std::thread server_thread([&server, &stop] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                server.poll(1);
+            }
+        });
+
+        // Size mix, picked by cumulative weight
+        double total_weight = 0.0;
+        for (const SizeWeight& entry : options.mix) {
+            total_weight += entry.weight;
+        }
+
+        simulator::Random random(options.seed);
+        const auto pick_size = [&]() -> size_t {
+            double target = random.uniform() * total_weight;
+
+            for (const SizeWeight& entry : options.mix) {
+                if (target < entry.weight) {
+                    return entry.size;
+                }
+
+                target -= entry.weight;
+            }
+
+            return options.mix.back().size;
+        };
+
+        std::vector<std::byte> message(MAX_MESSAGE_SIZE, std::byte{0x5a});
+        u64 sent_messages = 0;
+        u64 sent_bytes = 0;
+        u64 skipped_sends = 0;
+
+        const double cpu_start = cpu_seconds();
+        const u64 start_ns = now_ns();
+        const u64 end_ns = start_ns + static_cast<u64>(options.duration * 1e9);
+        const u64 period_ns = options.rate > 0.0 ? static_cast<u64>(1e9 * options.connections / options.rate) : 0;
+
+        // Connections start staggered over one period so sends are spread evenly
+        for (u32 i = 0; i < options.connections; ++i) {
+            connections[i].next_due_ns = start_ns + period_ns * i / options.connections;
+        }
+
+        while (true) {
+            const u64 now = now_ns();
+
+            if (now >= end_ns) {
+                break;
+            }
+
+            for (u32 i = 0; i < options.connections; ++i) {
+                Connection& connection = connections[i];
+
+                while (connection.next_due_ns <= now && connection.next_due_ns < end_ns) {
+                    if (connection.outstanding >= options.outstanding) {
+                        // Closed loop sends wait for the window, open loop sends stay due and are late
+                        break;
+                    }
+
+                    const size_t size = pick_size();
+                    const u64 due = period_ns > 0 ? connection.next_due_ns : now;
+
+                    stamp(message, due);
+
+                    if (client.send(Conv{i}, std::span(message).first(size)).has_value()) {
+                        connection.outstanding += options.echo ? 1 : 0;
+                        sent_messages++;
+                        sent_bytes += size;
+                    } else {
+                        skipped_sends++;
+                    }
+
+                    connection.next_due_ns = period_ns > 0 ? connection.next_due_ns + period_ns : now;
+
+                    if (period_ns == 0 && !options.echo) {
+                        // Without echo there's no completion to wait for, bound by the connection's own queue instead
+                        if (client.find(Conv{i})->get_waiting_send_count() >= options.outstanding * 4) {
+                            connection.next_due_ns = now + 1;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            client.poll(0);
+        }
+
+        const u64 send_end_ns = now_ns();
+
+        // Drains what is still in flight for up to a second
+        const u64 drain_end_ns = send_end_ns + 1000000000ull;
+        while (now_ns() < drain_end_ns) {
+            bool idle = true;
+
+            for (u32 i = 0; i < options.connections; ++i) {
+                idle = idle && connections[i].outstanding == 0 && client.find(Conv{i})->get_waiting_send_count() == 0;
+            }
+
+            if (idle) {
+                break;
+            }
+
+            client.poll(1);
+        }
+
+        stop.store(true, std::memory_order_relaxed);
+        server_thread.join();
+
+        const double cpu_used = cpu_seconds() - cpu_start;
+        const double elapsed = static_cast<double>(send_end_ns - start_ns) / 1e9;
+
+        const u64 delivered = options.echo ? echoed_messages : server_messages;
+        const u64 delivered_bytes = options.echo ? echoed_bytes : server_bytes;
+        const LatencyHistogram& latency = options.echo ? round_trip_us : one_way_us;
+        const auto& client_stats = client.get_stats();
+        const auto& server_stats = server.get_stats();
+
+        std::printf("connections %u, duration %.2f s, rate %s, echo %s\n", options.connections, elapsed,
+                    options.rate > 0.0 ? std::to_string(static_cast<u64>(options.rate)).c_str() : "unlimited", options.echo ? "on" : "off");
+        std::printf("sent        %llu messages, %.3f Gbit/s, %llu rejected by send()\n",
+                    static_cast<unsigned long long>(sent_messages), static_cast<double>(sent_bytes) * 8.0 / elapsed / 1e9,
+                    static_cast<unsigned long long>(skipped_sends));
+        std::printf("delivered   %llu messages, %.0f messages/s, %.3f Gbit/s%s\n",
+                    static_cast<unsigned long long>(delivered), static_cast<double>(delivered) / elapsed,
+                    static_cast<double>(delivered_bytes) * 8.0 / elapsed / 1e9, options.echo ? " (echoed back)" : "");
+        std::printf("cpu         %.2f s, %.2f us per message\n", cpu_used, delivered == 0 ? 0.0 : cpu_used * 1e6 / static_cast<double>(delivered));
+        std::printf("datagrams   %llu sent, %llu dropped by full socket buffers\n",
+                    static_cast<unsigned long long>(client_stats.datagrams_sent + server_stats.datagrams_sent),
+                    static_cast<unsigned long long>(client_stats.datagrams_dropped + server_stats.datagrams_dropped));
+        std::printf("%s latency us: p50 %u, p90 %u, p99 %u, p99.9 %u, max %u\n", options.echo ? "round trip" : "one way",
+                    latency.percentile(50), latency.percentile(90), latency.percentile(99), latency.percentile(99.9), latency.get_max());
+
+        return 0;
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+
+    if (!parse(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--connections N] [--duration S] [--rate N] [--mix SIZE:WEIGHT,...] [--window N] "
+                             "[--interval N] [--outstanding N] [--batch N] [--gso] [--no-echo] [--seed N]\n", argv[0]);
+        return 2;
+    }
+
+    return run(options);
+}
+
+#else
+
+int main() {
+    std::fprintf(stderr, "imkcpp_loadgen needs the Linux UDP transport\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,213 @@
+#include <memory>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "session_manager.hpp"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Many mostly idle connections, the production shape: every connection sends a small message once a second
+// and the peers are ticked every 10 ms. An iteration is one tick of both sides, so the time per iteration is
+// the per-tick cost of check() / update() for the whole population, and "per connection" normalizes it.
+//
+// Connections are driven either by a SessionManager, which only touches connections whose deadline has arrived,
+// or by scanning all of them and calling check() on each, as an application without a scheduler would.
+// Cache misses are reported when the benchmark library is built with libpfm (IMKCPP_BENCHMARK_PERF_COUNTERS)
+// and run with --benchmark_perf_counters=CYCLES,INSTRUCTIONS,CACHE-MISSES.
+namespace many_connections {
+    using namespace imkcpp;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+    constexpr u32 TICK_MS = 10;
+    constexpr u32 TICKS_PER_SEND = 100;
+    constexpr size_t MESSAGE_SIZE = 64;
+
+    /// Datagrams in flight between the two sides, packed into one buffer to keep allocations out of the measurement.
+    struct Wire final {
+        std::vector<std::byte> bytes{};
+        std::vector<size_t> ends{};
+
+        void push(const std::span<const std::byte> data) {
+            this->bytes.insert(this->bytes.end(), data.begin(), data.end());
+            this->ends.push_back(this->bytes.size());
+        }
+
+        template <typename F>
+        void drain(F&& fn) {
+            size_t begin = 0;
+
+            for (const size_t end : this->ends) {
+                fn(std::span<const std::byte>(this->bytes.data() + begin, end - begin));
+                begin = end;
+            }
+
+            this->bytes.clear();
+            this->ends.clear();
+        }
+    };
+
+    void configure(ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(TICK_MS);
+    }
+
+    [[nodiscard]] size_t heap_in_use() {
+#if defined(__GLIBC__)
+        return mallinfo2().uordblks;
+#else
+        return 0;
+#endif
+    }
+
+    /// Connections driven by a SessionManager on each side.
+    class Managed final {
+        SessionManager<MTU> client{};
+        SessionManager<MTU> server{};
+
+    public:
+        explicit Managed(const u32 connections) {
+            for (u32 i = 0; i < connections; ++i) {
+                configure(*this->client.create(Conv{i}).value());
+                configure(*this->server.create(Conv{i}).value());
+            }
+        }
+
+        void send(const u32 index, const std::span<const std::byte> message) {
+            (void)this->client.send(Conv{index}, message);
+        }
+
+        void tick(const u32 current, Wire& to_server, Wire& to_client) {
+            std::array<std::byte, MESSAGE_SIZE> buffer{};
+
+            this->client.update(current, [&to_server](Conv, const std::span<const std::byte> data) { to_server.push(data); });
+
+            to_server.drain([&](const std::span<const std::byte> data) {
+                if (const auto conv = peek_conv(data); conv.has_value() && this->server.input(data).has_value()) {
+                    while (this->server.recv(conv.value(), buffer).has_value()) { }
+                }
+            });
+
+            this->server.update(current, [&to_client](Conv, const std::span<const std::byte> data) { to_client.push(data); });
+
+            to_client.drain([&](const std::span<const std::byte> data) { (void)this->client.input(data); });
+        }
+    };
+
+    /// Connections in a plain array, every one of them is checked on every tick.
+    class Scanned final {
+        std::vector<std::unique_ptr<ImKcpp<MTU>>> client{};
+        std::vector<std::unique_ptr<ImKcpp<MTU>>> server{};
+
+        static void update_due(std::vector<std::unique_ptr<ImKcpp<MTU>>>& connections, const u32 current, Wire& wire) {
+            const auto output = [&wire](const std::span<const std::byte> data) { wire.push(data); };
+
+            for (const auto& kcp : connections) {
+                if (time_delta(kcp->check(current), current) <= 0) {
+                    kcp->update(current, output);
+                }
+            }
+        }
+
+        static void input(std::vector<std::unique_ptr<ImKcpp<MTU>>>& connections, Wire& wire, const bool read) {
+            std::array<std::byte, MESSAGE_SIZE> buffer{};
+
+            wire.drain([&](const std::span<const std::byte> data) {
+                const auto conv = peek_conv(data);
+
+                if (!conv.has_value() || conv->get() >= connections.size()) {
+                    return;
+                }
+
+                ImKcpp<MTU>& kcp = *connections[conv->get()];
+
+                if (kcp.input(data).has_value() && read) {
+                    while (kcp.recv(buffer).has_value()) { }
+                }
+            });
+        }
+
+    public:
+        explicit Scanned(const u32 connections) {
+            this->client.reserve(connections);
+            this->server.reserve(connections);
+
+            for (u32 i = 0; i < connections; ++i) {
+                configure(*this->client.emplace_back(std::make_unique<ImKcpp<MTU>>(Conv{i})));
+                configure(*this->server.emplace_back(std::make_unique<ImKcpp<MTU>>(Conv{i})));
+            }
+        }
+
+        void send(const u32 index, const std::span<const std::byte> message) {
+            (void)this->client[index]->send(message);
+        }
+
+        void tick(const u32 current, Wire& to_server, Wire& to_client) {
+            update_due(this->client, current, to_server);
+            input(this->server, to_server, true);
+            update_due(this->server, current, to_client);
+            input(this->client, to_client, false);
+        }
+    };
+
+    template <typename Driver>
+    void run(benchmark::State& state) {
+        const auto connections = static_cast<u32>(state.range(0));
+        const std::array<std::byte, MESSAGE_SIZE> message{};
+
+        Wire to_server{};
+        Wire to_client{};
+        to_server.bytes.reserve(connections * MTU / TICKS_PER_SEND * 4);
+        to_client.bytes.reserve(connections * MTU / TICKS_PER_SEND * 4);
+
+        const size_t heap_before = heap_in_use();
+        Driver driver(connections);
+
+        u32 current = 0;
+        u64 ticks = 0;
+
+        const auto tick = [&] {
+            // Each tick a different 1% of the connections sends, so every connection sends once per TICKS_PER_SEND ticks
+            for (u32 i = static_cast<u32>(ticks % TICKS_PER_SEND); i < connections; i += TICKS_PER_SEND) {
+                driver.send(i, message);
+            }
+
+            current += TICK_MS;
+            ticks++;
+
+            driver.tick(current, to_server, to_client);
+        };
+
+        // Warm up so every connection has sent, been acknowledged and allocated its buffers before measuring memory
+        for (u32 i = 0; i < TICKS_PER_SEND * 2; ++i) {
+            tick();
+        }
+
+        const size_t heap_after = heap_in_use();
+
+        for (auto _ : state) {
+            tick();
+        }
+
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * connections);
+        state.counters["per connection"] = benchmark::Counter(static_cast<double>(state.iterations()) * connections,
+                                                              benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+        state.counters["sizeof"] = static_cast<double>(sizeof(ImKcpp<MTU>));
+
+        if (heap_after > 0) {
+            // Both sides are counted, which also includes the driver's own bookkeeping
+            state.counters["heap B/conn"] = static_cast<double>(heap_after - heap_before) / (2.0 * connections);
+        }
+    }
+}
+
+void BM_imkcpp_many_connections_managed(benchmark::State& state) {
+    many_connections::run<many_connections::Managed>(state);
+}
+
+void BM_imkcpp_many_connections_scanned(benchmark::State& state) {
+    many_connections::run<many_connections::Scanned>(state);
+}
+
+BENCHMARK(BM_imkcpp_many_connections_managed)->Unit(benchmark::kMicrosecond)->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK(BM_imkcpp_many_connections_scanned)->Unit(benchmark::kMicrosecond)->RangeMultiplier(10)->Range(1000, 100000);
@@ -0,0 +1,107 @@
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "imkcpp.hpp"
+
+namespace {
+    using namespace imkcpp;
+
+    constexpr size_t SEGMENTS_PER_ITERATION = 1024;
+
+    SegmentHeader make_header(const u32 sn, const u8 frg, const size_t size) {
+        SegmentHeader header{};
+        header.cmd = commands::PUSH;
+        header.frg = Fragment(frg);
+        header.sn = sn;
+        header.len = PayloadLen(static_cast<u32>(size));
+        return header;
+    }
+
+    std::vector<SegmentData> make_payloads(const size_t count, const size_t size) {
+        std::vector<SegmentData> payloads;
+        payloads.reserve(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            payloads.emplace_back(size);
+        }
+
+        return payloads;
+    }
+}
+
+// Inserts segments which arrive in reverse order within blocks of range(0) sequence numbers,
+// so every insertion searches up to that many buffered segments. A depth of 1 is in order delivery.
+void BM_imkcpp_receiver_emplace_segment(benchmark::State& state) {
+    const auto depth = static_cast<u32>(state.range(0));
+
+    Receiver receiver;
+    receiver.set_queue_limit(SEGMENTS_PER_ITERATION);
+
+    std::array<std::byte, 64> buffer{};
+    u32 base = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<SegmentData> payloads = make_payloads(SEGMENTS_PER_ITERATION, 32);
+        state.ResumeTiming();
+
+        for (u32 block = 0; block < SEGMENTS_PER_ITERATION; block += depth) {
+            for (u32 i = depth; i > 0; --i) {
+                const u32 index = block + i - 1;
+                receiver.emplace_segment(make_header(base + index, 0, 32), payloads[index], 0);
+            }
+        }
+
+        state.PauseTiming();
+        while (receiver.recv(buffer, SEGMENTS_PER_ITERATION, 0).has_value()) { }
+        base += SEGMENTS_PER_ITERATION;
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * SEGMENTS_PER_ITERATION));
+}
+
+BENCHMARK(BM_imkcpp_receiver_emplace_segment)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->Arg(256);
+
+// Reassembles messages of range(0) full size fragments from the receive queue.
+void BM_imkcpp_receiver_recv(benchmark::State& state) {
+    constexpr size_t MSS = MTU_TO_MSS<constants::IKCP_MTU_DEF>();
+
+    const auto fragments = static_cast<u32>(state.range(0));
+    const u32 messages = SEGMENTS_PER_ITERATION / fragments;
+
+    Receiver receiver;
+    receiver.set_queue_limit(SEGMENTS_PER_ITERATION);
+
+    std::vector<std::byte> buffer(fragments * MSS);
+    u32 sn = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<SegmentData> payloads = make_payloads(messages * fragments, MSS);
+
+        for (u32 i = 0; i < messages * fragments; ++i) {
+            const auto frg = static_cast<u8>(fragments - 1 - i % fragments);
+            receiver.emplace_segment(make_header(sn++, frg, MSS), payloads[i], 0);
+        }
+        state.ResumeTiming();
+
+        for (u32 i = 0; i < messages; ++i) {
+            benchmark::DoNotOptimize(receiver.recv(buffer, SEGMENTS_PER_ITERATION, 0));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * messages));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * messages * fragments * MSS));
+}
+
+BENCHMARK(BM_imkcpp_receiver_recv)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(128);
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "imkcpp.hpp"
+
+namespace {
+    using namespace imkcpp;
+
+    /// Fills the buffer with window segments in flight, all due for retransmission after resendts.
+    void fill(SenderBuffer& buffer, const u32 first_sn, const u32 window, const u32 resendts) {
+        const std::array<std::byte, 32> payload{};
+
+        for (u32 i = 0; i < window; ++i) {
+            Segment segment;
+            segment.header.sn = first_sn + i;
+            segment.data_assign(payload);
+            segment.metadata.resendts = resendts;
+            segment.metadata.xmit = 1;
+
+            buffer.push_segment(segment);
+        }
+    }
+}
+
+// Selectively acknowledges every segment of a window of range(0) segments in a shuffled order.
+void BM_imkcpp_sender_buffer_erase(benchmark::State& state) {
+    const auto window = static_cast<u32>(state.range(0));
+
+    std::vector<u32> order(window);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+
+    SenderBuffer buffer;
+    u32 base = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fill(buffer, base, window, 0);
+        state.ResumeTiming();
+
+        for (const u32 offset : order) {
+            benchmark::DoNotOptimize(buffer.erase(base + offset, 0));
+        }
+
+        base += window;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * window));
+}
+
+// Cumulatively acknowledges a window of range(0) segments at once.
+void BM_imkcpp_sender_buffer_erase_before(benchmark::State& state) {
+    const auto window = static_cast<u32>(state.range(0));
+
+    SenderBuffer buffer;
+    u32 base = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fill(buffer, base, window, 0);
+        state.ResumeTiming();
+
+        buffer.erase_before(base + window, 0);
+
+        base += window;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * window));
+}
+
+// Scans a window of range(0) segments none of which is due yet, the worst case of check().
+void BM_imkcpp_sender_buffer_get_earliest_transmit_delta(benchmark::State& state) {
+    const auto window = static_cast<u32>(state.range(0));
+
+    SenderBuffer buffer;
+    fill(buffer, 0, window, 1000);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buffer.get_earliest_transmit_delta(0));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * window));
+}
+
+BENCHMARK(BM_imkcpp_sender_buffer_erase)->Unit(benchmark::kMicrosecond)->RangeMultiplier(8)->Range(32, 4096);
+BENCHMARK(BM_imkcpp_sender_buffer_erase_before)->Unit(benchmark::kMicrosecond)->RangeMultiplier(8)->Range(32, 4096);
+BENCHMARK(BM_imkcpp_sender_buffer_get_earliest_transmit_delta)->RangeMultiplier(8)->Range(32, 4096);
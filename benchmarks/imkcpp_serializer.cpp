@@ -0,0 +1,66 @@
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "imkcpp.hpp"
+
+namespace {
+    constexpr size_t HEADERS_PER_ITERATION = 1024;
+}
+
+void BM_imkcpp_serializer_header_serialize(benchmark::State& state) {
+    using namespace imkcpp;
+
+    std::vector<std::byte> buffer(HEADERS_PER_ITERATION * serializer::fixed_size<SegmentHeader>());
+
+    SegmentHeader header{};
+    header.conv = Conv{0x11223344};
+    header.cmd = commands::PUSH;
+    header.wnd = 128;
+    header.una = 7;
+    header.len = PayloadLen(1376);
+
+    for (auto _ : state) {
+        size_t offset = 0;
+
+        for (u32 i = 0; i < HEADERS_PER_ITERATION; ++i) {
+            header.sn = i;
+            header.ts = i;
+            serializer::serialize(header, buffer, offset);
+        }
+
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * HEADERS_PER_ITERATION));
+}
+
+void BM_imkcpp_serializer_header_deserialize(benchmark::State& state) {
+    using namespace imkcpp;
+
+    std::vector<std::byte> buffer(HEADERS_PER_ITERATION * serializer::fixed_size<SegmentHeader>());
+
+    size_t write_offset = 0;
+    for (u32 i = 0; i < HEADERS_PER_ITERATION; ++i) {
+        SegmentHeader header{};
+        header.sn = i;
+        serializer::serialize(header, buffer, write_offset);
+    }
+
+    for (auto _ : state) {
+        size_t offset = 0;
+        u32 sum = 0;
+
+        for (u32 i = 0; i < HEADERS_PER_ITERATION; ++i) {
+            SegmentHeader header;
+            serializer::deserialize(header, buffer, offset);
+            sum += header.sn;
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * HEADERS_PER_ITERATION));
+}
+
+BENCHMARK(BM_imkcpp_serializer_header_serialize);
+BENCHMARK(BM_imkcpp_serializer_header_deserialize);
@@ -0,0 +1,100 @@
+#include <atomic>
+#include "benchmark/benchmark.h"
+#include "sharded_runtime.hpp"
+
+// Aggregate throughput of two sharded runtimes exchanging datagrams in memory.
+// Every iteration sends a batch of messages on each connection and waits until all of them are received,
+// so items/s should grow close to linearly with the number of shards as long as there are enough cores.
+void BM_imkcpp_sharded_runtime_throughput(benchmark::State& state) {
+    using namespace imkcpp;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+    constexpr u32 CONNECTIONS_PER_SHARD = 64;
+    constexpr size_t MESSAGE_SIZE = 1024;
+    constexpr u32 MESSAGES_PER_ITERATION = 32;
+
+    const auto shards = static_cast<size_t>(state.range(0));
+    const u32 connections = static_cast<u32>(shards) * CONNECTIONS_PER_SHARD;
+
+    std::atomic<u64> delivered{0};
+
+    std::unique_ptr<ShardedRuntime<MTU>> client;
+    std::unique_ptr<ShardedRuntime<MTU>> server;
+
+    // Each runtime gets its own CPUs, so that a server shard and a client shard don't compete for one
+    const typename ShardedRuntime<MTU>::Config server_config{ .shards = shards, .queue_capacity = 16384, .pin_threads = true, .first_cpu = 0 };
+    const typename ShardedRuntime<MTU>::Config client_config{ .shards = shards, .queue_capacity = 16384, .pin_threads = true, .first_cpu = shards };
+
+    server = std::make_unique<ShardedRuntime<MTU>>(server_config,
+        [&client](Conv, const std::span<const std::byte> data) { client->post_input(data); },
+        [&delivered](SessionManager<MTU>& manager, const Conv conv) {
+            std::array<std::byte, MESSAGE_SIZE> buffer{};
+
+            while (manager.recv(conv, buffer).has_value()) {
+                delivered.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+    client = std::make_unique<ShardedRuntime<MTU>>(client_config,
+        [&server](Conv, const std::span<const std::byte> data) { server->post_input(data); });
+
+    const auto setup = [connections](ShardedRuntime<MTU>& runtime, std::atomic<u32>& ready) {
+        for (u32 i = 0; i < connections; ++i) {
+            while (!runtime.post(Conv{i}, [i, &ready](SessionManager<MTU>& manager) {
+                if (const auto kcp = manager.create(Conv{i}); kcp.has_value()) {
+                    kcp.value()->set_nodelay(1);
+                    kcp.value()->set_interval(10);
+                    kcp.value()->set_send_window(1024);
+                    kcp.value()->set_receive_window(1024);
+                }
+
+                ready.fetch_add(1, std::memory_order_relaxed);
+            })) {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    std::atomic<u32> ready{0};
+    setup(*server, ready);
+    setup(*client, ready);
+
+    while (ready.load(std::memory_order_relaxed) < connections * 2) {
+        std::this_thread::yield();
+    }
+
+    u64 expected = 0;
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < connections; ++i) {
+            while (!client->post(Conv{i}, [i](SessionManager<MTU>& manager) {
+                std::array<std::byte, MESSAGE_SIZE> payload{};
+
+                for (u32 j = 0; j < MESSAGES_PER_ITERATION; ++j) {
+                    (void)manager.send(Conv{i}, payload);
+                }
+            })) {
+                std::this_thread::yield();
+            }
+        }
+
+        expected += connections * MESSAGES_PER_ITERATION;
+
+        while (delivered.load(std::memory_order_relaxed) < expected) {
+            std::this_thread::yield();
+        }
+    }
+
+    client->stop();
+    server->stop();
+
+    state.SetItemsProcessed(static_cast<int64_t>(expected));
+    state.SetBytesProcessed(static_cast<int64_t>(expected * MESSAGE_SIZE));
+    state.counters["shards"] = static_cast<double>(shards);
+}
+
+BENCHMARK(BM_imkcpp_sharded_runtime_throughput)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->RangeMultiplier(2)
+    ->Range(1, 8);
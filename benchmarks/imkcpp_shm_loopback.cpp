@@ -0,0 +1,212 @@
+#include "benchmark/benchmark.h"
+
+#if defined(__linux__)
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include "session_manager.hpp"
+#include "transport/shm_ipc.hpp"
+
+// System network headers go after the library ones, see linux_udp.hpp
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace {
+    using namespace imkcpp;
+    using namespace imkcpp::transport;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+
+    std::string channel_name(const char* benchmark) {
+        return std::string("/imkcpp_bench_") + benchmark + "_" + std::to_string(::getpid());
+    }
+
+    double cpu_seconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+    }
+}
+
+// Same workload as BM_imkcpp_udp_loopback, with the sockets replaced by a shared memory channel,
+// so the two can be compared directly. The argument is the number of ring slots per direction,
+// a full ring drops datagrams like a full socket buffer would.
+void BM_imkcpp_shm_loopback(benchmark::State& state) {
+    constexpr u32 CONNECTIONS = 8;
+    constexpr size_t MESSAGE_SIZE = 16 * 1024;
+    constexpr u32 MESSAGES_PER_ITERATION = 8;
+
+    const std::string name = channel_name("kcp");
+    auto creator = ShmChannel<MTU>::create(name, static_cast<u32>(state.range(0)));
+    auto opener = ShmChannel<MTU>::open(name);
+
+    if (!creator.has_value() || !opener.has_value()) {
+        state.SkipWithError("Shared memory is not available");
+        return;
+    }
+
+    auto& client_channel = *creator.value();
+    auto& server_channel = *opener.value();
+
+    SessionManager<MTU> client;
+    SessionManager<MTU> server;
+
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        for (SessionManager<MTU>* sessions : {&client, &server}) {
+            ImKcpp<MTU>& kcp = *sessions->create(Conv{i}).value();
+            kcp.set_nodelay(1);
+            kcp.set_interval(10);
+            kcp.set_fastresend(2);
+            kcp.set_congestion_window_enabled(false);
+            kcp.set_send_window(1024);
+            kcp.set_receive_window(1024);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto now = [&start] {
+        return static_cast<u32>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    u64 datagrams = 0;
+    const auto client_output = [&client_channel, &datagrams](Conv, const std::span<const std::byte> data) {
+        datagrams += client_channel.send(data) ? 1 : 0;
+    };
+    const auto server_output = [&server_channel, &datagrams](Conv, const std::span<const std::byte> data) {
+        datagrams += server_channel.send(data) ? 1 : 0;
+    };
+
+    const std::vector<std::byte> message(MESSAGE_SIZE, std::byte{1});
+    std::array<std::byte, MESSAGE_SIZE> buffer{};
+    u64 delivered = 0;
+    u64 expected = 0;
+    const double cpu_start = cpu_seconds();
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < CONNECTIONS; ++i) {
+            for (u32 j = 0; j < MESSAGES_PER_ITERATION; ++j) {
+                (void)client.send(Conv{i}, message);
+            }
+        }
+
+        expected += CONNECTIONS * MESSAGES_PER_ITERATION;
+
+        while (delivered < expected) {
+            const u32 current = now();
+            client.update(current, client_output);
+            server.update(current, server_output);
+
+            server_channel.receive([&server](const std::span<const std::byte> data) { (void)server.input(data); });
+            client_channel.receive([&client](const std::span<const std::byte> data) { (void)client.input(data); });
+
+            for (u32 i = 0; i < CONNECTIONS; ++i) {
+                while (server.recv(Conv{i}, buffer).has_value()) {
+                    delivered++;
+                }
+            }
+
+            // Like the UDP transport's poll(1), sleep until the next update if there is nothing to read
+            if (!server_channel.readable() && !client_channel.readable()) {
+                server_channel.wait(1);
+            }
+        }
+    }
+
+    const double cpu_used = cpu_seconds() - cpu_start;
+
+    state.SetBytesProcessed(static_cast<int64_t>(delivered * MESSAGE_SIZE));
+    state.counters["pps"] = benchmark::Counter(static_cast<double>(datagrams), benchmark::Counter::kIsRate);
+    state.counters["Gbit"] = benchmark::Counter(static_cast<double>(delivered * MESSAGE_SIZE * 8) / 1e9, benchmark::Counter::kIsRate);
+    state.counters["CPU s/Gbit"] = cpu_used / (static_cast<double>(delivered * MESSAGE_SIZE * 8) / 1e9);
+}
+
+BENCHMARK(BM_imkcpp_shm_loopback)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Arg(1024)
+    ->Arg(4096);
+
+// Per-datagram cost of the shared memory channel: write a batch of MTU sized datagrams and read them back.
+void BM_shm_datagram(benchmark::State& state) {
+    const std::string name = channel_name("datagram");
+    auto creator = ShmChannel<MTU>::create(name, 1024);
+    auto opener = ShmChannel<MTU>::open(name);
+
+    if (!creator.has_value() || !opener.has_value()) {
+        state.SkipWithError("Shared memory is not available");
+        return;
+    }
+
+    const size_t batch = static_cast<size_t>(state.range(0));
+    const std::vector<std::byte> datagram(MTU, std::byte{1});
+    size_t received = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch; ++i) {
+            creator.value()->send(datagram);
+        }
+
+        received += opener.value()->receive([](const std::span<const std::byte> data) { benchmark::DoNotOptimize(data.data()); });
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(received));
+    state.SetBytesProcessed(static_cast<int64_t>(received * MTU));
+}
+
+BENCHMARK(BM_shm_datagram)->Arg(1)->Arg(64);
+
+// The same through a pair of loopback UDP sockets, one sendto() and recv() per datagram.
+void BM_udp_datagram(benchmark::State& state) {
+    const int sender = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    const int receiver = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+
+    const int buffer_size = 8 * 1024 * 1024;
+    ::setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+    if (sender < 0 || receiver < 0 ||
+        ::bind(receiver, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        if (sender >= 0) {
+            ::close(sender);
+        }
+
+        if (receiver >= 0) {
+            ::close(receiver);
+        }
+
+        state.SkipWithError("UDP sockets are not available");
+        return;
+    }
+
+    const size_t batch = static_cast<size_t>(state.range(0));
+    const std::vector<std::byte> datagram(MTU, std::byte{1});
+    std::array<std::byte, MTU> buffer{};
+    size_t received = 0;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch; ++i) {
+            ::sendto(sender, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        }
+
+        while (::recv(receiver, buffer.data(), buffer.size(), 0) > 0) {
+            received++;
+        }
+    }
+
+    ::close(sender);
+    ::close(receiver);
+
+    state.SetItemsProcessed(static_cast<int64_t>(received));
+    state.SetBytesProcessed(static_cast<int64_t>(received * MTU));
+}
+
+BENCHMARK(BM_udp_datagram)->Arg(1)->Arg(64);
+
+#endif
@@ -0,0 +1,33 @@
+#include "simulated_link.hpp"
+
+// Bulk transfer of 2000 1 KiB messages over a simulated link, compare with BM_original_simulated_link.
+void BM_imkcpp_simulated_link(benchmark::State& state) {
+    using namespace simulated_link;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+
+    const SimulationConfig config = make_config(state.range(0));
+    SimulationResult result{};
+
+    for (auto _ : state) {
+        ImKcpp<MTU> sender_kcp(Conv{1});
+        ImKcpp<MTU> receiver_kcp(Conv{1});
+
+        for (ImKcpp<MTU>* kcp : {&sender_kcp, &receiver_kcp}) {
+            kcp->set_nodelay(1);
+            kcp->set_interval(INTERVAL);
+            kcp->set_fastresend(FASTRESEND);
+            kcp->set_send_window(WINDOW);
+            kcp->set_receive_window(WINDOW);
+        }
+
+        KcpEndpoint<MTU> sender(sender_kcp);
+        KcpEndpoint<MTU> receiver(receiver_kcp);
+
+        result = simulate(sender, receiver, config);
+    }
+
+    report(state, result);
+}
+
+SIMULATED_LINK_BENCHMARK(BM_imkcpp_simulated_link);
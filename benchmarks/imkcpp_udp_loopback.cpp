@@ -0,0 +1,114 @@
+#include "benchmark/benchmark.h"
+
+#if defined(__linux__)
+
+#include <ctime>
+#include "transport/linux_udp.hpp"
+
+// Bulk transfer between two UDP transports over the loopback interface, driven from a single thread.
+// Reports datagrams per second, goodput in Gbit/s and process CPU seconds per transferred gigabit.
+// Arguments are the batch size and whether GSO / GRO offload is enabled.
+void BM_imkcpp_udp_loopback(benchmark::State& state) {
+    using namespace imkcpp;
+    using namespace imkcpp::transport;
+
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+    constexpr u32 CONNECTIONS = 8;
+    constexpr size_t MESSAGE_SIZE = 16 * 1024;
+    constexpr u32 MESSAGES_PER_ITERATION = 8;
+
+    UdpConfig config;
+    config.bind_address = UdpAddress::ipv4("127.0.0.1", 0).value();
+    config.batch_size = static_cast<size_t>(state.range(0));
+    config.gso = state.range(1) != 0;
+    config.gro = state.range(1) != 0;
+
+    UdpConfig server_config = config;
+    server_config.accept_connections = true;
+
+    auto server_result = UdpTransport<MTU>::open(server_config);
+    auto client_result = UdpTransport<MTU>::open(config);
+
+    if (!server_result.has_value() || !client_result.has_value()) {
+        state.SkipWithError("UDP sockets are not available");
+        return;
+    }
+
+    auto& server = *server_result.value();
+    auto& client = *client_result.value();
+
+    const auto configure = [](ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        kcp.set_fastresend(2);
+        kcp.set_congestion_window_enabled(false);
+        kcp.set_send_window(1024);
+        kcp.set_receive_window(1024);
+    };
+
+    u64 delivered = 0;
+
+    server.set_accept_callback([&configure](UdpTransport<MTU>&, Conv, ImKcpp<MTU>& kcp) { configure(kcp); });
+    server.set_receive_callback([&delivered](UdpTransport<MTU>& transport, const Conv conv) {
+        std::array<std::byte, MESSAGE_SIZE> buffer{};
+
+        while (transport.recv(conv, buffer).has_value()) {
+            delivered++;
+        }
+    });
+
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        configure(*client.connect(Conv{i}, server.local_address()).value());
+    }
+
+    if (config.gso && (!client.is_gso_enabled() || !server.is_gro_enabled())) {
+        state.SkipWithError("UDP GSO / GRO is not supported by the kernel");
+        return;
+    }
+
+    const auto cpu_seconds = [] {
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+    };
+
+    const std::vector<std::byte> message(MESSAGE_SIZE, std::byte{1});
+    u64 expected = 0;
+    const double cpu_start = cpu_seconds();
+
+    for (auto _ : state) {
+        for (u32 i = 0; i < CONNECTIONS; ++i) {
+            for (u32 j = 0; j < MESSAGES_PER_ITERATION; ++j) {
+                (void)client.send(Conv{i}, message);
+            }
+        }
+
+        expected += CONNECTIONS * MESSAGES_PER_ITERATION;
+
+        while (delivered < expected) {
+            client.poll(1);
+            server.poll(1);
+        }
+    }
+
+    const double cpu_used = cpu_seconds() - cpu_start;
+    const auto& client_stats = client.get_stats();
+    const auto& server_stats = server.get_stats();
+    const double datagrams = static_cast<double>(client_stats.datagrams_sent + server_stats.datagrams_sent);
+
+    state.SetBytesProcessed(static_cast<int64_t>(delivered * MESSAGE_SIZE));
+    state.counters["pps"] = benchmark::Counter(datagrams, benchmark::Counter::kIsRate);
+    state.counters["Gbit"] = benchmark::Counter(static_cast<double>(delivered * MESSAGE_SIZE * 8) / 1e9, benchmark::Counter::kIsRate);
+    state.counters["CPU s/Gbit"] = cpu_used / (static_cast<double>(delivered * MESSAGE_SIZE * 8) / 1e9);
+    state.counters["datagrams/syscall"] = datagrams / static_cast<double>(client_stats.send_syscalls + server_stats.send_syscalls);
+}
+
+BENCHMARK(BM_imkcpp_udp_loopback)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Args({1, 0})
+    ->Args({16, 0})
+    ->Args({64, 0})
+    ->Args({64, 1});
+
+#endif
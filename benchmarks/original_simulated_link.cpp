@@ -0,0 +1,123 @@
+#include <vector>
+#include "simulated_link.hpp"
+#include "original/ikcp.h"
+
+namespace {
+    /// Adapts the original ikcp to simulator::SimulatedEndpoint.
+    class OriginalEndpoint final {
+        constexpr static size_t OVERHEAD = 24;
+        constexpr static imkcpp::u8 CMD_PUSH = 81;
+
+        ikcpcb* kcp;
+        const imkcpp::output_callback_t* output = nullptr;
+
+        // ikcp counts only timeout retransmissions in xmit, so segments are counted as they are output
+        imkcpp::u64 segments_sent = 0;
+        imkcpp::u64 segments_retransmitted = 0;
+
+        /// Whether a segment with the given sn has been sent before.
+        std::vector<bool> sent_sns{};
+
+        [[nodiscard]] static imkcpp::u32 read_u32(const char* data) {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+            return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<imkcpp::u32>(bytes[3]) << 24;
+        }
+
+        void count_segments(const char* data, const size_t size) {
+            for (size_t offset = 0; offset + OVERHEAD <= size;) {
+                const char* header = data + offset;
+
+                if (static_cast<imkcpp::u8>(header[4]) == CMD_PUSH) {
+                    const imkcpp::u32 sn = read_u32(header + 12);
+
+                    if (sn >= this->sent_sns.size()) {
+                        this->sent_sns.resize(sn + 1);
+                    }
+
+                    this->segments_sent++;
+
+                    if (this->sent_sns[sn]) {
+                        this->segments_retransmitted++;
+                    }
+
+                    this->sent_sns[sn] = true;
+                }
+
+                offset += OVERHEAD + read_u32(header + 20);
+            }
+        }
+
+        static int output_callback(const char* data, const int len, ikcpcb*, void* user) {
+            auto* self = static_cast<OriginalEndpoint*>(user);
+            self->count_segments(data, static_cast<size_t>(len));
+            (*self->output)(std::span(reinterpret_cast<const std::byte*>(data), static_cast<size_t>(len)));
+            return 0;
+        }
+
+    public:
+        OriginalEndpoint() : kcp(ikcp_create(1, this)) {
+            ikcp_nodelay(this->kcp, 1, simulated_link::INTERVAL, simulated_link::FASTRESEND, 0);
+            ikcp_wndsize(this->kcp, simulated_link::WINDOW, simulated_link::WINDOW);
+            ikcp_setoutput(this->kcp, output_callback);
+        }
+
+        OriginalEndpoint(const OriginalEndpoint&) = delete;
+        OriginalEndpoint& operator=(const OriginalEndpoint&) = delete;
+
+        ~OriginalEndpoint() {
+            ikcp_release(this->kcp);
+        }
+
+        bool send(const std::span<const std::byte> data) {
+            return ikcp_send(this->kcp, reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size())) >= 0;
+        }
+
+        std::optional<size_t> recv(const std::span<std::byte> buffer) {
+            const int size = ikcp_recv(this->kcp, reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()));
+            return size >= 0 ? std::optional(static_cast<size_t>(size)) : std::nullopt;
+        }
+
+        void input(const std::span<const std::byte> data) {
+            ikcp_input(this->kcp, reinterpret_cast<const char*>(data.data()), static_cast<long>(data.size()));
+        }
+
+        void update(const imkcpp::u32 current, const imkcpp::output_callback_t& callback) {
+            this->output = &callback;
+            ikcp_update(this->kcp, current);
+            this->output = nullptr;
+        }
+
+        [[nodiscard]] size_t get_waiting_send_count() const {
+            return static_cast<size_t>(ikcp_waitsnd(this->kcp));
+        }
+
+        [[nodiscard]] imkcpp::u64 get_segments_sent() const {
+            return this->segments_sent;
+        }
+
+        [[nodiscard]] imkcpp::u64 get_segments_retransmitted() const {
+            return this->segments_retransmitted;
+        }
+    };
+
+    static_assert(imkcpp::simulator::SimulatedEndpoint<OriginalEndpoint>);
+}
+
+// Same scenarios and settings as BM_imkcpp_simulated_link, with the upstream implementation.
+void BM_original_simulated_link(benchmark::State& state) {
+    using namespace simulated_link;
+
+    const SimulationConfig config = make_config(state.range(0));
+    SimulationResult result{};
+
+    for (auto _ : state) {
+        OriginalEndpoint sender;
+        OriginalEndpoint receiver;
+
+        result = simulate(sender, receiver, config);
+    }
+
+    report(state, result);
+}
+
+SIMULATED_LINK_BENCHMARK(BM_original_simulated_link);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "benchmark/benchmark.h"
+#include "simulator/network_simulator.hpp"
+
+// Shared by the imkcpp and original ikcp simulated link benchmarks, so both run identical seeded scenarios
+// with identical settings: nodelay, 10 ms interval, fast resend after 2 acks, 256 segment windows.
+namespace simulated_link {
+    using namespace imkcpp;
+    using namespace imkcpp::simulator;
+
+    constexpr u32 INTERVAL = 10;
+    constexpr u32 FASTRESEND = 2;
+    constexpr u32 WINDOW = 256;
+
+    struct Profile final {
+        const char* name;
+        LinkConfig link;
+    };
+
+    // 20 Mbit/s, 30 ms one way, 64 KiB bottleneck queue, with increasingly hostile impairments
+    inline Profile make_profile(const int64_t index) {
+        LinkConfig link{ 20 * 1000 * 1000, 30 };
+        link.queue_bytes = 64 * 1024;
+
+        switch (index) {
+            case 0:
+                return { "clean", link };
+            case 1:
+                link.loss = 0.02;
+                return { "loss 2%", link };
+            case 2:
+                link.burst_loss = GilbertElliott{ 0.005, 0.3, 0.0, 0.8 };
+                return { "burst loss", link };
+            case 3:
+                link.loss = 0.01;
+                link.jitter_ms = 10;
+                link.reorder = 0.02;
+                link.reorder_delay_ms = 15;
+                link.duplicate = 0.01;
+                return { "loss, jitter, reorder, duplicate", link };
+            default:
+                link.latency_ms = 100;
+                link.loss = 0.1;
+                return { "loss 10%, 200 ms rtt", link };
+        }
+    }
+
+    inline SimulationConfig make_config(const int64_t index) {
+        const Profile profile = make_profile(index);
+
+        SimulationConfig config;
+        config.forward = profile.link;
+        config.backward = profile.link;
+        config.message_count = 2000;
+        config.seed = 1;
+
+        return config;
+    }
+
+    // The time of the benchmark is the CPU cost of the whole simulated run, counters describe the behaviour
+    // on the virtual clock and are identical between runs.
+    inline void report(benchmark::State& state, const SimulationResult& result) {
+        if (!result.completed) {
+            state.SkipWithError("transfer didn't complete within the time limit");
+        }
+
+        state.SetLabel(make_profile(state.range(0)).name);
+        state.counters["goodput Mbit/s"] = result.goodput_bps() / 1e6;
+        state.counters["retransmitted"] = result.retransmission_ratio();
+        state.counters["p50 ms"] = result.latency_percentile(50);
+        state.counters["p99 ms"] = result.latency_percentile(99);
+        state.counters["p999 ms"] = result.latency_percentile(99.9);
+        state.counters["wire KiB"] = static_cast<double>(result.wire_bytes()) / 1024.0;
+        state.counters["simulated ms"] = result.duration_ms;
+    }
+}
+
+#define SIMULATED_LINK_BENCHMARK(name) BENCHMARK(name)->Unit(benchmark::kMillisecond)->DenseRange(0, 4)
@@ -5,6 +5,7 @@
 #include "sender_buffer.hpp"
 #include "segment_tracker.hpp"
 #include "utility.hpp"
+#include "tracing.hpp"
 
 namespace imkcpp {
     /// FastAckCtx is used to track the latest received segment and its timestamp.
@@ -97,31 +98,74 @@ namespace imkcpp {
             this->sender_buffer.increment_fastack_before(maxack);
         }
 
-        void update_remote_una() {
+        template <TracerPolicy Tracer>
+        void update_remote_una(const u32 current, Tracer& tracer) {
+            const u32 snd_una = this->segment_tracker.get_snd_una();
+
             if (const std::optional<u32> first_sn = this->sender_buffer.get_first_sequence_number_in_flight(); first_sn.has_value()) {
                 this->segment_tracker.set_snd_una(first_sn.value());
             } else {
                 this->segment_tracker.reset_snd_una();
             }
+
+            if constexpr (Tracer::enabled) {
+                if (this->segment_tracker.get_snd_una() != snd_una) {
+                    tracer.una_advanced(current, this->segment_tracker.get_snd_una());
+                }
+            }
         }
 
-        /// Removes acknowledged segments from the sender buffer.
-        void ack_received(const u32 sn) {
-            if (this->should_acknowledge(sn)) {
-                this->sender_buffer.erase(sn);
-                this->update_remote_una();
+        /**
+         *Removes acknowledged segments from the sender buffer.
+         *Returns the acknowledged segment if it was still in flight.
+         */
+        template <TracerPolicy Tracer>
+        std::optional<AckedSegment> ack_received(const u32 sn, const u32 current, Tracer& tracer) {
+            if (!this->should_acknowledge(sn)) {
+                return std::nullopt;
+            }
+
+            const std::optional<AckedSegment> acked = this->sender_buffer.erase(sn, current);
+
+            if constexpr (Tracer::enabled) {
+                if (acked.has_value()) {
+                    tracer.ack_received(current, sn, static_cast<u32>(std::max(0, time_delta(current, acked->header.ts))));
+                }
             }
+
+            this->update_remote_una(current, tracer);
+
+            return acked;
         }
 
         /**
          *Removes acknowledged segments from the sender buffer according to
          *remote una (unacknowledged segment number).
         */
-        void una_received(const u32 una) {
+        template <TracerPolicy Tracer>
+        void una_received(const u32 una, const u32 current, Tracer& tracer) {
             rmt_una = std::max(rmt_una, una);
 
-            this->sender_buffer.erase_before(una);
-            this->update_remote_una();
+            this->sender_buffer.erase_before(una, current);
+            this->update_remote_una(current, tracer);
+        }
+
+        /**
+         *Marks segments reported missing by the remote side for immediate retransmission.
+         *Only segments last sent at or before sent_before are marked.
+         */
+        void nack_received(const u32 sn, const u32 count, const u32 sent_before) {
+            const u32 snd_una = this->segment_tracker.get_snd_una();
+            const u32 snd_nxt = this->segment_tracker.get_snd_nxt();
+
+            if (count == 0 || sn >= snd_nxt || sn + count <= snd_una) {
+                return;
+            }
+
+            const u32 first = std::max(sn, snd_una);
+            const u32 last = std::min(sn + (count - 1), snd_nxt - 1);
+
+            this->sender_buffer.mark_nacked(first, last, sent_before);
         }
 
         /// Adds a segment to the acknowledgement list to be sent later.
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <coroutine>
+#include <span>
+#include "third_party/expected.hpp"
+
+#include "types.hpp"
+#include "errors.hpp"
+#include "results.hpp"
+#include "imkcpp.hpp"
+
+namespace imkcpp {
+    /**
+     *AsyncConnection exposes a connection through C++20 awaitables.
+     *Coroutines suspended in recv() or writable() are resumed from input() and update() once they can make progress,
+     *so callers don't have to poll. It doesn't depend on any executor: coroutines are resumed inline on the thread
+     *which drives the connection. Awaiting coroutines must not outlive the connection.
+     */
+    template <size_t MTU>
+    class AsyncConnection final {
+        /// Intrusive FIFO of suspended awaiters. Awaiters live in coroutine frames, so waiting doesn't allocate.
+        template <typename Awaiter>
+        struct WaitList final {
+            Awaiter* head = nullptr;
+            Awaiter* tail = nullptr;
+
+            void push(Awaiter* awaiter) {
+                awaiter->next = nullptr;
+
+                if (this->tail != nullptr) {
+                    this->tail->next = awaiter;
+                } else {
+                    this->head = awaiter;
+                }
+
+                this->tail = awaiter;
+            }
+
+            Awaiter* pop() {
+                Awaiter* awaiter = this->head;
+
+                if (awaiter != nullptr) {
+                    this->head = awaiter->next;
+
+                    if (this->head == nullptr) {
+                        this->tail = nullptr;
+                    }
+                }
+
+                return awaiter;
+            }
+
+            [[nodiscard]] bool empty() const {
+                return this->head == nullptr;
+            }
+        };
+
+    public:
+        class RecvAwaiter final {
+            friend class AsyncConnection;
+
+            AsyncConnection& connection;
+            std::span<std::byte> buffer;
+            std::coroutine_handle<> handle{};
+            RecvAwaiter* next = nullptr;
+
+        public:
+            RecvAwaiter(AsyncConnection& connection, const std::span<std::byte> buffer) : connection(connection), buffer(buffer) { }
+
+            [[nodiscard]] bool await_ready() const noexcept {
+                return connection.can_recv();
+            }
+
+            void await_suspend(const std::coroutine_handle<> awaiting) noexcept {
+                this->handle = awaiting;
+                this->connection.recv_waiters.push(this);
+            }
+
+            tl::expected<size_t, error> await_resume() noexcept {
+                return this->connection.kcp.recv(this->buffer);
+            }
+        };
+
+        class WritableAwaiter final {
+            friend class AsyncConnection;
+
+            AsyncConnection& connection;
+            size_t threshold;
+            std::coroutine_handle<> handle{};
+            WritableAwaiter* next = nullptr;
+
+        public:
+            WritableAwaiter(AsyncConnection& connection, const size_t threshold) : connection(connection), threshold(threshold) { }
+
+            [[nodiscard]] bool await_ready() const noexcept {
+                return this->connection.kcp.get_waiting_send_count() < this->threshold;
+            }
+
+            void await_suspend(const std::coroutine_handle<> awaiting) noexcept {
+                this->handle = awaiting;
+                this->connection.writable_waiters.push(this);
+            }
+
+            void await_resume() const noexcept { }
+        };
+
+    private:
+        ImKcpp<MTU>& kcp;
+
+        WaitList<RecvAwaiter> recv_waiters{};
+        WaitList<WritableAwaiter> writable_waiters{};
+
+        /// Returns true if recv() wouldn't report that data is missing, i.e. it either succeeds or fails for good.
+        [[nodiscard]] bool can_recv() const {
+            const auto size = this->kcp.peek_size();
+            return size.has_value() || (size.error() != error::queue_empty && size.error() != error::waiting_for_fragment);
+        }
+
+        void resume_waiters() {
+            // One at a time, each resumed receiver consumes a message before we check for the next one
+            while (!this->recv_waiters.empty() && this->can_recv()) {
+                this->recv_waiters.pop()->handle.resume();
+            }
+
+            if (this->writable_waiters.empty()) {
+                return;
+            }
+
+            // Detach satisfied writers first, resumed coroutines may wait again
+            const size_t waiting = this->kcp.get_waiting_send_count();
+            WaitList<WritableAwaiter> pending{};
+            WaitList<WritableAwaiter> ready{};
+
+            while (WritableAwaiter* awaiter = this->writable_waiters.pop()) {
+                if (waiting < awaiter->threshold) {
+                    ready.push(awaiter);
+                } else {
+                    pending.push(awaiter);
+                }
+            }
+
+            this->writable_waiters = pending;
+
+            while (WritableAwaiter* awaiter = ready.pop()) {
+                awaiter->handle.resume();
+            }
+        }
+
+    public:
+        explicit AsyncConnection(ImKcpp<MTU>& kcp) : kcp(kcp) { }
+
+        AsyncConnection(const AsyncConnection&) = delete;
+        AsyncConnection& operator=(const AsyncConnection&) = delete;
+
+        /// Resumes when a complete message is available and reads it into the buffer.
+        [[nodiscard]] RecvAwaiter recv(const std::span<std::byte> buffer) {
+            return RecvAwaiter(*this, buffer);
+        }
+
+        /// Resumes when fewer than threshold segments are queued or waiting to be acknowledged.
+        [[nodiscard]] WritableAwaiter writable(const size_t threshold) {
+            return WritableAwaiter(*this, threshold);
+        }
+
+        /// Resumes when everything sent so far has been acknowledged.
+        [[nodiscard]] WritableAwaiter flushed() {
+            return WritableAwaiter(*this, 1);
+        }
+
+        /// Sends data. Never suspends, use writable() for backpressure.
+        tl::expected<size_t, error> send(const std::span<const std::byte> buffer) {
+            return this->kcp.send(buffer);
+        }
+
+        /// Passes a datagram to the connection and resumes coroutines which can make progress.
+        tl::expected<InputResult, error> input(const std::span<const std::byte> data) {
+            auto result = this->kcp.input(data);
+            this->resume_waiters();
+
+            return result;
+        }
+
+        /// Updates the connection and resumes coroutines which can make progress.
+        FlushResult update(const u32 current, const output_callback_t& callback) {
+            const FlushResult result = this->kcp.update(current, callback);
+            this->resume_waiters();
+
+            return result;
+        }
+
+        [[nodiscard]] ImKcpp<MTU>& get() {
+            return this->kcp;
+        }
+    };
+}
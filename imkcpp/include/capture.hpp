@@ -0,0 +1,390 @@
+#pragma once
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <span>
+#include <vector>
+#include "third_party/expected.hpp"
+
+#include "types.hpp"
+#include "errors.hpp"
+#include "types/conv.hpp"
+#include "segment.hpp"
+#include "commands.hpp"
+
+namespace imkcpp {
+    enum class CaptureEvent : u8 {
+        /// update() was called. No payload.
+        Update,
+
+        /// A datagram was passed to input(). The payload is the datagram.
+        Input,
+
+        /// A datagram was passed to the output callback. The payload is the datagram.
+        Output,
+
+        /// send() was called with a message of the recorded size. The message itself is not stored.
+        Send,
+
+        /// recv() was called with a buffer of the recorded size.
+        Recv,
+
+        /// flush() was called directly, i.e. not by update(). No payload.
+        Flush,
+    };
+
+    /// File header of a capture.
+    struct CaptureInfo final {
+        u32 mtu = 0;
+        Conv conv{0};
+    };
+
+    /// A record read from a capture. data is only valid until the next record is read.
+    struct CaptureRecord final {
+        u32 time = 0;
+        CaptureEvent event = CaptureEvent::Update;
+        u32 size = 0;
+        std::span<const std::byte> data{};
+    };
+
+    namespace detail {
+        constexpr u32 CAPTURE_MAGIC = 0x41434b49; // "IKCA" in little endian
+        /// Version 2 added CaptureEvent::Flush, version 1 captures are still read.
+        constexpr u32 CAPTURE_VERSION = 2;
+
+        /// time, size, event
+        constexpr size_t CAPTURE_RECORD_HEADER_SIZE = 9;
+
+        /// Compares two datagrams segment by segment, ignoring PUSH payloads as replay doesn't know the messages.
+        [[nodiscard]] inline bool same_segments(const std::span<const std::byte> a, const std::span<const std::byte> b) {
+            constexpr size_t HEADER_SIZE = serializer::fixed_size<SegmentHeader>();
+
+            if (a.size() != b.size()) {
+                return false;
+            }
+
+            size_t offset = 0;
+
+            while (a.size() - offset >= HEADER_SIZE) {
+                if (std::memcmp(a.data() + offset, b.data() + offset, HEADER_SIZE) != 0) {
+                    return false;
+                }
+
+                SegmentHeader header;
+                size_t header_offset = offset;
+                serializer::deserialize(header, a, header_offset);
+
+                const size_t len = std::min<size_t>(header.len.get(), a.size() - header_offset);
+
+                if (header.cmd != commands::PUSH && std::memcmp(a.data() + header_offset, b.data() + header_offset, len) != 0) {
+                    return false;
+                }
+
+                offset = header_offset + len;
+            }
+
+            return std::memcmp(a.data() + offset, b.data() + offset, a.size() - offset) == 0;
+        }
+    }
+
+    /**
+     *CaptureWriter records what a connection does into a compact file, so the traffic can be replayed later
+     *with replay(), e.g. under a profiler. Attach it with ImKcpp::set_capture().
+     *Records are written in the host's byte order through a large stdio buffer, so recording is mostly a memcpy.
+     *Time is the connection's clock, i.e. the time of the latest update().
+     */
+    class CaptureWriter final {
+        constexpr static size_t FILE_BUFFER_SIZE = 1 << 20;
+
+        std::FILE* file = nullptr;
+        bool failed = false;
+
+        explicit CaptureWriter(std::FILE* file) : file(file) { }
+
+        void write(const u32 time, const CaptureEvent event, const u32 size, const std::span<const std::byte> data) {
+            if (this->file == nullptr) {
+                return;
+            }
+
+            std::array<std::byte, detail::CAPTURE_RECORD_HEADER_SIZE> header{};
+
+            std::memcpy(header.data(), &time, sizeof(time));
+            std::memcpy(header.data() + 4, &size, sizeof(size));
+            header[8] = static_cast<std::byte>(event);
+
+            this->failed |= std::fwrite(header.data(), header.size(), 1, this->file) != 1;
+
+            if (!data.empty()) {
+                this->failed |= std::fwrite(data.data(), data.size(), 1, this->file) != 1;
+            }
+        }
+
+    public:
+        /// Creates a capture file, replacing an existing one.
+        [[nodiscard]] static tl::expected<CaptureWriter, error> create(const char* path, const u32 mtu, const Conv conv) {
+            std::FILE* file = std::fopen(path, "wb");
+
+            if (file == nullptr) {
+                return tl::unexpected(error::file_error);
+            }
+
+            std::setvbuf(file, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+            const std::array<u32, 4> header = { detail::CAPTURE_MAGIC, detail::CAPTURE_VERSION, mtu, conv.get() };
+
+            if (std::fwrite(header.data(), sizeof(header), 1, file) != 1) {
+                std::fclose(file);
+                return tl::unexpected(error::file_error);
+            }
+
+            return CaptureWriter(file);
+        }
+
+        CaptureWriter(const CaptureWriter&) = delete;
+        CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+        CaptureWriter(CaptureWriter&& other) noexcept : file(other.file), failed(other.failed) {
+            other.file = nullptr;
+        }
+
+        CaptureWriter& operator=(CaptureWriter&& other) noexcept {
+            if (this != &other) {
+                (void)this->close();
+                this->file = other.file;
+                this->failed = other.failed;
+                other.file = nullptr;
+            }
+
+            return *this;
+        }
+
+        ~CaptureWriter() {
+            (void)this->close();
+        }
+
+        void update(const u32 time) {
+            this->write(time, CaptureEvent::Update, 0, {});
+        }
+
+        void flush(const u32 time) {
+            this->write(time, CaptureEvent::Flush, 0, {});
+        }
+
+        void input(const u32 time, const std::span<const std::byte> datagram) {
+            this->write(time, CaptureEvent::Input, static_cast<u32>(datagram.size()), datagram);
+        }
+
+        void output(const u32 time, const std::span<const std::byte> datagram) {
+            this->write(time, CaptureEvent::Output, static_cast<u32>(datagram.size()), datagram);
+        }
+
+        void send(const u32 time, const size_t size) {
+            this->write(time, CaptureEvent::Send, static_cast<u32>(size), {});
+        }
+
+        void recv(const u32 time, const size_t size) {
+            this->write(time, CaptureEvent::Recv, static_cast<u32>(size), {});
+        }
+
+        /// Flushes and closes the file. Fails if any record couldn't be written.
+        [[nodiscard]] tl::expected<void, error> close() {
+            if (this->file == nullptr) {
+                return {};
+            }
+
+            const bool closed = std::fclose(this->file) == 0;
+            this->file = nullptr;
+
+            if (!closed || this->failed) {
+                return tl::unexpected(error::file_error);
+            }
+
+            return {};
+        }
+    };
+
+    /// Reads a file written by CaptureWriter on a host with the same byte order.
+    class CaptureReader final {
+        std::FILE* file = nullptr;
+        CaptureInfo info{};
+        std::vector<std::byte> buffer{};
+        bool malformed = false;
+
+        explicit CaptureReader(std::FILE* file, const CaptureInfo& info) : file(file), info(info) { }
+
+    public:
+        [[nodiscard]] static tl::expected<CaptureReader, error> open(const char* path) {
+            std::FILE* file = std::fopen(path, "rb");
+
+            if (file == nullptr) {
+                return tl::unexpected(error::file_error);
+            }
+
+            std::array<u32, 4> header{};
+
+            if (std::fread(header.data(), sizeof(header), 1, file) != 1 ||
+                header[0] != detail::CAPTURE_MAGIC ||
+                header[1] == 0 || header[1] > detail::CAPTURE_VERSION) {
+                std::fclose(file);
+                return tl::unexpected(error::malformed_payload);
+            }
+
+            return CaptureReader(file, CaptureInfo{ header[2], Conv{header[3]} });
+        }
+
+        CaptureReader(const CaptureReader&) = delete;
+        CaptureReader& operator=(const CaptureReader&) = delete;
+
+        CaptureReader(CaptureReader&& other) noexcept :
+            file(other.file), info(other.info), buffer(std::move(other.buffer)), malformed(other.malformed) {
+            other.file = nullptr;
+        }
+
+        CaptureReader& operator=(CaptureReader&&) = delete;
+
+        ~CaptureReader() {
+            if (this->file != nullptr) {
+                std::fclose(this->file);
+            }
+        }
+
+        [[nodiscard]] const CaptureInfo& get_info() const {
+            return this->info;
+        }
+
+        /// Returns true if reading stopped at a truncated or invalid record instead of the end of the file.
+        [[nodiscard]] bool is_malformed() const {
+            return this->malformed;
+        }
+
+        /// Seeks back to the first record.
+        void rewind() {
+            this->malformed = false;
+            std::fseek(this->file, sizeof(u32) * 4, SEEK_SET);
+        }
+
+        /// Reads the next record, std::nullopt at the end of the file.
+        [[nodiscard]] std::optional<CaptureRecord> next() {
+            std::array<std::byte, detail::CAPTURE_RECORD_HEADER_SIZE> header{};
+            const size_t read = std::fread(header.data(), 1, header.size(), this->file);
+
+            if (read != header.size()) {
+                this->malformed = read != 0;
+                return std::nullopt;
+            }
+
+            CaptureRecord record{};
+            std::memcpy(&record.time, header.data(), sizeof(record.time));
+            std::memcpy(&record.size, header.data() + 4, sizeof(record.size));
+            record.event = static_cast<CaptureEvent>(header[8]);
+
+            if (record.event > CaptureEvent::Flush) {
+                this->malformed = true;
+                return std::nullopt;
+            }
+
+            if (record.event == CaptureEvent::Input || record.event == CaptureEvent::Output) {
+                // Datagrams are bounded by what a socket can deliver, which also bounds the allocation
+                if (record.size > 0xffff) {
+                    this->malformed = true;
+                    return std::nullopt;
+                }
+
+                this->buffer.resize(record.size);
+
+                if (std::fread(this->buffer.data(), 1, record.size, this->file) != record.size) {
+                    this->malformed = true;
+                    return std::nullopt;
+                }
+
+                record.data = this->buffer;
+            }
+
+            return record;
+        }
+    };
+
+    struct ReplayResult final {
+        u64 updates = 0;
+        u64 flushes = 0;
+        u64 inputs = 0;
+        u64 sends = 0;
+        u64 recvs = 0;
+
+        /// Datagrams produced by the replay and by the captured connection.
+        u64 outputs = 0;
+        u64 captured_outputs = 0;
+
+        /// Replayed datagrams which differ from the captured ones (apart from message contents), 0 if the replay was faithful.
+        u64 mismatched_outputs = 0;
+    };
+
+    /**
+     *Feeds a capture into a fresh connection, calling update(), flush(), input(), send() and recv() in the captured order
+     *with the captured clock. Messages are replaced by zeros of the same size, which doesn't change the protocol's behaviour.
+     *The connection must be configured like the captured one for the output to match.
+     */
+    template <typename Kcp>
+    ReplayResult replay(CaptureReader& reader, Kcp& kcp) {
+        ReplayResult result{};
+
+        std::deque<std::vector<std::byte>> produced{};
+        std::vector<std::byte> message{};
+
+        const auto output = [&](const std::span<const std::byte> datagram) {
+            produced.emplace_back(datagram.begin(), datagram.end());
+            result.outputs++;
+        };
+
+        while (const std::optional<CaptureRecord> record = reader.next()) {
+            switch (record->event) {
+                case CaptureEvent::Update:
+                    kcp.update(record->time, output);
+                    result.updates++;
+                    break;
+                case CaptureEvent::Flush:
+                    kcp.flush(output);
+                    result.flushes++;
+                    break;
+                case CaptureEvent::Input:
+                    (void)kcp.input(record->data);
+                    result.inputs++;
+                    break;
+                case CaptureEvent::Output: {
+                    result.captured_outputs++;
+
+                    if (produced.empty()) {
+                        result.mismatched_outputs++;
+                        break;
+                    }
+
+                    const std::vector<std::byte>& datagram = produced.front();
+
+                    if (!detail::same_segments(datagram, record->data)) {
+                        result.mismatched_outputs++;
+                    }
+
+                    produced.pop_front();
+                    break;
+                }
+                case CaptureEvent::Send:
+                    message.assign(record->size, std::byte{0});
+                    (void)kcp.send(message);
+                    result.sends++;
+                    break;
+                case CaptureEvent::Recv:
+                    message.resize(record->size);
+                    (void)kcp.recv(message);
+                    result.recvs++;
+                    break;
+            }
+        }
+
+        result.mismatched_outputs += produced.size();
+
+        return result;
+    }
+}
@@ -7,8 +7,9 @@ namespace imkcpp::commands {
     constexpr Cmd ACK{82};
     constexpr Cmd WASK{83};
     constexpr Cmd WINS{84};
+    constexpr Cmd NACK{85}; // Not part of the original protocol, only sent if enabled explicitly
 
     static constexpr bool is_valid(const Cmd cmd) {
-        return cmd == PUSH || cmd == ACK || cmd == WASK || cmd == WINS;
+        return cmd == PUSH || cmd == ACK || cmd == WASK || cmd == WINS || cmd == NACK;
     }
 }
\ No newline at end of file
@@ -19,6 +19,14 @@ namespace imkcpp {
         u32 cwnd = 0; // Congestion Window
         u32 incr = 0; // Increment
 
+        // Values before the last reduction, restored if the retransmission turns out to be spurious
+
+        bool undo_available = false; // Whether there is a reduction which can be undone
+        u32 undo_sn = 0; // Reduction is final once everything sent before it (below this sn) is acknowledged
+        u32 prior_ssthresh = 0; // Slow Start Threshold before the reduction
+        u32 prior_cwnd = 0; // Congestion Window before the reduction
+        u32 prior_incr = 0; // Increment before the reduction
+
         // Probe is a part of flow control but it's deeply intertwined with congestion control so it's here
 
         u32 probe = 0; // Probe flags
@@ -58,6 +66,10 @@ namespace imkcpp {
             return this->snd_wnd;
         }
 
+        [[nodiscard]] u32 get_cwnd() const {
+            return this->cwnd;
+        }
+
         [[nodiscard]] u32 get_ssthresh() const {
             return this->ssthresh;
         }
@@ -75,6 +87,43 @@ namespace imkcpp {
             this->incr = MAX_SEGMENT_SIZE;
         }
 
+        /**
+         *Remembers current values before a reduction so that it can be undone.
+         *Only the values before the first reduction of a recovery episode are kept.
+         */
+        void save_undo_point(const u32 snd_nxt) {
+            if (this->undo_available) {
+                return;
+            }
+
+            this->undo_available = true;
+            this->undo_sn = snd_nxt;
+            this->prior_ssthresh = this->ssthresh;
+            this->prior_cwnd = this->cwnd;
+            this->prior_incr = this->incr;
+        }
+
+        /// Restores values saved before the reduction. Returns true if there was anything to undo.
+        bool undo() {
+            if (!this->undo_available) {
+                return false;
+            }
+
+            this->undo_available = false;
+            this->ssthresh = std::max(this->ssthresh, this->prior_ssthresh);
+            this->cwnd = std::max(this->cwnd, this->prior_cwnd);
+            this->incr = std::max(this->incr, this->prior_incr);
+
+            return true;
+        }
+
+        /// Ends the recovery episode once everything sent before the reduction has been acknowledged.
+        void una_advanced(const u32 snd_una) {
+            if (this->undo_available && snd_una >= this->undo_sn) {
+                this->undo_available = false;
+            }
+        }
+
         void adjust_parameters() {
             if (this->cwnd < this->rmt_wnd) {
                 if (this->cwnd < this->ssthresh) {
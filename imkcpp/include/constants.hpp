@@ -16,4 +16,6 @@ namespace imkcpp::constants {
     constexpr u32 IKCP_THRESH_INIT = 2;
     constexpr u32 IKCP_THRESH_MIN = 2;
     constexpr u32 IKCP_FASTACK_LIMIT = 5;		// max times to trigger fastack
+    constexpr u32 IKCP_NACK_DELAY = 20;		// how long a receive gap persists before it's reported
+    constexpr u32 IKCP_NACK_MAX_RANGES = 32;	// max missing ranges in a single nack
 }
\ No newline at end of file
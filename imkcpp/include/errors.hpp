@@ -15,6 +15,13 @@ namespace imkcpp {
         header_and_payload_length_mismatch = 8,
         unknown_command = 9,
         exceeds_window_size = 10,
+        malformed_payload = 11,
+        unknown_conv = 12,
+        conv_already_exists = 13,
+        socket_error = 14,
+        file_error = 15,
+        datagram_too_large = 16,
+        shm_error = 17,
     };
 
     inline std::string err_to_str(error e) {
@@ -41,6 +48,20 @@ namespace imkcpp {
                 return "unknown_command";
             case error::exceeds_window_size:
                 return "exceeds_window_size";
+            case error::malformed_payload:
+                return "malformed_payload";
+            case error::unknown_conv:
+                return "unknown_conv";
+            case error::conv_already_exists:
+                return "conv_already_exists";
+            case error::socket_error:
+                return "socket_error";
+            case error::file_error:
+                return "file_error";
+            case error::datagram_too_large:
+                return "datagram_too_large";
+            case error::shm_error:
+                return "shm_error";
             default:
                 return "unknown";
         }
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "third_party/expected.hpp"
+
+#include "types.hpp"
+#include "errors.hpp"
+#include "segment.hpp"
+#include "results.hpp"
+
+namespace imkcpp {
+    enum class FlightEvent : u8 {
+        /// A segment header was written to a datagram. a = ts, b = sn, c = una, d = len, e = wnd.
+        HeaderSent,
+
+        /// A segment header was accepted by input(). a = ts, b = sn, c = una, d = len, e = wnd.
+        HeaderReceived,
+
+        /// A flush finished. a = bytes sent, b = rto, c = srtt, d = cwnd, e = PUSH segments sent, f = retransmissions.
+        Flushed,
+
+        /// The connection reached State::DeadLink. a = snd_una, b = snd_nxt.
+        DeadLink,
+    };
+
+    /// Fixed size binary record of a FlightRecorder. The meaning of a to f depends on the event.
+    struct FlightRecord final {
+        u32 time = 0;
+        u32 conv = 0;
+        u32 a = 0;
+        u32 b = 0;
+        u32 c = 0;
+        u32 d = 0;
+        u16 e = 0;
+        u16 f = 0;
+        FlightEvent event = FlightEvent::HeaderSent;
+
+        /// Command and fragment of header events.
+        u8 cmd = 0;
+        u8 frg = 0;
+        u8 reserved = 0;
+    };
+
+    static_assert(sizeof(FlightRecord) == 32);
+
+    /// Records read back from a file written by FlightRecorder::dump(), oldest first.
+    struct FlightDump final {
+        std::vector<FlightRecord> records{};
+
+        /// Number of older records which had already been overwritten when the dump was taken.
+        u64 overwritten = 0;
+    };
+
+    /**
+     *FlightRecorder keeps the most recent protocol events in a fixed size ring, for post-mortem analysis.
+     *It can be attached to a single connection or shared by all connections driven by the same thread,
+     *see ImKcpp::set_flight_recorder(). Recording is a handful of plain stores and never allocates.
+     *
+     *The ring can be dumped by the writing thread at any time, and automatically when a connection reaches
+     *State::DeadLink if a path was set with set_dead_link_dump(). Dumping from another thread doesn't block the writer,
+     *but records written during the dump may be torn.
+     */
+    class FlightRecorder final {
+        constexpr static u32 FILE_MAGIC = 0x52464b49; // "IKFR" in little endian
+        constexpr static u16 FILE_VERSION = 1;
+
+        struct FileHeader final {
+            u32 magic = FILE_MAGIC;
+            u16 version = FILE_VERSION;
+            u16 record_size = sizeof(FlightRecord);
+            u64 count = 0;
+            u64 overwritten = 0;
+        };
+
+        std::unique_ptr<FlightRecord[]> records;
+        u64 mask;
+
+        /// Number of records written so far. Only the owning thread writes it, the release store makes records visible to dump().
+        std::atomic<u64> written{0};
+
+        std::string dead_link_path{};
+
+        FlightRecord& next() {
+            return this->records[this->written.load(std::memory_order_relaxed) & this->mask];
+        }
+
+        void commit() {
+            this->written.store(this->written.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        void header(const FlightEvent event, const u32 current, const SegmentHeader& header) {
+            FlightRecord& record = this->next();
+
+            record.time = current;
+            record.conv = header.conv.get();
+            record.a = header.ts;
+            record.b = header.sn;
+            record.c = header.una;
+            record.d = header.len.get();
+            record.e = header.wnd;
+            record.f = 0;
+            record.event = event;
+            record.cmd = header.cmd.get();
+            record.frg = header.frg.get();
+
+            this->commit();
+        }
+
+    public:
+        /// Creates a recorder keeping the last capacity records, rounded up to a power of two.
+        explicit FlightRecorder(const size_t capacity) :
+            records(std::make_unique<FlightRecord[]>(std::bit_ceil(std::max<size_t>(capacity, 1)))),
+            mask(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1) { }
+
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        void header_sent(const u32 current, const SegmentHeader& header) {
+            this->header(FlightEvent::HeaderSent, current, header);
+        }
+
+        void header_received(const u32 current, const SegmentHeader& header) {
+            this->header(FlightEvent::HeaderReceived, current, header);
+        }
+
+        void flushed(const u32 current, const Conv conv, const FlushResult& result, const u32 rto, const u32 srtt, const u32 cwnd) {
+            const u32 retransmitted = result.timeout_retransmitted_count + result.fast_retransmitted_count +
+                                      result.nack_retransmitted_count + result.tail_loss_probe_count;
+
+            FlightRecord& record = this->next();
+
+            record = FlightRecord{};
+            record.time = current;
+            record.conv = conv.get();
+            record.a = static_cast<u32>(result.total_bytes_sent);
+            record.b = rto;
+            record.c = srtt;
+            record.d = cwnd;
+            record.e = static_cast<u16>(std::min<u32>(result.cmd_push_count, 0xffff));
+            record.f = static_cast<u16>(std::min<u32>(retransmitted, 0xffff));
+            record.event = FlightEvent::Flushed;
+
+            this->commit();
+        }
+
+        /// Records that a connection died and dumps the ring if a path was set with set_dead_link_dump().
+        void dead_link(const u32 current, const Conv conv, const u32 snd_una, const u32 snd_nxt) {
+            FlightRecord& record = this->next();
+
+            record = FlightRecord{};
+            record.time = current;
+            record.conv = conv.get();
+            record.a = snd_una;
+            record.b = snd_nxt;
+            record.event = FlightEvent::DeadLink;
+
+            this->commit();
+
+            if (!this->dead_link_path.empty()) {
+                (void)this->dump(this->dead_link_path.c_str());
+            }
+        }
+
+        /// Sets the file the ring is written to when a connection reaches State::DeadLink. Empty disables it.
+        void set_dead_link_dump(std::string path) {
+            this->dead_link_path = std::move(path);
+        }
+
+        /// Returns the number of records the ring keeps.
+        [[nodiscard]] size_t capacity() const {
+            return static_cast<size_t>(this->mask + 1);
+        }
+
+        /// Returns the number of records written since the recorder was created.
+        [[nodiscard]] u64 get_written() const {
+            return this->written.load(std::memory_order_acquire);
+        }
+
+        /// Calls the function for every retained record, oldest first.
+        template <typename F>
+        void for_each(F&& fn) const {
+            const u64 end = this->written.load(std::memory_order_acquire);
+            const u64 first = end > this->capacity() ? end - this->capacity() : 0;
+
+            for (u64 i = first; i < end; ++i) {
+                fn(this->records[i & this->mask]);
+            }
+        }
+
+        /// Writes the retained records to a file, see load(). Records are stored in the host's byte order.
+        [[nodiscard]] tl::expected<void, error> dump(const char* path) const {
+            std::FILE* file = std::fopen(path, "wb");
+
+            if (file == nullptr) {
+                return tl::unexpected(error::file_error);
+            }
+
+            const u64 end = this->written.load(std::memory_order_acquire);
+
+            FileHeader header{};
+            header.count = std::min<u64>(end, this->capacity());
+            header.overwritten = end - header.count;
+
+            bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+            // The ring is written in at most two contiguous parts
+            const u64 first = header.overwritten & this->mask;
+            const u64 head = std::min<u64>(header.count, this->capacity() - first);
+
+            ok = ok && std::fwrite(&this->records[first], sizeof(FlightRecord), head, file) == head;
+            ok = ok && std::fwrite(&this->records[0], sizeof(FlightRecord), header.count - head, file) == header.count - head;
+            ok = std::fclose(file) == 0 && ok;
+
+            if (!ok) {
+                return tl::unexpected(error::file_error);
+            }
+
+            return {};
+        }
+
+        /// Reads a file written by dump() on a host with the same byte order.
+        [[nodiscard]] static tl::expected<FlightDump, error> load(const char* path) {
+            std::FILE* file = std::fopen(path, "rb");
+
+            if (file == nullptr) {
+                return tl::unexpected(error::file_error);
+            }
+
+            FileHeader header{};
+            FlightDump result{};
+
+            bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                      header.magic == FILE_MAGIC &&
+                      header.version == FILE_VERSION &&
+                      header.record_size == sizeof(FlightRecord);
+
+            // Checks the count against the file size before allocating
+            if (ok) {
+                const long start = std::ftell(file);
+                ok = std::fseek(file, 0, SEEK_END) == 0 &&
+                     static_cast<u64>(std::ftell(file) - start) == header.count * sizeof(FlightRecord) &&
+                     std::fseek(file, start, SEEK_SET) == 0;
+            }
+
+            if (ok) {
+                result.records.resize(header.count);
+                result.overwritten = header.overwritten;
+                ok = std::fread(result.records.data(), sizeof(FlightRecord), header.count, file) == header.count;
+            }
+
+            std::fclose(file);
+
+            if (!ok) {
+                return tl::unexpected(error::malformed_payload);
+            }
+
+            return result;
+        }
+    };
+}
@@ -5,6 +5,9 @@
 #include "types.hpp"
 #include "segment.hpp"
 #include "utility.hpp"
+#include "profiling.hpp"
+#include "flight_recorder.hpp"
+#include "capture.hpp"
 
 namespace imkcpp {
     /// Flusher is used to flush the buffer to the given output if it exceeds Max Segment Size or if it's not empty.
@@ -15,12 +18,21 @@ namespace imkcpp {
         std::array<std::byte, MTU> buffer{};
         size_t offset = 0;
 
+        FlightRecorder* recorder = nullptr;
+        CaptureWriter* capture = nullptr;
+        u32 current = 0;
+
         /// Flushes the buffer to the given output
         [[nodiscard]] size_t flush(const output_callback_t& callback) {
             const auto size = this->offset;
 
             assert(size <= this->buffer.size());
 
+            if (this->capture != nullptr) {
+                this->capture->output(this->current, {this->buffer.data(), size});
+            }
+
+            IMKCPP_PROFILE_SCOPE(OutputCallback);
             callback({this->buffer.data(), size});
             this->offset = 0;
 
@@ -62,15 +74,40 @@ namespace imkcpp {
 
         /// Emplaces the given segment header into the buffer
         void emplace(const SegmentHeader& header) {
+            IMKCPP_PROFILE_SCOPE(FlusherSerialize);
             serializer::serialize(header, this->buffer, this->offset);
+
+            if (this->recorder != nullptr) {
+                this->recorder->header_sent(this->current, header);
+            }
         }
 
         /// Emplaces the given segment into the buffer
         void emplace(const SegmentHeader& header, const SegmentData& data) {
             assert(this->offset + serializer::dynamic_size(data) <= this->buffer.size());
+            IMKCPP_PROFILE_SCOPE(FlusherSerialize);
 
             serializer::serialize(header, this->buffer, this->offset);
             data.encode_to(this->buffer, this->offset, header.len.get());
+
+            if (this->recorder != nullptr) {
+                this->recorder->header_sent(this->current, header);
+            }
+        }
+
+        /// Sets the recorder which receives every emplaced header, nullptr disables recording.
+        void set_flight_recorder(FlightRecorder* value) {
+            this->recorder = value;
+        }
+
+        /// Sets the capture which receives every flushed datagram, nullptr disables capturing.
+        void set_capture(CaptureWriter* value) {
+            this->capture = value;
+        }
+
+        /// Sets the time recorded for the headers and datagrams of the current flush.
+        void set_current(const u32 value) {
+            this->current = value;
         }
     };
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <optional>
 #include <cstddef>
 #include <limits>
+#include <type_traits>
+#include <memory>
 #include "third_party/expected.hpp"
 
 #include "types.hpp"
@@ -16,6 +18,9 @@
 #include "rto_calculator.hpp"
 #include "congestion_controller.hpp"
 #include "window_prober.hpp"
+#include "tail_loss_prober.hpp"
+#include "loss_detector.hpp"
+#include "nack_controller.hpp"
 #include "shared_ctx.hpp"
 #include "receiver.hpp"
 #include "sender_buffer.hpp"
@@ -24,10 +29,20 @@
 #include "flusher.hpp"
 #include "utility.hpp"
 #include "commands.hpp"
+#include "stats.hpp"
+#include "seqlock.hpp"
+#include "tracing.hpp"
+#include "profiling.hpp"
+#include "latency.hpp"
+#include "flight_recorder.hpp"
+#include "capture.hpp"
 
 namespace imkcpp {
-    /// The main class of the library.
-    template <size_t MTU>
+    /**
+     *The main class of the library.
+     *Tracer observes protocol events (see tracing.hpp). The default NoopTracer compiles away completely.
+     */
+    template <size_t MTU, TracerPolicy Tracer = NoopTracer>
     class ImKcpp final {
         static_assert(MTU > serializer::fixed_size<SegmentHeader>(), "MTU is too small");
 
@@ -39,16 +54,86 @@ namespace imkcpp {
         RtoCalculator rto_calculator{};
         CongestionController<MTU> congestion_controller{};
         WindowProber window_prober{};
+        TailLossProber tail_loss_prober{};
+        LossDetector loss_detector{};
+        NackController nack_controller{};
         Receiver receiver{};
 
         SenderBuffer sender_buffer{};
         AckController ack_controller{sender_buffer, segment_tracker};
-        Sender<MTU> sender{shared_ctx, congestion_controller, rto_calculator, flusher, sender_buffer, segment_tracker};
+        Sender<MTU> sender{shared_ctx, congestion_controller, rto_calculator, flusher, sender_buffer, segment_tracker, tail_loss_prober, loss_detector};
 
         bool updated = false; // Whether update() was called at least once
         u32 current = 0; // Current / last time we updated the state
         u32 ts_flush = constants::IKCP_INTERVAL; // Time when we will probably flush the data next time
 
+        Stats stats{}; // Cumulative counters, published after every flush
+        StatsEstimator stats_estimator{};
+        SeqLock<Stats> published_stats{};
+        size_t buffered_segments = 0; // Segments in the send buffer after the last flush
+        size_t buffered_bytes = 0; // Payload bytes in the send buffer after the last flush
+
+        std::unique_ptr<MessageLatency> latency{}; // Only allocated once enabled, as it's a few KiB
+        FlightRecorder* flight_recorder = nullptr; // Not owned, may be shared by connections on the same thread
+        CaptureWriter* capture = nullptr; // Not owned
+
+        struct TracedCongestion final {
+            u32 cwnd = 0;
+            u32 ssthresh = 0;
+        };
+
+        struct Untraced final { };
+
+        [[no_unique_address]] Tracer tracer{};
+
+        // Last congestion state reported to the tracer, only kept when tracing
+        [[no_unique_address]] std::conditional_t<Tracer::enabled, TracedCongestion, Untraced> traced_congestion{};
+
+        // Reports congestion state changes made by the last input() or flush().
+        auto trace_congestion() noexcept -> void {
+            if constexpr (Tracer::enabled) {
+                const u32 cwnd = this->congestion_controller.get_cwnd();
+                const u32 ssthresh = this->congestion_controller.get_ssthresh();
+
+                if (cwnd != this->traced_congestion.cwnd || ssthresh != this->traced_congestion.ssthresh) {
+                    this->traced_congestion = TracedCongestion{ cwnd, ssthresh };
+                    this->tracer.cwnd_changed(this->current, cwnd, ssthresh);
+                }
+            }
+        }
+
+        // Accumulates the flush counters and publishes a snapshot for get_stats().
+        auto publish_stats(const FlushResult& flush_result) noexcept -> void {
+            Stats& s = this->stats;
+
+            s.timestamp = this->current;
+            s.bytes_sent += flush_result.total_bytes_sent;
+            s.segments_sent += flush_result.cmd_push_count;
+            s.timeout_retransmitted += flush_result.timeout_retransmitted_count;
+            s.fast_retransmitted += flush_result.fast_retransmitted_count;
+            s.nack_retransmitted += flush_result.nack_retransmitted_count;
+            s.tail_loss_probes += flush_result.tail_loss_probe_count;
+
+            s.srtt = this->rto_calculator.get_srtt();
+            s.rttvar = this->rto_calculator.get_rttvar();
+            s.rto = this->rto_calculator.get_rto();
+            s.cwnd = this->congestion_controller.get_cwnd();
+            s.ssthresh = this->congestion_controller.get_ssthresh();
+            s.send_window = this->congestion_controller.get_send_window();
+            s.remote_window = this->congestion_controller.get_remote_window();
+            s.receive_window = this->congestion_controller.get_receive_window();
+            s.inflight = static_cast<u32>(this->sender_buffer.size());
+            s.send_queue = static_cast<u32>(this->sender.get_queue_size());
+            s.receive_buffer = static_cast<u32>(this->receiver.get_buffer_size());
+            s.receive_queue = static_cast<u32>(this->receiver.size());
+
+            this->buffered_segments = this->sender_buffer.size();
+            this->buffered_bytes = this->sender_buffer.get_payload_bytes();
+
+            this->stats_estimator.update(s);
+            this->published_stats.store(s);
+        }
+
         // Creates a new service header for non-data packets.
         [[nodiscard]] auto create_service_header(const i32 unused_receive_window) const noexcept -> SegmentHeader {
             SegmentHeader header;
@@ -65,6 +150,130 @@ namespace imkcpp {
             return header;
         }
 
+        // Flushes acks, window probes and data segments. Used by update() and flush(), which record their call to the capture.
+        auto flush_all(const output_callback_t& callback) noexcept -> FlushResult {
+            FlushResult flush_result{};
+
+            if (!this->updated) {
+                return flush_result;
+            }
+
+            const u32 current = this->current;
+            const State state = this->shared_ctx.get_state();
+            this->flusher.set_current(current);
+
+            const i32 unused_receive_window = std::max(static_cast<i32>(this->congestion_controller.get_receive_window()) - static_cast<i32>(this->receiver.size()), 0);
+
+            SegmentHeader header = this->create_service_header(unused_receive_window);
+
+            const auto flush_acks = [&] {
+                for (const Ack& ack : this->ack_controller) {
+                    flush_result.total_bytes_sent += this->flusher.flush_if_full(callback);
+
+                    header.sn = ack.sn;
+                    header.ts = ack.ts;
+
+                    this->flusher.emplace(header);
+                }
+
+                flush_result.cmd_ack_count += this->ack_controller.size();
+                this->ack_controller.clear();
+            };
+
+            const auto flush_nacks = [&] {
+                if (!this->nack_controller.should_send(current)) {
+                    return;
+                }
+
+                const SegmentData& payload = this->nack_controller.prepare(this->receiver, current, MAX_SEGMENT_SIZE);
+
+                if (payload.dynamic_size() == 0) {
+                    return;
+                }
+
+                flush_result.total_bytes_sent += this->flusher.flush_if_does_not_fit(callback, payload.dynamic_size());
+
+                header.cmd = commands::NACK;
+                header.len = PayloadLen(payload.dynamic_size());
+                this->flusher.emplace(header, payload);
+
+                header.len = PayloadLen(0);
+
+                flush_result.cmd_nack_count++;
+            };
+
+            const auto flush_probes = [&] {
+                this->window_prober.update(current, this->congestion_controller.get_remote_window());
+
+                if (this->window_prober.has_flag(ProbeFlag::AskSend)) {
+                    flush_result.total_bytes_sent += this->flusher.flush_if_full(callback);
+
+                    header.cmd = commands::WASK;
+                    this->flusher.emplace(header);
+
+                    flush_result.cmd_wask_count++;
+
+                    if constexpr (Tracer::enabled) {
+                        this->tracer.window_probe(current, commands::WASK, 1);
+                    }
+                }
+
+                if (this->window_prober.has_flag(ProbeFlag::AskTell)) {
+                    flush_result.total_bytes_sent +=this->flusher.flush_if_full(callback);
+
+                    header.cmd = commands::WINS;
+                    this->flusher.emplace(header);
+
+                    flush_result.cmd_wins_count++;
+
+                    if constexpr (Tracer::enabled) {
+                        this->tracer.window_probe(current, commands::WINS, 1);
+                    }
+                }
+
+                this->window_prober.reset_flags();
+            };
+
+            // Acks
+            flush_acks();
+
+            // Missing segments
+            flush_nacks();
+
+            // Window probes
+            flush_probes();
+
+            // Whatever left the send buffer since the last flush has been acknowledged
+            this->stats.segments_acked += this->buffered_segments - this->sender_buffer.size();
+            this->stats.bytes_acked += this->buffered_bytes - this->sender_buffer.get_payload_bytes();
+
+            // Useful data
+            const u32 rcv_nxt = this->receiver.get_rcv_nxt();
+            this->sender.flush_data_segments(flush_result, callback, current, unused_receive_window, rcv_nxt, this->tracer);
+
+            // Flush remaining
+            flush_result.total_bytes_sent += this->flusher.flush_if_not_empty(callback);
+
+            this->congestion_controller.ensure_at_least_one_packet_in_flight();
+
+            this->trace_congestion();
+            this->publish_stats(flush_result);
+
+            if (this->flight_recorder != nullptr) {
+                const Conv conv = this->shared_ctx.get_conv();
+
+                if (flush_result.total_bytes_sent > 0) {
+                    this->flight_recorder->flushed(current, conv, flush_result, this->rto_calculator.get_rto(), this->rto_calculator.get_srtt(), this->congestion_controller.get_cwnd());
+                }
+
+                if (state != State::DeadLink && this->shared_ctx.get_state() == State::DeadLink) {
+                    this->flight_recorder->dead_link(current, conv, this->segment_tracker.get_snd_una(), this->segment_tracker.get_snd_nxt());
+                }
+            }
+
+            return flush_result;
+        }
+
     public:
         explicit ImKcpp(const Conv conv) noexcept {
             this->shared_ctx.set_conv(conv);
@@ -116,22 +325,69 @@ namespace imkcpp {
             this->congestion_controller.set_congestion_window_enabled(state);
         }
 
+        /// Enables or disables tail loss probes. When enabled, the last segment in flight is retransmitted
+        /// after about 2 * SRTT without ack progress instead of waiting for the RTO.
+        auto set_tail_loss_probe_enabled(const bool state) noexcept -> void {
+            this->tail_loss_prober.set_enabled(state);
+        }
+
+        /// Enables or disables time-based loss detection (RACK). When enabled, a segment is retransmitted
+        /// once a segment sent after it has been acknowledged and RTT + reordering window has passed,
+        /// regardless of the fastresend threshold.
+        auto set_rack_enabled(const bool state) noexcept -> void {
+            this->loss_detector.set_enabled(state);
+        }
+
+        /**
+         *Enables or disables sending NACK commands. When enabled, the receiver reports missing sequence numbers
+         *once a gap persists for the NACK delay, and the sender retransmits them immediately.
+         *NACK is not part of the original protocol, so both sides must be imkcpp. Received NACKs are always handled.
+         */
+        auto set_nack_enabled(const bool state) noexcept -> void {
+            this->nack_controller.set_enabled(state);
+        }
+
+        /// Sets how long a gap in the receive buffer has to persist before it's reported with a NACK.
+        auto set_nack_delay(const u32 delay) noexcept -> void {
+            this->nack_controller.set_delay(delay);
+        }
+
         /// Sets maximum retransmission count for a single segment until it's considered lost.
         auto set_deadlink(const u32 threshold) noexcept -> void {
             this->sender.set_deadlink(threshold);
         }
 
-        /// Receives data from the transport layer.
+        /**
+         *Receives data from the transport layer.
+         *
+         *The work done for a single datagram is bounded regardless of what the peer sends:
+         *datagrams larger than the MTU are rejected, so there are at most MTU / 24 headers to process,
+         *each PUSH is placed in the receive buffer by its sequence number in O(1) and each ACK locates its segment with
+         *a binary search over the send buffer,
+         *UNA removes every segment at most once, only the first IKCP_NACK_MAX_RANGES NACK ranges are applied,
+         *and fast acks are counted once per datagram in a single pass over the send buffer.
+         */
         auto input(const std::span<const std::byte> data) noexcept -> tl::expected<InputResult, error> {
+            if (this->capture != nullptr) {
+                this->capture->input(this->current, data);
+            }
+
             if (data.size() < serializer::fixed_size<SegmentHeader>()) {
                 return tl::unexpected(error::less_than_header_size);
             }
 
+            if (data.size() > MTU) {
+                return tl::unexpected(error::datagram_too_large);
+            }
+
             InputResult input_result{};
 
             const u32 prev_una = this->segment_tracker.get_snd_una();
             FastAckCtx fastack_ctx{};
 
+            // NACK ranges applied so far, a peer never needs more than one NACK's worth per datagram
+            u32 nack_ranges = 0;
+
             SegmentHeader header;
             size_t offset = 0;
 
@@ -147,25 +403,34 @@ namespace imkcpp {
                     break;
                 }
 
-                serializer::deserialize(header, data, offset);
+                {
+                    IMKCPP_PROFILE_SCOPE(HeaderDecode);
 
-                if (header.conv != this->shared_ctx.get_conv()) {
-                    return tl::unexpected(error::conv_mismatch);
-                }
+                    serializer::deserialize(header, data, offset);
 
-                if (header.len > data.size() - offset) {
-                    return tl::unexpected(error::header_and_payload_length_mismatch);
+                    if (header.conv != this->shared_ctx.get_conv()) {
+                        return tl::unexpected(error::conv_mismatch);
+                    }
+
+                    if (header.len > data.size() - offset) {
+                        return tl::unexpected(error::header_and_payload_length_mismatch);
+                    }
+
+                    if (!commands::is_valid(header.cmd)) {
+                        return tl::unexpected(error::unknown_command);
+                    }
                 }
 
-                if (!commands::is_valid(header.cmd)) {
-                    return tl::unexpected(error::unknown_command);
+                if (this->flight_recorder != nullptr) {
+                    this->flight_recorder->header_received(this->current, header);
                 }
 
                 this->congestion_controller.set_remote_window(header.wnd);
-                this->ack_controller.una_received(header.una);
 
                 switch (header.cmd.get()) {
                     case commands::PUSH.get(): {
+                        input_result.cmd_push_count++;
+
                         if (!this->congestion_controller.fits_receive_window(this->receiver.get_rcv_nxt(), header.sn)) {
                             drop_push();
                             break;
@@ -174,52 +439,122 @@ namespace imkcpp {
                         this->ack_controller.schedule_ack(header.sn, header.ts);
 
                         if (this->receiver.should_receive(header.sn)) {
+                            IMKCPP_PROFILE_SCOPE(ReceiveInsert);
+
                             SegmentData segment_data;
                             segment_data.decode_from(data, offset, header.len.get());
 
-                            this->receiver.emplace_segment(header, segment_data);
+                            this->receiver.emplace_segment(header, segment_data, this->current);
                         } else {
                             drop_push();
                         }
                         break;
                     }
                     case commands::ACK.get(): {
+                        IMKCPP_PROFILE_SCOPE(AckApply);
+
                         this->rto_calculator.update_rto(this->current, header.ts);
-                        this->ack_controller.ack_received(header.sn);
+
+                        if (const auto acked = this->ack_controller.ack_received(header.sn, this->current, this->tracer); acked.has_value()) {
+                            this->tail_loss_prober.ack_progress(this->current);
+                            this->loss_detector.ack_received(this->current, header.sn, header.ts);
+
+                            // The ack echoes a transmission older than the latest one, meaning the original
+                            // has been delivered and the retransmission was not needed (Eifel detection).
+                            // A tail loss probe is sent before any loss is assumed, so it never undoes congestion state.
+                            if (!acked->probe_only && time_delta(acked->header.ts, header.ts) > 0) {
+                                this->rto_calculator.spurious_retransmission(this->current, header.ts);
+                                this->congestion_controller.undo();
+                                input_result.spurious_retransmitted_count++;
+                            }
+                        }
+
                         fastack_ctx.update(header.sn, header.ts);
                         input_result.cmd_ack_count++;
                         break;
                     }
+                    case commands::NACK.get(): {
+                        if (header.len.get() % serializer::fixed_size<NackRange>() != 0) {
+                            return tl::unexpected(error::malformed_payload);
+                        }
+
+                        // Segments sent within the last SRTT may still be on their way, don't resend them again
+                        const u32 sent_before = this->current - this->rto_calculator.get_srtt();
+                        const size_t end = offset + header.len.get();
+
+                        NackRange range;
+                        while (offset < end) {
+                            serializer::deserialize(range, data, offset);
+
+                            if (nack_ranges++ < constants::IKCP_NACK_MAX_RANGES) {
+                                this->ack_controller.nack_received(range.sn, range.count, sent_before);
+                            }
+                        }
+
+                        input_result.cmd_nack_count++;
+                        break;
+                    }
                     case commands::WASK.get(): {
                         this->window_prober.set_flag(ProbeFlag::AskTell);
                         input_result.cmd_wask_count++;
+
+                        if constexpr (Tracer::enabled) {
+                            this->tracer.window_probe(this->current, commands::WASK, 0);
+                        }
                         break;
                     }
                     case commands::WINS.get(): {
                         input_result.cmd_wins_count++;
+
+                        if constexpr (Tracer::enabled) {
+                            this->tracer.window_probe(this->current, commands::WINS, 0);
+                        }
                         break;
                     }
                     default: {
                         return tl::unexpected(error::unknown_command);
                     }
                 }
+
+                // Una is applied after the command so that an ack still sees the segment it acknowledges.
+                IMKCPP_PROFILE_SCOPE(AckApply);
+                this->ack_controller.una_received(header.una, this->current, this->tracer);
             }
 
-            this->ack_controller.acknowledge_fastack(fastack_ctx);
+            {
+                IMKCPP_PROFILE_SCOPE(AckApply);
+                this->ack_controller.acknowledge_fastack(fastack_ctx);
+            }
+            this->nack_controller.update(this->receiver.has_gaps(), this->current);
 
             if (this->segment_tracker.get_snd_una() > prev_una) {
+                this->congestion_controller.una_advanced(this->segment_tracker.get_snd_una());
                 this->congestion_controller.adjust_parameters();
+                this->tail_loss_prober.ack_progress(this->current);
             }
 
             input_result.total_bytes_received = offset;
 
+            this->trace_congestion();
+
+            this->stats.bytes_received += input_result.total_bytes_received;
+            this->stats.segments_received += input_result.cmd_push_count;
+            this->stats.segments_dropped += input_result.dropped_push_count;
+            this->stats.spurious_retransmitted += input_result.spurious_retransmitted_count;
+
             return input_result;
         }
 
         /// Reads data from the receive queue.
         auto recv(const std::span<std::byte> buffer) noexcept -> tl::expected<size_t, error> {
+            IMKCPP_PROFILE_SCOPE(RecvCopy);
+
+            if (this->capture != nullptr) {
+                this->capture->recv(this->current, buffer.size());
+            }
+
             const auto rcv_wnd = this->congestion_controller.get_receive_window();
-            const auto result = this->receiver.recv(buffer, rcv_wnd);
+            const auto result = this->receiver.recv(buffer, rcv_wnd, this->current);
 
             if (result.has_value()) {
                 const auto& result_value = result.value();
@@ -236,7 +571,13 @@ namespace imkcpp {
 
         /// Sends data.
         auto send(const std::span<const std::byte> buffer) noexcept -> tl::expected<size_t, error> {
-            return this->sender.send(buffer);
+            IMKCPP_PROFILE_SCOPE(SendSegmentation);
+
+            if (this->capture != nullptr) {
+                this->capture->send(this->current, buffer.size());
+            }
+
+            return this->sender.send(buffer, this->current);
         }
 
         /// Checks when the next update() should be called.
@@ -271,6 +612,10 @@ namespace imkcpp {
         auto update(const u32 current, const output_callback_t& callback) noexcept -> FlushResult {
             this->current = current;
 
+            if (this->capture != nullptr) {
+                this->capture->update(current);
+            }
+
             if (!this->updated) {
                 this->updated = true;
                 this->ts_flush = this->current;
@@ -291,7 +636,7 @@ namespace imkcpp {
                     this->ts_flush = this->current + interval;
                 }
 
-                return this->flush(callback);
+                return this->flush_all(callback);
             }
 
             return {};
@@ -299,71 +644,63 @@ namespace imkcpp {
 
         /// Flushes the data to the output callback.
         auto flush(const output_callback_t& callback) noexcept -> FlushResult {
-            FlushResult flush_result{};
-
-            if (!this->updated) {
-                return flush_result;
+            if (this->capture != nullptr) {
+                this->capture->flush(this->current);
             }
 
-            const u32 current = this->current;
-            const i32 unused_receive_window = std::max(static_cast<i32>(this->congestion_controller.get_receive_window()) - static_cast<i32>(this->receiver.size()), 0);
-
-            SegmentHeader header = this->create_service_header(unused_receive_window);
-
-            const auto flush_acks = [&] {
-                for (const Ack& ack : this->ack_controller) {
-                    flush_result.total_bytes_sent += this->flusher.flush_if_full(callback);
-
-                    header.sn = ack.sn;
-                    header.ts = ack.ts;
-
-                    this->flusher.emplace(header);
-                }
-
-                flush_result.cmd_ack_count += this->ack_controller.size();
-                this->ack_controller.clear();
-            };
-
-            const auto flush_probes = [&] {
-                this->window_prober.update(current, this->congestion_controller.get_remote_window());
-
-                if (this->window_prober.has_flag(ProbeFlag::AskSend)) {
-                    flush_result.total_bytes_sent += this->flusher.flush_if_full(callback);
-
-                    header.cmd = commands::WASK;
-                    this->flusher.emplace(header);
-
-                    flush_result.cmd_wask_count++;
-                }
-
-                if (this->window_prober.has_flag(ProbeFlag::AskTell)) {
-                    flush_result.total_bytes_sent +=this->flusher.flush_if_full(callback);
-
-                    header.cmd = commands::WINS;
-                    this->flusher.emplace(header);
+            return this->flush_all(callback);
+        }
 
-                    flush_result.cmd_wins_count++;
-                }
+        /**
+         *Returns counters and state as of the last flush. Safe to call from any thread while the connection
+         *is being used, e.g. by a monitoring thread. The snapshot is published without locking (see SeqLock).
+         */
+        [[nodiscard]] auto get_stats() const noexcept -> Stats {
+            return this->published_stats.load();
+        }
 
-                this->window_prober.reset_flags();
-            };
+        /**
+         *Starts recording per message latency histograms, see MessageLatency.
+         *Stages which messages complete from now on are recorded.
+         */
+        auto enable_latency_histograms() noexcept -> void {
+            if (this->latency != nullptr) {
+                return;
+            }
 
-            // Acks
-            flush_acks();
+            this->latency = std::make_unique<MessageLatency>();
 
-            // Window probes
-            flush_probes();
+            this->sender.set_latency(this->latency.get());
+            this->sender_buffer.set_latency(this->latency.get());
+            this->receiver.set_latency(this->latency.get());
+        }
 
-            // Useful data
-            const u32 rcv_nxt = this->receiver.get_rcv_nxt();
-            this->sender.flush_data_segments(flush_result, callback, current, unused_receive_window, rcv_nxt);
+        /// Gets a snapshot of the latency histograms, empty if they were not enabled. Snapshots can be merged with +=.
+        [[nodiscard]] auto get_latency() const noexcept -> MessageLatency {
+            return this->latency != nullptr ? *this->latency : MessageLatency{};
+        }
 
-            // Flush remaining
-            flush_result.total_bytes_sent += this->flusher.flush_if_not_empty(callback);
+        /**
+         *Attaches a flight recorder, which records headers sent and received, flushes which sent something
+         *and the transition to State::DeadLink. The recorder must outlive the connection or be detached with nullptr.
+         */
+        auto set_flight_recorder(FlightRecorder* recorder) noexcept -> void {
+            this->flight_recorder = recorder;
+            this->flusher.set_flight_recorder(recorder);
+        }
 
-            this->congestion_controller.ensure_at_least_one_packet_in_flight();
+        /**
+         *Attaches a capture, which records every call to update(), flush(), input(), send() and recv() and every output datagram
+         *so the session can be replayed offline, see replay(). The capture must outlive the connection or be detached with nullptr.
+         */
+        auto set_capture(CaptureWriter* writer) noexcept -> void {
+            this->capture = writer;
+            this->flusher.set_capture(writer);
+        }
 
-            return flush_result;
+        /// Gets the tracer, e.g. to read the recorded events.
+        [[nodiscard]] auto get_tracer() noexcept -> Tracer& {
+            return this->tracer;
         }
 
         /// Gets the current state.
@@ -371,6 +708,31 @@ namespace imkcpp {
             return this->shared_ctx.get_state();
         }
 
+        /// Gets the conversation id.
+        [[nodiscard]] auto get_conv() const noexcept -> Conv {
+            return this->shared_ctx.get_conv();
+        }
+
+        /**
+         *Returns true if update() has nothing to do until new data is sent, received or read.
+         *Idle connections don't need to be updated until then, which is used by the session manager to park them.
+         */
+        [[nodiscard]] auto is_idle() const noexcept -> bool {
+            return this->updated &&
+                   this->sender.get_queue_size() == 0 &&
+                   this->sender_buffer.empty() &&
+                   this->ack_controller.empty() &&
+                   !this->receiver.has_gaps() &&
+                   !this->window_prober.has_flag(ProbeFlag::AskSend) &&
+                   !this->window_prober.has_flag(ProbeFlag::AskTell) &&
+                   this->congestion_controller.get_remote_window() != 0;
+        }
+
+        /// Gets the number of segments which are queued or in flight, i.e. not yet acknowledged.
+        [[nodiscard]] auto get_waiting_send_count() const noexcept -> size_t {
+            return this->sender.get_queue_size() + this->sender_buffer.size();
+        }
+
         /// Gets bytes count of the available data in the receive queue.
         [[nodiscard]] auto peek_size() const noexcept -> tl::expected<size_t, error> {
             return this->receiver.peek_size();
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+
+#include "types.hpp"
+
+namespace imkcpp {
+    /**
+     *Log-linear histogram of latencies in milliseconds, in the spirit of HdrHistogram.
+     *Every power of two range is split into SUB_BUCKETS linear buckets, so recorded values are
+     *exact below SUB_BUCKETS * 2 and keep a relative error below 1 / SUB_BUCKETS above.
+     *Recording is a few bit operations and an increment, histograms of different connections can be merged with +=.
+     */
+    class LatencyHistogram final {
+        constexpr static u32 SUB_BUCKET_BITS = 4;
+        constexpr static u32 SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+
+        /// Values are clamped below 2^MAX_VALUE_BITS ms, about 4.6 hours.
+        constexpr static u32 MAX_VALUE_BITS = 24;
+        constexpr static u32 MAX_VALUE = (1u << MAX_VALUE_BITS) - 1;
+
+        constexpr static size_t BUCKETS = SUB_BUCKETS * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+        std::array<u64, BUCKETS> counts{};
+        u64 count = 0;
+        u64 sum = 0;
+        u32 min = std::numeric_limits<u32>::max();
+        u32 max = 0;
+
+        [[nodiscard]] constexpr static size_t index_of(const u32 value) {
+            if (value < SUB_BUCKETS) {
+                return value;
+            }
+
+            // Shifts the value so that it lands in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+            const u32 shift = static_cast<u32>(std::bit_width(value)) - SUB_BUCKET_BITS - 1;
+            return shift * SUB_BUCKETS + (value >> shift);
+        }
+
+        /// Returns the highest value which falls into the given bucket.
+        [[nodiscard]] constexpr static u32 highest_equivalent(const size_t index) {
+            if (index < SUB_BUCKETS * 2) {
+                return static_cast<u32>(index);
+            }
+
+            const u32 shift = static_cast<u32>(index / SUB_BUCKETS) - 1;
+            const u32 lowest = static_cast<u32>(index - shift * SUB_BUCKETS) << shift;
+
+            return lowest + (1u << shift) - 1;
+        }
+
+    public:
+        void record(const u32 value) {
+            const u32 clamped = std::min(value, MAX_VALUE);
+
+            this->counts[index_of(clamped)]++;
+            this->count++;
+            this->sum += clamped;
+            this->min = std::min(this->min, clamped);
+            this->max = std::max(this->max, clamped);
+        }
+
+        [[nodiscard]] u64 get_count() const {
+            return this->count;
+        }
+
+        [[nodiscard]] u32 get_min() const {
+            return this->count == 0 ? 0 : this->min;
+        }
+
+        [[nodiscard]] u32 get_max() const {
+            return this->max;
+        }
+
+        [[nodiscard]] double get_mean() const {
+            return this->count == 0 ? 0.0 : static_cast<double>(this->sum) / static_cast<double>(this->count);
+        }
+
+        /// Returns the value at the given percentile, p in [0, 100]. The result is the upper bound of its bucket.
+        [[nodiscard]] u32 percentile(const double p) const {
+            if (this->count == 0) {
+                return 0;
+            }
+
+            const double target = std::max(1.0, p / 100.0 * static_cast<double>(this->count));
+            u64 seen = 0;
+
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                seen += this->counts[i];
+
+                if (static_cast<double>(seen) >= target) {
+                    return std::clamp(highest_equivalent(i), this->min, this->max);
+                }
+            }
+
+            return this->max;
+        }
+
+        LatencyHistogram& operator+=(const LatencyHistogram& other) {
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                this->counts[i] += other.counts[i];
+            }
+
+            this->count += other.count;
+            this->sum += other.sum;
+            this->min = std::min(this->min, other.min);
+            this->max = std::max(this->max, other.max);
+
+            return *this;
+        }
+    };
+
+    /**
+     *Latencies of the stages a message goes through, see ImKcpp::enable_latency_histograms().
+     *Times come from the connection's clock, so send() and input() are stamped with the time of the latest update().
+     */
+    struct MessageLatency final {
+        /// From send() to the first transmission of the message, i.e. time spent in the send queue behind cwnd.
+        LatencyHistogram queueing{};
+
+        /// From the first transmission of the message until all of its fragments are acknowledged.
+        LatencyHistogram acknowledgement{};
+
+        /// From the arrival of the message's first fragment until recv() can read it, mostly head-of-line blocking.
+        LatencyHistogram reassembly{};
+
+        MessageLatency& operator+=(const MessageLatency& other) {
+            this->queueing += other.queueing;
+            this->acknowledgement += other.acknowledgement;
+            this->reassembly += other.reassembly;
+
+            return *this;
+        }
+    };
+}
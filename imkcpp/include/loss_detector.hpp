@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include "types.hpp"
+#include "utility.hpp"
+
+namespace imkcpp {
+    /**
+     *LossDetector implements time-based loss detection similar to RACK (RFC 8985).
+     *A segment is considered lost if a segment sent after it has been acknowledged
+     *and more than RTT + reordering window has passed since the segment was sent.
+     */
+    class LossDetector final {
+        /// How many RTTs without observed reordering it takes to drop the extra reordering window.
+        constexpr static u32 REORDERING_DECAY_RTTS = 16;
+
+        /// Whether loss detection is enabled.
+        bool enabled = false;
+
+        /// Whether at least one segment has been acknowledged.
+        bool has_sample = false;
+
+        /// Transmission timestamp of the most recently sent segment that has been acknowledged.
+        u32 xmit_ts = 0;
+
+        /// Sequence number of the most recently sent segment that has been acknowledged.
+        u32 sn = 0;
+
+        /// Round trip time measured on the most recently sent segment that has been acknowledged.
+        u32 rtt = 0;
+
+        /// Minimum round trip time observed.
+        u32 min_rtt = std::numeric_limits<u32>::max();
+
+        /// Timestamp of the ack which last advanced xmit_ts.
+        u32 ts_xmit_acked = 0;
+
+        /// Additional reordering window learned from observed reordering.
+        u32 reordering_extra = 0;
+
+        /// Timestamp of the last observed reordering.
+        u32 ts_reordering_seen = 0;
+
+        /// Returns true if the segment (ts1, sn1) was sent after the segment (ts2, sn2).
+        [[nodiscard]] static bool sent_after(const u32 ts1, const u32 sn1, const u32 ts2, const u32 sn2) {
+            const i32 delta = time_delta(ts1, ts2);
+            return delta > 0 || (delta == 0 && sn1 > sn2);
+        }
+
+    public:
+        void set_enabled(const bool state) {
+            this->enabled = state;
+        }
+
+        [[nodiscard]] bool is_enabled() const {
+            return this->enabled;
+        }
+
+        /**
+         *Must be called for every newly acknowledged segment.
+         *ts is the transmission timestamp echoed by the remote side.
+         */
+        void ack_received(const u32 current, const u32 sn, const u32 ts) {
+            const i32 rtt = time_delta(current, ts);
+
+            if (rtt < 0) {
+                return;
+            }
+
+            this->min_rtt = std::min(this->min_rtt, static_cast<u32>(rtt));
+
+            if (!this->has_sample || sent_after(ts, sn, this->xmit_ts, this->sn)) {
+                this->has_sample = true;
+                this->xmit_ts = ts;
+                this->sn = sn;
+                this->rtt = rtt;
+                this->ts_xmit_acked = current;
+
+                return;
+            }
+
+            // A segment sent before the most recent acknowledged one has just been acknowledged,
+            // which means the path reorders. Grow the window to cover the observed delay.
+            const u32 delay = std::max(0, time_delta(current, this->ts_xmit_acked));
+            this->reordering_extra = std::max(this->reordering_extra, delay);
+            this->ts_reordering_seen = current;
+        }
+
+        /// Returns the current reordering window, which is never larger than srtt.
+        [[nodiscard]] u32 get_reordering_window(const u32 current, const u32 srtt) const {
+            if (!this->has_sample) {
+                return 0;
+            }
+
+            u32 extra = this->reordering_extra;
+
+            if (time_delta(current, this->ts_reordering_seen) > static_cast<i32>(REORDERING_DECAY_RTTS * this->rtt)) {
+                extra = 0;
+            }
+
+            return std::min(this->min_rtt / 4 + extra, std::max(srtt, this->min_rtt / 4));
+        }
+
+        /// Returns true if the segment sent at ts with the given sequence number is considered lost.
+        [[nodiscard]] bool is_lost(const u32 current, const u32 sn, const u32 ts, const u32 srtt) const {
+            if (!this->enabled || !this->has_sample) {
+                return false;
+            }
+
+            if (!sent_after(this->xmit_ts, this->sn, ts, sn)) {
+                return false;
+            }
+
+            const u32 threshold = this->rtt + this->get_reordering_window(current, srtt);
+            return time_delta(current, ts) >= static_cast<i32>(threshold);
+        }
+    };
+}
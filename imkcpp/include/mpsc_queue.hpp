@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <memory>
+#include <optional>
+#include "types.hpp"
+
+namespace imkcpp {
+    /// Size used to keep data written by different threads on separate cache lines.
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     *MpscQueue is a bounded lock-free queue for many producers and a single consumer.
+     *Producers claim a cell with a single CAS on the tail, the consumer never writes shared state other
+     *than the cell sequence, so there are no locks and no allocations after construction.
+     */
+    template <typename T>
+    class MpscQueue final {
+        struct Cell final {
+            std::atomic<size_t> sequence{0};
+            T value{};
+        };
+
+        size_t mask = 0;
+        std::unique_ptr<Cell[]> cells{};
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+        alignas(CACHE_LINE_SIZE) size_t head = 0;
+
+    public:
+        /// Capacity is rounded up to a power of two.
+        explicit MpscQueue(const size_t capacity) {
+            const size_t size = std::bit_ceil(std::max<size_t>(capacity, 2));
+
+            this->mask = size - 1;
+            this->cells = std::make_unique<Cell[]>(size);
+
+            for (size_t i = 0; i < size; ++i) {
+                this->cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        /// Can be called from any thread. Returns false if the queue is full.
+        template <typename U>
+        bool try_push(U&& value) {
+            return this->try_push_with([&value](T& cell) {
+                cell = std::forward<U>(value);
+            });
+        }
+
+        /// Like try_push, but lets the writer fill the claimed cell in place, avoiding a copy of large elements.
+        template <typename F>
+        bool try_push_with(F&& writer) {
+            size_t pos = this->tail.load(std::memory_order_relaxed);
+
+            while (true) {
+                Cell& cell = this->cells[pos & this->mask];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+                if (diff == 0) {
+                    if (this->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        writer(cell.value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = this->tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// Must only be called from the consumer thread. Returns nullptr if the queue is empty.
+        /// The returned element stays valid until pop() is called.
+        [[nodiscard]] T* front() {
+            Cell& cell = this->cells[this->head & this->mask];
+
+            if (cell.sequence.load(std::memory_order_acquire) != this->head + 1) {
+                return nullptr;
+            }
+
+            return &cell.value;
+        }
+
+        /// Must only be called from the consumer thread after front() returned an element.
+        void pop() {
+            Cell& cell = this->cells[this->head & this->mask];
+
+            assert(cell.sequence.load(std::memory_order_relaxed) == this->head + 1);
+
+            cell.sequence.store(this->head + this->mask + 1, std::memory_order_release);
+            ++this->head;
+        }
+
+        /// Must only be called from the consumer thread.
+        [[nodiscard]] std::optional<T> try_pop() {
+            T* value = this->front();
+
+            if (value == nullptr) {
+                return std::nullopt;
+            }
+
+            std::optional<T> result(std::move(*value));
+            this->pop();
+
+            return result;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return this->mask + 1;
+        }
+    };
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include "types.hpp"
+#include "constants.hpp"
+#include "segment.hpp"
+#include "receiver.hpp"
+#include "utility.hpp"
+
+namespace imkcpp {
+    /// NackRange is a range of missing sequence numbers carried in the payload of a NACK command.
+    struct NackRange final {
+        /// First missing sequence number.
+        u32 sn = 0;
+
+        /// Number of consecutive missing sequence numbers starting from sn.
+        u32 count = 0;
+
+        constexpr static size_t fixed_size() {
+            return serializer::fixed_size<decltype(sn)>() +
+                   serializer::fixed_size<decltype(count)>();
+        }
+
+        void serialize(const std::span<std::byte> buf, size_t& offset) const {
+            serializer::serialize<u32>(this->sn, buf, offset);
+            serializer::serialize<u32>(this->count, buf, offset);
+        }
+
+        void deserialize(const std::span<const std::byte> buf, size_t& offset) {
+            serializer::deserialize<u32>(this->sn, buf, offset);
+            serializer::deserialize<u32>(this->count, buf, offset);
+        }
+    };
+
+    /**
+     *NackController decides when the receiver reports missing segments to the sender.
+     *A NACK is sent once a gap in the receive buffer has persisted for the reorder delay,
+     *and repeated every reorder delay while gaps remain.
+     */
+    class NackController final {
+        /// Whether NACK commands are sent.
+        bool enabled = false;
+
+        /// How long a gap has to persist before it's reported.
+        u32 delay = constants::IKCP_NACK_DELAY;
+
+        /// Whether there is a gap in the receive buffer.
+        bool gap_tracked = false;
+
+        /// Timestamp of when the gap has been detected or last reported.
+        u32 ts_gap = 0;
+
+        /// Encoded ranges of the next NACK. Reused between flushes.
+        SegmentData payload{};
+
+    public:
+        void set_enabled(const bool state) {
+            this->enabled = state;
+        }
+
+        [[nodiscard]] bool is_enabled() const {
+            return this->enabled;
+        }
+
+        void set_delay(const u32 value) {
+            this->delay = value;
+        }
+
+        /// Must be called after segments have been received.
+        void update(const bool has_gaps, const u32 current) {
+            if (!has_gaps) {
+                this->gap_tracked = false;
+                return;
+            }
+
+            if (!this->gap_tracked) {
+                this->gap_tracked = true;
+                this->ts_gap = current;
+            }
+        }
+
+        /// Returns true if a NACK should be sent now.
+        [[nodiscard]] bool should_send(const u32 current) const {
+            return this->enabled && this->gap_tracked && time_delta(current, this->ts_gap) >= static_cast<i32>(this->delay);
+        }
+
+        /**
+         *Encodes missing ranges of the receive buffer, up to max_size bytes.
+         *Returns the encoded payload, which is empty if there is nothing to report.
+         */
+        [[nodiscard]] const SegmentData& prepare(const Receiver& receiver, const u32 current, const size_t max_size) {
+            const size_t max_ranges = std::min<size_t>(max_size / serializer::fixed_size<NackRange>(), constants::IKCP_NACK_MAX_RANGES);
+
+            this->payload.data.resize(max_ranges * serializer::fixed_size<NackRange>());
+
+            size_t offset = 0;
+            size_t count = 0;
+
+            receiver.for_each_missing_range([&](const u32 sn, const u32 missing) -> bool {
+                if (count >= max_ranges) {
+                    return false;
+                }
+
+                serializer::serialize(NackRange{sn, missing}, this->payload.data, offset);
+                ++count;
+
+                return true;
+            });
+
+            this->payload.data.resize(offset);
+            this->ts_gap = current;
+
+            return this->payload;
+        }
+    };
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "types.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace imkcpp::profiling {
+    /// Hot path stages measured when IMKCPP_ENABLE_PROFILING is defined.
+    enum class Stage : u8 {
+        /// Reading and validating segment headers in input()
+        HeaderDecode,
+
+        /// Applying ACKs and UNA to the send buffer
+        AckApply,
+
+        /// Copying payload into the receive buffer and ordering it
+        ReceiveInsert,
+
+        /// Reassembling messages into the caller's buffer in recv()
+        RecvCopy,
+
+        /// Splitting messages into segments in send()
+        SendSegmentation,
+
+        /// Moving segments into the send buffer and deciding what to (re)transmit
+        RetransmitScan,
+
+        /// Serializing headers and payload into datagrams
+        FlusherSerialize,
+
+        /// Time spent in the user's output callback
+        OutputCallback,
+
+        Count,
+    };
+
+    constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::Count);
+
+    [[nodiscard]] constexpr const char* stage_name(const Stage stage) {
+        constexpr std::array<const char*, STAGE_COUNT> NAMES = {
+            "header_decode", "ack_apply", "receive_insert", "recv_copy",
+            "send_segmentation", "retransmit_scan", "flusher_serialize", "output_callback",
+        };
+
+        return NAMES[static_cast<size_t>(stage)];
+    }
+
+    /// Reads the CPU's cycle counter, or a nanosecond clock where there is none.
+    [[nodiscard]] inline u64 read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        u64 value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#else
+        return static_cast<u64>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    /// Aggregated measurements of one stage. Bucket i counts samples below 2^i cycles (and at least 2^(i-1)).
+    struct StageStats final {
+        constexpr static size_t BUCKETS = 65;
+
+        u64 count = 0;
+        u64 total_cycles = 0;
+        u64 max_cycles = 0;
+        std::array<u64, BUCKETS> buckets{};
+
+        [[nodiscard]] double mean() const {
+            return this->count == 0 ? 0.0 : static_cast<double>(this->total_cycles) / static_cast<double>(this->count);
+        }
+
+        /// Returns an upper bound of the given percentile, p in [0, 100].
+        [[nodiscard]] u64 percentile(const double p) const {
+            const double target = p / 100.0 * static_cast<double>(this->count);
+            u64 seen = 0;
+
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                seen += this->buckets[i];
+
+                if (seen > 0 && static_cast<double>(seen) >= target) {
+                    return std::min(i < 64 ? u64{1} << i : ~u64{0}, this->max_cycles);
+                }
+            }
+
+            return this->max_cycles;
+        }
+
+        StageStats& operator+=(const StageStats& other) {
+            this->count += other.count;
+            this->total_cycles += other.total_cycles;
+            this->max_cycles = std::max(this->max_cycles, other.max_cycles);
+
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                this->buckets[i] += other.buckets[i];
+            }
+
+            return *this;
+        }
+    };
+
+    using Profile = std::array<StageStats, STAGE_COUNT>;
+
+    /**
+     *Measurements of one thread. Only the owning thread writes, using plain relaxed loads and stores
+     *instead of read-modify-write operations, and any thread may read them concurrently.
+     */
+    class ThreadProfile final {
+        struct Histogram final {
+            std::atomic<u64> count{0};
+            std::atomic<u64> total_cycles{0};
+            std::atomic<u64> max_cycles{0};
+            std::array<std::atomic<u64>, StageStats::BUCKETS> buckets{};
+        };
+
+        std::array<Histogram, STAGE_COUNT> histograms{};
+
+        static void bump(std::atomic<u64>& value, const u64 amount) {
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+    public:
+        void record(const Stage stage, const u64 cycles) {
+            Histogram& histogram = this->histograms[static_cast<size_t>(stage)];
+
+            bump(histogram.count, 1);
+            bump(histogram.total_cycles, cycles);
+            bump(histogram.buckets[std::bit_width(cycles)], 1);
+
+            if (cycles > histogram.max_cycles.load(std::memory_order_relaxed)) {
+                histogram.max_cycles.store(cycles, std::memory_order_relaxed);
+            }
+        }
+
+        void add_to(Profile& profile) const {
+            for (size_t stage = 0; stage < STAGE_COUNT; ++stage) {
+                const Histogram& histogram = this->histograms[stage];
+                StageStats stats{};
+
+                stats.count = histogram.count.load(std::memory_order_relaxed);
+                stats.total_cycles = histogram.total_cycles.load(std::memory_order_relaxed);
+                stats.max_cycles = histogram.max_cycles.load(std::memory_order_relaxed);
+
+                for (size_t i = 0; i < StageStats::BUCKETS; ++i) {
+                    stats.buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+                }
+
+                profile[stage] += stats;
+            }
+        }
+    };
+
+    class ScopedStage;
+
+    namespace detail {
+        /// Keeps the profiles of all threads alive, including finished ones, so their samples are still reported.
+        struct Registry final {
+            std::mutex mutex{};
+            std::vector<std::shared_ptr<ThreadProfile>> profiles{};
+        };
+
+        inline Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        inline ThreadProfile& local_profile() {
+            thread_local ThreadProfile* profile = [] {
+                auto created = std::make_shared<ThreadProfile>();
+                Registry& r = registry();
+
+                const std::lock_guard lock(r.mutex);
+                r.profiles.push_back(created);
+
+                return created.get();
+            }();
+
+            return *profile;
+        }
+
+        /// Innermost active scope of the thread, so nested stages are not counted twice.
+        inline thread_local ScopedStage* current_scope = nullptr;
+    }
+
+    /// Returns the measurements of all threads since the process started.
+    [[nodiscard]] inline Profile collect() {
+        Profile profile{};
+        detail::Registry& r = detail::registry();
+
+        const std::lock_guard lock(r.mutex);
+        for (const auto& thread_profile : r.profiles) {
+            thread_profile->add_to(profile);
+        }
+
+        return profile;
+    }
+
+    /// Returns the measurements made between two calls to collect(). max_cycles is kept from the later one.
+    [[nodiscard]] inline Profile difference(const Profile& later, const Profile& earlier) {
+        Profile result = later;
+
+        for (size_t stage = 0; stage < STAGE_COUNT; ++stage) {
+            result[stage].count -= earlier[stage].count;
+            result[stage].total_cycles -= earlier[stage].total_cycles;
+
+            for (size_t i = 0; i < StageStats::BUCKETS; ++i) {
+                result[stage].buckets[i] -= earlier[stage].buckets[i];
+            }
+        }
+
+        return result;
+    }
+
+    /// Measures the enclosing scope. Time spent in nested scopes is attributed to them only.
+    class ScopedStage final {
+        Stage stage;
+        u64 start;
+        u64 nested = 0;
+        ScopedStage* parent;
+
+    public:
+        explicit ScopedStage(const Stage stage) : stage(stage), start(read_cycles()), parent(detail::current_scope) {
+            detail::current_scope = this;
+        }
+
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+        ~ScopedStage() {
+            const u64 elapsed = read_cycles() - this->start;
+
+            detail::current_scope = this->parent;
+
+            if (this->parent != nullptr) {
+                this->parent->nested += elapsed;
+            }
+
+            detail::local_profile().record(this->stage, elapsed > this->nested ? elapsed - this->nested : 0);
+        }
+    };
+}
+
+#define IMKCPP_PROFILE_CONCAT_IMPL(a, b) a##b
+#define IMKCPP_PROFILE_CONCAT(a, b) IMKCPP_PROFILE_CONCAT_IMPL(a, b)
+
+/// Measures the rest of the enclosing scope as the given stage. Compiles to nothing unless IMKCPP_ENABLE_PROFILING is defined.
+#if defined(IMKCPP_ENABLE_PROFILING)
+#define IMKCPP_PROFILE_SCOPE(stage) const ::imkcpp::profiling::ScopedStage IMKCPP_PROFILE_CONCAT(imkcpp_profile_scope_, __LINE__)(::imkcpp::profiling::Stage::stage)
+#else
+#define IMKCPP_PROFILE_SCOPE(stage) static_cast<void>(0)
+#endif
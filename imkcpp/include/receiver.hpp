@@ -1,23 +1,90 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <deque>
+#include <optional>
+#include <vector>
 #include "third_party/expected.hpp"
 
 #include "types.hpp"
 #include "errors.hpp"
 #include "segment.hpp"
 #include "results.hpp"
+#include "utility.hpp"
+#include "latency.hpp"
 
 namespace imkcpp {
-    // TODO: Benchmark against std::vector instead of std::deque
+    // TODO: Benchmark rcv_queue against a std::vector instead of std::deque
     class Receiver final {
-        std::deque<Segment> rcv_buf{};
+        /// Initial number of slots in rcv_buf.
+        constexpr static size_t MIN_BUFFER_SLOTS = 16;
+
+        /**
+         *Segments which arrived out of order, indexed by sequence number modulo its size, a power of two which covers
+         *every buffered sequence number from rcv_nxt on. Any position in the window is O(1) to insert.
+         *It's only allocated once a segment arrives out of order, and grows up to the receive window.
+         */
+        std::vector<std::optional<Segment>> rcv_buf{};
+
+        /// Number of segments in rcv_buf.
+        size_t buffered = 0;
+
+        /// Sequence number following the last segment in rcv_buf, only valid while it's not empty.
+        u32 buffer_end = 0;
 
         std::deque<Segment> rcv_queue{}; // TODO: Does not need to be Segment as we don't use metadata
         u32 queue_limit = 0;
 
         u32 rcv_nxt = 0;
 
+        /// Receives the reassembly latency of messages, if enabled.
+        MessageLatency* latency = nullptr;
+
+        /// Earliest arrival of the fragments of the message which is being moved to the receive queue.
+        u32 message_arrival_ts = 0;
+
+        /// Whether the last segment moved to the receive queue wasn't the last fragment of its message.
+        bool receiving_message = false;
+
+        [[nodiscard]] std::optional<Segment>& slot(const u32 sn) {
+            return this->rcv_buf[sn & (this->rcv_buf.size() - 1)];
+        }
+
+        [[nodiscard]] bool is_buffered(const u32 sn) const {
+            return this->rcv_buf[sn & (this->rcv_buf.size() - 1)].has_value();
+        }
+
+        /// Grows rcv_buf so that it covers the sequence numbers [rcv_nxt, rcv_nxt + required).
+        void grow(const u32 required) {
+            std::vector<std::optional<Segment>> slots(std::bit_ceil(std::max<size_t>(required, MIN_BUFFER_SLOTS)));
+
+            for (std::optional<Segment>& seg : this->rcv_buf) {
+                if (seg.has_value()) {
+                    slots[seg->header.sn & (slots.size() - 1)] = std::move(seg);
+                }
+            }
+
+            this->rcv_buf = std::move(slots);
+        }
+
+        /// Accounts for the segment which was just appended to the receive queue and advances rcv_nxt past it.
+        void segment_queued(const u32 current) {
+            const Segment& seg = this->rcv_queue.back();
+
+            if (!this->receiving_message || time_delta(seg.metadata.enqueued_ts, this->message_arrival_ts) < 0) {
+                this->message_arrival_ts = seg.metadata.enqueued_ts;
+            }
+
+            this->receiving_message = seg.header.frg != 0;
+
+            if (!this->receiving_message && this->latency != nullptr) {
+                this->latency->reassembly.record(static_cast<u32>(std::max(0, time_delta(current, this->message_arrival_ts))));
+            }
+
+            this->rcv_nxt++;
+        }
+
     public:
         [[nodiscard]] tl::expected<size_t, error> peek_size() const {
             if (this->rcv_queue.empty()) {
@@ -46,7 +113,7 @@ namespace imkcpp {
             return length;
         }
 
-        tl::expected<ReceiveResult, error> recv(const std::span<std::byte> buffer, const u32 rcv_wnd) {
+        tl::expected<ReceiveResult, error> recv(const std::span<std::byte> buffer, const u32 rcv_wnd, const u32 current) {
             const auto peeksize = this->peek_size();
 
             if (!peeksize.has_value()) {
@@ -80,7 +147,7 @@ namespace imkcpp {
 
             assert(offset == peeksize);
 
-            this->move_receive_buffer_to_queue();
+            this->move_receive_buffer_to_queue(current);
 
             const ReceiveResult result{
                 .size = offset,
@@ -90,34 +157,63 @@ namespace imkcpp {
             return result;
         }
 
-        void emplace_segment(const SegmentHeader& header, SegmentData& data) {
-            u32 sn = header.sn;
+        /**
+         *Inserts a received segment, current is the time it arrived. sn has to be within the receive window.
+         *A segment in order goes straight to the receive queue, others wait in the receive buffer until the gap before
+         *them is filled. Either way it's O(1) whatever order segments arrive in, apart from the buffer growing towards
+         *the receive window.
+         */
+        void emplace_segment(const SegmentHeader& header, SegmentData& data, const u32 current) {
+            const u32 sn = header.sn;
+
+            if (!this->should_receive(sn)) {
+                return;
+            }
+
+            if (sn == this->rcv_nxt && this->buffered == 0 && this->rcv_queue.size() < this->queue_limit) {
+                Segment& seg = this->rcv_queue.emplace_back(header, data);
+                seg.metadata.enqueued_ts = current;
+
+                this->segment_queued(current);
+                return;
+            }
 
-            const auto rit = std::find_if(this->rcv_buf.rbegin(), this->rcv_buf.rend(), [sn](const Segment& seg) {
-                return seg.header.sn < sn;
-            });
+            if (sn - this->rcv_nxt >= this->rcv_buf.size()) {
+                this->grow(sn - this->rcv_nxt + 1);
+            }
 
-            const auto it = rit.base();
+            std::optional<Segment>& seg = this->slot(sn);
 
-            if (it != this->rcv_buf.end() && it->header.sn == sn) {
+            if (seg.has_value()) {
                 return;
             }
 
-            this->rcv_buf.emplace(it, header, data);
-            this->move_receive_buffer_to_queue();
+            seg.emplace(header, data);
+            seg->metadata.enqueued_ts = current;
+
+            if (this->buffered == 0 || sn >= this->buffer_end) {
+                this->buffer_end = sn + 1;
+            }
+
+            ++this->buffered;
+
+            this->move_receive_buffer_to_queue(current);
         }
 
-        void move_receive_buffer_to_queue() {
-            while (!this->rcv_buf.empty()) {
-                Segment& seg = this->rcv_buf.front();
-                if (seg.header.sn != this->rcv_nxt || this->rcv_queue.size() >= this->queue_limit) {
+        void move_receive_buffer_to_queue(const u32 current) {
+            while (this->buffered > 0 && this->rcv_queue.size() < this->queue_limit) {
+                // Buffered sequence numbers are unique modulo the buffer size, so this slot holds rcv_nxt or nothing
+                std::optional<Segment>& seg = this->slot(this->rcv_nxt);
+
+                if (!seg.has_value()) {
                     break;
                 }
 
-                this->rcv_queue.push_back(std::move(seg));
+                this->rcv_queue.push_back(std::move(seg.value()));
+                seg.reset();
+                --this->buffered;
 
-                this->rcv_buf.pop_front();
-                this->rcv_nxt++;
+                this->segment_queued(current);
             }
         }
 
@@ -125,6 +221,52 @@ namespace imkcpp {
             return this->rcv_queue.size();
         }
 
+        /// Returns the number of out of order segments waiting for the gaps before them to be filled.
+        [[nodiscard]] size_t get_buffer_size() const {
+            return this->buffered;
+        }
+
+        /// Returns true if there are sequence numbers missing between rcv_nxt and the last buffered segment.
+        [[nodiscard]] bool has_gaps() const {
+            if (this->buffered == 0) {
+                return false;
+            }
+
+            // rcv_buf has no duplicates, so it's contiguous only if its span equals its size
+            return this->buffer_end - this->rcv_nxt != this->buffered;
+        }
+
+        /**
+         *Calls fn(sn, count) for every range of missing sequence numbers before the last buffered segment.
+         *Iteration stops early if fn returns false.
+         */
+        template <typename F>
+        void for_each_missing_range(F&& fn) const {
+            if (this->buffered == 0) {
+                return;
+            }
+
+            u32 sn = this->rcv_nxt;
+
+            while (sn != this->buffer_end) {
+                if (this->is_buffered(sn)) {
+                    ++sn;
+                    continue;
+                }
+
+                // The segment before buffer_end is buffered, which ends every range
+                const u32 first = sn;
+
+                while (!this->is_buffered(sn)) {
+                    ++sn;
+                }
+
+                if (!fn(first, sn - first)) {
+                    return;
+                }
+            }
+        }
+
         [[nodiscard]] u32 get_rcv_nxt() const {
             return this->rcv_nxt;
         }
@@ -136,5 +278,9 @@ namespace imkcpp {
         void set_queue_limit(const u32 value) {
             this->queue_limit = value;
         }
+
+        void set_latency(MessageLatency* value) {
+            this->latency = value;
+        }
     };
 }
\ No newline at end of file
@@ -12,12 +12,18 @@ namespace imkcpp {
         /// Number of WINS commands received
         u32 cmd_wins_count = 0;
 
+        /// Number of NACK commands received
+        u32 cmd_nack_count = 0;
+
         /// Number of PUSH segments received
         u32 cmd_push_count = 0;
 
         /// Number of PUSH segments dropped
         u32 dropped_push_count = 0;
 
+        /// Number of retransmissions detected as spurious (the original transmission has been acknowledged)
+        u32 spurious_retransmitted_count = 0;
+
         /// Total number of bytes received
         size_t total_bytes_received = 0;
 
@@ -26,8 +32,10 @@ namespace imkcpp {
                 cmd_ack_count + other.cmd_ack_count,
                 cmd_wask_count + other.cmd_wask_count,
                 cmd_wins_count + other.cmd_wins_count,
+                cmd_nack_count + other.cmd_nack_count,
                 cmd_push_count + other.cmd_push_count,
                 dropped_push_count + other.dropped_push_count,
+                spurious_retransmitted_count + other.spurious_retransmitted_count,
                 total_bytes_received + other.total_bytes_received
             };
         }
@@ -36,8 +44,10 @@ namespace imkcpp {
             cmd_ack_count += other.cmd_ack_count;
             cmd_wask_count += other.cmd_wask_count;
             cmd_wins_count += other.cmd_wins_count;
+            cmd_nack_count += other.cmd_nack_count;
             cmd_push_count += other.cmd_push_count;
             dropped_push_count += other.dropped_push_count;
+            spurious_retransmitted_count += other.spurious_retransmitted_count;
             total_bytes_received += other.total_bytes_received;
 
             return *this;
@@ -55,6 +65,9 @@ namespace imkcpp {
         /// Number of WINS commands sent
         u32 cmd_wins_count = 0;
 
+        /// Number of NACK commands sent
+        u32 cmd_nack_count = 0;
+
         /// Number of PUSH segments sent
         u32 cmd_push_count = 0;
 
@@ -64,6 +77,12 @@ namespace imkcpp {
         /// Number of fast retransmitted segments
         u32 fast_retransmitted_count = 0;
 
+        /// Number of tail loss probes sent
+        u32 tail_loss_probe_count = 0;
+
+        /// Number of segments retransmitted because the remote side reported them missing
+        u32 nack_retransmitted_count = 0;
+
         /// Total number of bytes sent
         size_t total_bytes_sent = 0;
 
@@ -72,9 +91,12 @@ namespace imkcpp {
                 cmd_ack_count + other.cmd_ack_count,
                 cmd_wask_count + other.cmd_wask_count,
                 cmd_wins_count + other.cmd_wins_count,
+                cmd_nack_count + other.cmd_nack_count,
                 cmd_push_count + other.cmd_push_count,
                 timeout_retransmitted_count + other.timeout_retransmitted_count,
                 fast_retransmitted_count + other.fast_retransmitted_count,
+                tail_loss_probe_count + other.tail_loss_probe_count,
+                nack_retransmitted_count + other.nack_retransmitted_count,
                 total_bytes_sent + other.total_bytes_sent
             };
         }
@@ -83,9 +105,12 @@ namespace imkcpp {
             cmd_ack_count += other.cmd_ack_count;
             cmd_wask_count += other.cmd_wask_count;
             cmd_wins_count += other.cmd_wins_count;
+            cmd_nack_count += other.cmd_nack_count;
             cmd_push_count += other.cmd_push_count;
             timeout_retransmitted_count += other.timeout_retransmitted_count;
             fast_retransmitted_count += other.fast_retransmitted_count;
+            tail_loss_probe_count += other.tail_loss_probe_count;
+            nack_retransmitted_count += other.nack_retransmitted_count;
             total_bytes_sent += other.total_bytes_sent;
 
             return *this;
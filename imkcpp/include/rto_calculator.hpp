@@ -23,6 +23,9 @@ namespace imkcpp {
         /// Last measured round trip time
         u32 last_rtt = 0;
 
+        /// Whether at least one round trip time has been measured
+        bool has_sample = false;
+
         /// Minimum retransmission timeout aka RTO_MIN in RFC 2988
         u32 minrto = constants::IKCP_RTO_MIN;
 
@@ -42,6 +45,7 @@ namespace imkcpp {
             }
 
             this->last_rtt = rtt;
+            this->has_sample = true;
 
             if (this->srtt == 0) {
                 // First measurement
@@ -74,6 +78,25 @@ namespace imkcpp {
             this->rto = std::clamp(rto, this->minrto, this->maxrto);
         }
 
+        /**
+         *Adapts the estimator after a spurious retransmission has been detected (Eifel response, RFC 4015).
+         *The delayed RTT sample proves the path got slower, so SRTT and RTTVAR are raised to cover it.
+         */
+        void spurious_retransmission(const u32 current, const u32 ts) {
+            const i32 rtt = time_delta(current, ts);
+
+            if (rtt < 0) {
+                return;
+            }
+
+            this->srtt = std::max(this->srtt, static_cast<u32>(rtt));
+            this->rttvar = std::max(this->rttvar, static_cast<u32>(rtt) / 2);
+
+            constexpr u32 K = 4;
+            const u32 rto = this->srtt + std::max(this->interval, K * this->rttvar);
+            this->rto = std::clamp(rto, this->minrto, this->maxrto);
+        }
+
         void set_min_rto(const u32 minrto) {
             this->minrto = minrto;
         }
@@ -82,6 +105,18 @@ namespace imkcpp {
             return this->rto;
         }
 
+        [[nodiscard]] bool has_rtt_sample() const {
+            return this->has_sample;
+        }
+
+        [[nodiscard]] u32 get_srtt() const {
+            return this->srtt;
+        }
+
+        [[nodiscard]] u32 get_rttvar() const {
+            return this->rttvar;
+        }
+
         [[nodiscard]] u32 get_last_rtt() const {
             return this->last_rtt;
         }
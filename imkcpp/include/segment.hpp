@@ -90,6 +90,21 @@ namespace imkcpp {
 
         /// Number of times this segment has been transmitted.
         u32 xmit = 0;
+
+        /// Whether the remote side has reported this segment as missing.
+        bool nacked = false;
+
+        /// Whether the segment was acknowledged while earlier ones are still in flight. Only used by SenderBuffer.
+        bool acked = false;
+
+        /// Whether every retransmission of this segment was a tail loss probe.
+        bool probe_only = false;
+
+        /// Time the segment entered the local buffers, i.e. send() on the sender and input() on the receiver.
+        u32 enqueued_ts = 0;
+
+        /// Time of the first transmission of the message this segment belongs to.
+        u32 message_sent_ts = 0;
     };
 
     // TODO: Should be used via serializer functions.
@@ -13,7 +13,12 @@
 #include "results.hpp"
 #include "flusher.hpp"
 #include "segment_tracker.hpp"
+#include "tail_loss_prober.hpp"
+#include "loss_detector.hpp"
 #include "commands.hpp"
+#include "tracing.hpp"
+#include "profiling.hpp"
+#include "latency.hpp"
 
 namespace imkcpp {
     template <size_t MTU>
@@ -26,6 +31,8 @@ namespace imkcpp {
         Flusher<MTU>& flusher;
         SenderBuffer& sender_buffer;
         SegmentTracker& segment_tracker;
+        TailLossProber& tail_loss_prober;
+        LossDetector& loss_detector;
 
         std::deque<Segment> snd_queue{};
 
@@ -36,22 +43,35 @@ namespace imkcpp {
         u32 xmit = 0;
         u32 dead_link = constants::IKCP_DEADLINK;
 
+        /// Receives the queueing latency of messages, if enabled.
+        MessageLatency* latency = nullptr;
+
+        /// Time of the first transmission of the message whose fragments are being sent for the first time.
+        u32 message_sent_ts = 0;
+
+        /// Whether the last segment sent for the first time wasn't the last fragment of its message.
+        bool sending_message = false;
+
     public:
         explicit Sender(SharedCtx& shared_ctx,
                         CongestionController<MTU>& congestion_controller,
                         RtoCalculator& rto_calculator,
                         Flusher<MTU>& flusher,
                         SenderBuffer& sender_buffer,
-                        SegmentTracker& segment_tracker) :
+                        SegmentTracker& segment_tracker,
+                        TailLossProber& tail_loss_prober,
+                        LossDetector& loss_detector) :
                         shared_ctx(shared_ctx),
                         congestion_controller(congestion_controller),
                         rto_calculator(rto_calculator),
                         flusher(flusher),
                         sender_buffer(sender_buffer),
-                        segment_tracker(segment_tracker) {}
+                        segment_tracker(segment_tracker),
+                        tail_loss_prober(tail_loss_prober),
+                        loss_detector(loss_detector) {}
 
         /// Takes the payload, splits it into segments and puts them into the send queue.
-        [[nodiscard]] tl::expected<size_t, error> send(const std::span<const std::byte> buffer) {
+        [[nodiscard]] tl::expected<size_t, error> send(const std::span<const std::byte> buffer, const u32 current) {
             if (buffer.empty()) {
                 return tl::unexpected(error::buffer_too_small);
             }
@@ -77,6 +97,7 @@ namespace imkcpp {
                 Segment& seg = this->snd_queue.emplace_back();
                 seg.data_assign({buffer.data() + offset, size});
                 seg.header.frg = Fragment(count - i - 1);
+                seg.metadata.enqueued_ts = current;
 
                 assert(seg.data_size() == size);
 
@@ -117,6 +138,11 @@ namespace imkcpp {
             return std::max(static_cast<size_t>(1), (size + MAX_SEGMENT_SIZE - 1) / MAX_SEGMENT_SIZE);
         }
 
+        /// Returns the number of segments waiting in the send queue.
+        [[nodiscard]] size_t get_queue_size() const {
+            return this->snd_queue.size();
+        }
+
         void set_fastresend(const u32 value) {
             this->fastresend = value;
         }
@@ -134,8 +160,15 @@ namespace imkcpp {
             this->dead_link = value;
         }
 
+        void set_latency(MessageLatency* value) {
+            this->latency = value;
+        }
+
         /// Flushes data segments from the send queue to the output callback.
-        void flush_data_segments(FlushResult& flush_result, const output_callback_t& output, const u32 current, const i32 unused_receive_window, const u32 rcv_nxt) {
+        template <TracerPolicy Tracer>
+        void flush_data_segments(FlushResult& flush_result, const output_callback_t& output, const u32 current, const i32 unused_receive_window, const u32 rcv_nxt, Tracer& tracer) {
+            IMKCPP_PROFILE_SCOPE(RetransmitScan);
+
             const u32 cwnd = this->congestion_controller.calculate_congestion_window();
             this->move_send_queue_to_buffer(cwnd, current, unused_receive_window, rcv_nxt);
 
@@ -143,6 +176,7 @@ namespace imkcpp {
 
             const u32 resent = (this->fastresend > 0) ? this->fastresend : 0xffffffff;
             const u32 rtomin = (this->nodelay == 0) ? (this->rto_calculator.get_rto() >> 3) : 0;
+            const u32 srtt = this->rto_calculator.get_srtt();
 
             const auto has_never_been_sent = [](const Segment& segment) -> bool {
                 return segment.metadata.xmit == 0;
@@ -152,6 +186,18 @@ namespace imkcpp {
                 segment.metadata.xmit++;
                 segment.metadata.rto = this->rto_calculator.get_rto();
                 segment.metadata.resendts = current + segment.metadata.rto + rtomin;
+
+                // Segments are sent for the first time in order, so a message starts after the last fragment of the previous one
+                if (!this->sending_message) {
+                    this->message_sent_ts = current;
+
+                    if (this->latency != nullptr) {
+                        this->latency->queueing.record(static_cast<u32>(std::max(0, time_delta(current, segment.metadata.enqueued_ts))));
+                    }
+                }
+
+                segment.metadata.message_sent_ts = this->message_sent_ts;
+                this->sending_message = segment.header.frg != 0;
             };
 
             const auto has_timed_out = [&](const Segment& segment) -> bool {
@@ -160,6 +206,7 @@ namespace imkcpp {
 
             const auto prepare_segment_for_resend = [&](Segment& segment) -> void {
                 segment.metadata.xmit++;
+                segment.metadata.probe_only = false;
                 ++this->xmit;
 
                 if (this->nodelay == 0) {
@@ -172,17 +219,28 @@ namespace imkcpp {
                 segment.metadata.resendts = current + segment.metadata.rto;
             };
 
+            // Both fast paths give up on a segment after fastlimit transmissions and leave it to the RTO
+            const auto is_within_fastlimit = [&](const Segment& segment) -> bool {
+                return segment.metadata.xmit < this->fastlimit || this->fastlimit == 0;
+            };
+
             const auto can_fast_resend = [&](const Segment& segment) -> bool {
-                return resent < segment.metadata.fastack && (segment.metadata.xmit < this->fastlimit || this->fastlimit == 0);
+                return resent < segment.metadata.fastack;
+            };
+
+            const auto is_lost_by_time = [&](const Segment& segment) -> bool {
+                return this->loss_detector.is_lost(current, segment.header.sn, segment.header.ts, srtt);
             };
 
             const auto prepare_segment_for_fast_resend = [&](Segment& segment) {
                 segment.metadata.xmit++;
+                segment.metadata.probe_only = false;
                 segment.metadata.fastack = 0;
                 segment.metadata.resendts = current + segment.metadata.rto;
             };
 
             const auto send_segment = [&](Segment& segment) -> void {
+                segment.metadata.nacked = false;
                 segment.header.ts = current;
                 segment.header.wnd = unused_receive_window;
                 segment.header.una = rcv_nxt;
@@ -195,21 +253,42 @@ namespace imkcpp {
                 }
             };
 
+            const auto trace_resend = [&](const Segment& segment, const RetransmitCause cause) {
+                if constexpr (Tracer::enabled) {
+                    tracer.segment_retransmitted(current, segment.header.sn, cause, segment.metadata.xmit);
+                }
+            };
+
             auto process_segment = [&](Segment& segment) -> bool {
                 if (has_never_been_sent(segment)) {
                     prepare_for_first_send(segment);
+
+                    if constexpr (Tracer::enabled) {
+                        tracer.segment_sent(current, segment.header.sn, static_cast<u32>(segment.data_size()));
+                    }
+
                     return true;
                 }
 
                 if (has_timed_out(segment)) {
                     prepare_segment_for_resend(segment);
                     flush_result.timeout_retransmitted_count++;
+                    trace_resend(segment, RetransmitCause::Timeout);
                     return true;
                 }
 
-                if (can_fast_resend(segment)) {
+                if (segment.metadata.nacked) {
+                    prepare_segment_for_fast_resend(segment);
+                    flush_result.nack_retransmitted_count++;
+                    trace_resend(segment, RetransmitCause::Nack);
+                    change = true;
+                    return true;
+                }
+
+                if (is_within_fastlimit(segment) && (can_fast_resend(segment) || is_lost_by_time(segment))) {
                     prepare_segment_for_fast_resend(segment);
                     flush_result.fast_retransmitted_count++;
+                    trace_resend(segment, RetransmitCause::Fast);
                     change = true;
                     return true;
                 }
@@ -221,14 +300,38 @@ namespace imkcpp {
             const auto end = this->sender_buffer.end();
 
             std::for_each(begin, end, [&](Segment& segment) {
-                if (process_segment(segment)) {
+                if (!segment.metadata.acked && process_segment(segment)) {
                     send_segment(segment);
                     flush_result.cmd_push_count++;
                 }
             });
 
+            // Tail loss probe: if the last segment in flight hasn't been acknowledged for a while,
+            // retransmit it so that the loss of the tail is detected by acks instead of an RTO.
+            if (!this->sender_buffer.empty() && this->rto_calculator.has_rtt_sample()) {
+                Segment& tail = this->sender_buffer.back();
+                const u32 pto = TailLossProber::calculate_pto(this->rto_calculator.get_srtt(), this->shared_ctx.get_interval());
+
+                if (this->tail_loss_prober.should_probe(current, tail.header.ts, tail.metadata.resendts, pto)) {
+                    tail.metadata.probe_only = tail.metadata.xmit == 1 || tail.metadata.probe_only;
+                    tail.metadata.xmit++;
+                    tail.metadata.resendts = current + tail.metadata.rto;
+
+                    send_segment(tail);
+                    flush_result.cmd_push_count++;
+                    flush_result.tail_loss_probe_count++;
+                    trace_resend(tail, RetransmitCause::TailLossProbe);
+
+                    this->tail_loss_prober.probe_sent();
+                }
+            }
+
+            if (change || flush_result.timeout_retransmitted_count > 0) {
+                this->congestion_controller.save_undo_point(this->segment_tracker.get_snd_nxt());
+            }
+
             if (change) {
-                this->congestion_controller.packets_resent(this->segment_tracker.get_packets_in_flight_count(), resent);
+                this->congestion_controller.packets_resent(this->segment_tracker.get_packets_in_flight_count(), this->fastresend);
             }
 
             if (flush_result.timeout_retransmitted_count > 0) {
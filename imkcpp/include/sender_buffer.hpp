@@ -2,24 +2,125 @@
 
 #include <deque>
 #include <limits>
+#include <algorithm>
 
 #include "types.hpp"
 #include "segment.hpp"
+#include "utility.hpp"
+#include "latency.hpp"
 
 namespace imkcpp {
+    /// A segment removed from the sender buffer because it was acknowledged.
+    struct AckedSegment final {
+        /// Header of the latest transmission.
+        SegmentHeader header{};
+
+        /// See SegmentMetadata::probe_only.
+        bool probe_only = false;
+    };
+
+    /**
+     *SenderBuffer keeps the segments in flight, sorted by sequence number.
+     *Segments acknowledged out of order are only marked as acked and dropped once they reach either end of the buffer,
+     *so that an ack never has to shift the segments in the middle of the buffer.
+     */
     class SenderBuffer final {
         std::deque<Segment> snd_buf{};
 
+        /// Number of buffered segments which weren't acknowledged yet.
+        size_t live = 0;
+
+        /// Total payload size of the buffered segments which weren't acknowledged yet.
+        size_t payload_bytes = 0;
+
+        /// Receives the acknowledgement latency of messages, if enabled.
+        MessageLatency* latency = nullptr;
+
+        /// Sequence number following the last pushed segment. Later fragments may still wait in the send queue.
+        u32 pushed_end = 0;
+
+        /**
+         *Records the message of the segment at it, which is being acknowledged, if none of its other fragments are left.
+         *Fragments of a message have consecutive sequence numbers and the buffer is sorted, so the other fragments
+         *are at most 255 neighbours away on either side, unless they weren't pushed yet.
+         */
+        void record_if_message_acked(const std::deque<Segment>::iterator it, const u32 current) {
+            if (this->latency == nullptr) {
+                return;
+            }
+
+            const u32 sn = it->header.sn;
+            const u32 last_sn = sn + it->header.frg.get();
+
+            if (time_delta(last_sn, this->pushed_end) >= 0) {
+                return;
+            }
+
+            for (auto previous = it; previous != this->snd_buf.begin();) {
+                --previous;
+
+                if (previous->header.sn + previous->header.frg.get() < sn) {
+                    break;
+                }
+
+                if (!previous->metadata.acked) {
+                    return;
+                }
+            }
+
+            for (auto next = std::next(it); next != this->snd_buf.end() && next->header.sn <= last_sn; ++next) {
+                if (!next->metadata.acked) {
+                    return;
+                }
+            }
+
+            this->latency->acknowledgement.record(static_cast<u32>(std::max(0, time_delta(current, it->metadata.message_sent_ts))));
+        }
+
+        /// Marks the segment as acknowledged and releases its payload.
+        void acknowledge(const std::deque<Segment>::iterator it, const u32 current) {
+            this->record_if_message_acked(it, current);
+            it->metadata.acked = true;
+
+            this->payload_bytes -= it->data_size();
+            this->live--;
+
+            it->data = SegmentData{};
+        }
+
+        /// Drops acknowledged segments from both ends, so the first and last buffered segments are always in flight.
+        void trim() {
+            while (!this->snd_buf.empty() && this->snd_buf.front().metadata.acked) {
+                this->snd_buf.pop_front();
+            }
+
+            while (!this->snd_buf.empty() && this->snd_buf.back().metadata.acked) {
+                this->snd_buf.pop_back();
+            }
+        }
+
     public:
+        /// Iterates the buffered segments, including ones already acknowledged out of order, see SegmentMetadata::acked.
         std::deque<Segment>::iterator begin() { return snd_buf.begin(); }
         std::deque<Segment>::iterator end() { return snd_buf.end(); }
 
+        /// Returns the segment with the highest sequence number. The buffer must not be empty.
+        Segment& back() { return snd_buf.back(); }
+
         void push_segment(Segment& segment) {
+            this->payload_bytes += segment.data_size();
+            this->live++;
+            this->pushed_end = segment.header.sn + 1;
             this->snd_buf.push_back(std::move(segment));
         }
 
+        /// Returns the number of segments in flight.
         [[nodiscard]] size_t size() const {
-            return this->snd_buf.size();
+            return this->live;
+        }
+
+        [[nodiscard]] size_t get_payload_bytes() const {
+            return this->payload_bytes;
         }
 
         [[nodiscard]] std::optional<u32> get_first_sequence_number_in_flight() const {
@@ -31,38 +132,67 @@ namespace imkcpp {
             return std::nullopt;
         }
 
-        void erase(const u32 sn) {
-            for (auto it = this->snd_buf.begin(); it != this->snd_buf.end();) {
-                if (sn == it->header.sn) {
-                    this->snd_buf.erase(it);
-                    break;
-                }
+        /**
+         *Removes the segment with the given sequence number.
+         *Returns the removed segment, its header ts is the timestamp of the latest transmission.
+         *current is the time of the acknowledgement, used for the latency of messages which are now fully acknowledged.
+         *The segment is found with a binary search and removed lazily, so an ack for any sequence number costs
+         *O(log snd_buf), plus dropping segments which were acknowledged earlier once they reach an end of the buffer.
+         */
+        std::optional<AckedSegment> erase(const u32 sn, const u32 current) {
+            const auto it = std::lower_bound(this->snd_buf.begin(), this->snd_buf.end(), sn, [](const Segment& seg, const u32 value) {
+                return seg.header.sn < value;
+            });
 
-                if (sn < it->header.sn) {
-                    break;
+            if (it == this->snd_buf.end() || it->header.sn != sn || it->metadata.acked) {
+                return std::nullopt;
+            }
+
+            const AckedSegment acked{ it->header, it->metadata.probe_only };
+            this->acknowledge(it, current);
+            this->trim();
+
+            return acked;
+        }
+
+        /// Removes all segments before the given sequence number, see erase().
+        void erase_before(const u32 sn, const u32 current) {
+            while (!this->snd_buf.empty() && sn > this->snd_buf.front().header.sn) {
+                if (!this->snd_buf.front().metadata.acked) {
+                    this->acknowledge(this->snd_buf.begin(), current);
                 }
 
-                ++it;
+                this->snd_buf.pop_front();
             }
+
+            this->trim();
         }
 
-        void erase_before(const u32 sn) {
-            for (auto it = this->snd_buf.begin(); it != this->snd_buf.end();) {
-                if (sn > it->header.sn) {
-                    it = this->snd_buf.erase(it);
-                } else {
-                    break;
+        /**
+         *Marks segments in [first, last] as reported missing by the remote side.
+         *Segments whose latest transmission happened after sent_before are skipped as they may still be in flight.
+         */
+        void mark_nacked(const u32 first, const u32 last, const u32 sent_before) {
+            auto it = std::lower_bound(this->snd_buf.begin(), this->snd_buf.end(), first, [](const Segment& seg, const u32 sn) {
+                return seg.header.sn < sn;
+            });
+
+            for (; it != this->snd_buf.end() && it->header.sn <= last; ++it) {
+                if (!it->metadata.acked && it->metadata.xmit > 0 && time_delta(sent_before, it->header.ts) >= 0) {
+                    it->metadata.nacked = true;
                 }
             }
         }
 
         void increment_fastack_before(const u32 sn) {
             for (Segment& seg : this->snd_buf) {
-                if (seg.header.sn < sn) {
-                    seg.metadata.fastack++;
-                } else {
+                if (seg.header.sn >= sn) {
                     break;
                 }
+
+                if (!seg.metadata.acked) {
+                    seg.metadata.fastack++;
+                }
             }
         }
 
@@ -79,6 +209,10 @@ namespace imkcpp {
             u32 tm_packet = default_value;
 
             for (const Segment& seg : this->snd_buf) {
+                if (seg.metadata.acked) {
+                    continue;
+                }
+
                 if (seg.metadata.resendts <= current) {
                     return 0;
                 }
@@ -96,5 +230,9 @@ namespace imkcpp {
         [[nodiscard]] bool empty() const {
             return this->snd_buf.empty();
         }
+
+        void set_latency(MessageLatency* value) {
+            this->latency = value;
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include "types.hpp"
+
+namespace imkcpp {
+    /**
+     *SeqLock publishes a trivially copyable value from one writer thread to any number of readers without locking.
+     *Readers retry while a write is in progress, the writer never waits. The value is kept in relaxed atomic words,
+     *so concurrent access is free of data races.
+     */
+    template <typename T>
+    class SeqLock final {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+                      "SeqLock requires a trivially copyable, default constructible type");
+
+        constexpr static size_t WORDS = (sizeof(T) + sizeof(u64) - 1) / sizeof(u64);
+
+        std::atomic<u32> sequence{0};
+        std::array<std::atomic<u64>, WORDS> words{};
+
+    public:
+        /// Must only be called from one thread at a time.
+        void store(const T& value) {
+            std::array<u64, WORDS> buffer{};
+            std::memcpy(buffer.data(), &value, sizeof(T));
+
+            const u32 seq = this->sequence.load(std::memory_order_relaxed);
+            this->sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < WORDS; ++i) {
+                this->words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+
+            this->sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        /// Can be called from any thread.
+        [[nodiscard]] T load() const {
+            std::array<u64, WORDS> buffer{};
+
+            while (true) {
+                const u32 before = this->sequence.load(std::memory_order_acquire);
+
+                if ((before & 1) != 0) {
+                    continue;
+                }
+
+                for (size_t i = 0; i < WORDS; ++i) {
+                    buffer[i] = this->words[i].load(std::memory_order_relaxed);
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (this->sequence.load(std::memory_order_relaxed) == before) {
+                    break;
+                }
+            }
+
+            // T may have default member initializers, which makes it non-trivial for -Wclass-memaccess, but copying
+            // its bytes is still valid as it is trivially copyable
+            T value{};
+            std::memcpy(static_cast<void*>(&value), buffer.data(), sizeof(T));
+
+            return value;
+        }
+    };
+}
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include "third_party/expected.hpp"
+
+#include "types.hpp"
+#include "types/conv.hpp"
+#include "errors.hpp"
+#include "results.hpp"
+#include "imkcpp.hpp"
+#include "timer_wheel.hpp"
+
+namespace imkcpp {
+    using session_output_callback_t = std::function<void(Conv, std::span<const std::byte>)>;
+
+    /// Reads the conversation id of a datagram without parsing the rest of it.
+    [[nodiscard]] inline std::optional<Conv> peek_conv(const std::span<const std::byte> data) {
+        if (data.size() < serializer::fixed_size<Conv>()) {
+            return std::nullopt;
+        }
+
+        Conv conv{0};
+        size_t offset = 0;
+        serializer::deserialize(conv, data, offset);
+
+        return conv;
+    }
+
+    /**
+     *SessionManager owns many connections, routes incoming datagrams to them by conv,
+     *and updates only connections whose check() deadline has arrived.
+     *Connections with nothing to do are parked until they are woken by input, send or recv,
+     *so the cost of update() scales with the number of active connections.
+     */
+    template <size_t MTU>
+    class SessionManager final {
+        struct Session final : TimerNode {
+            ImKcpp<MTU> kcp;
+
+            explicit Session(const Conv conv) : kcp(conv) { }
+        };
+
+        enum class SlotState : u8 {
+            Empty,
+            Used,
+            Deleted,
+        };
+
+        struct Slot final {
+            Conv::UT key = 0;
+            SlotState state = SlotState::Empty;
+            std::unique_ptr<Session> session{};
+        };
+
+        constexpr static size_t MIN_CAPACITY = 16;
+
+        /// Open addressing table with linear probing. Capacity is always a power of two.
+        std::vector<Slot> slots{};
+
+        /// Number of sessions in the table.
+        size_t live = 0;
+
+        /// Number of deleted slots which still take part in probing.
+        size_t tombstones = 0;
+
+        TimerWheel timer_wheel{};
+
+        /// Time of the last update() call.
+        u32 current = 0;
+
+        /// Scratch buffers reused between update() calls.
+        std::vector<TimerNode*> expired{};
+        std::vector<Conv::UT> due{};
+
+        /// Session whose update() is running, if any.
+        Session* updating = nullptr;
+
+        /// Keeps the updating session alive when the output callback removes it, until its update() returns.
+        std::unique_ptr<Session> retired{};
+
+        [[nodiscard]] size_t hash(const Conv::UT key) const {
+            // Fibonacci hashing spreads sequential conv ids over the table
+            return static_cast<size_t>(static_cast<u64>(key) * 0x9E3779B97F4A7C15ull >> 32) & (this->slots.size() - 1);
+        }
+
+        [[nodiscard]] Slot* find_slot(const Conv::UT key) {
+            if (this->slots.empty()) {
+                return nullptr;
+            }
+
+            const size_t mask = this->slots.size() - 1;
+
+            for (size_t i = this->hash(key);; i = (i + 1) & mask) {
+                Slot& slot = this->slots[i];
+
+                if (slot.state == SlotState::Empty) {
+                    return nullptr;
+                }
+
+                if (slot.state == SlotState::Used && slot.key == key) {
+                    return &slot;
+                }
+            }
+        }
+
+        void insert_slot(const Conv::UT key, std::unique_ptr<Session> session) {
+            const size_t mask = this->slots.size() - 1;
+
+            for (size_t i = this->hash(key);; i = (i + 1) & mask) {
+                Slot& slot = this->slots[i];
+
+                if (slot.state != SlotState::Used) {
+                    if (slot.state == SlotState::Deleted) {
+                        --this->tombstones;
+                    }
+
+                    slot.key = key;
+                    slot.state = SlotState::Used;
+                    slot.session = std::move(session);
+                    ++this->live;
+
+                    return;
+                }
+            }
+        }
+
+        /// Keeps the load factor, including tombstones, under one half.
+        void reserve_one() {
+            if ((this->live + this->tombstones + 1) * 2 <= this->slots.size()) {
+                return;
+            }
+
+            size_t capacity = std::max(this->slots.size(), MIN_CAPACITY);
+            while ((this->live + 1) * 2 > capacity) {
+                capacity *= 2;
+            }
+
+            // Rehashing into the same capacity purges tombstones
+            std::vector<Slot> old = std::move(this->slots);
+            this->slots = std::vector<Slot>(capacity);
+            this->live = 0;
+            this->tombstones = 0;
+
+            for (Slot& slot : old) {
+                if (slot.state == SlotState::Used) {
+                    this->insert_slot(slot.key, std::move(slot.session));
+                }
+            }
+        }
+
+        [[nodiscard]] Session* find_session(const Conv conv) {
+            Slot* slot = this->find_slot(conv.get());
+            return slot != nullptr ? slot->session.get() : nullptr;
+        }
+
+        /// Makes sure a parked session is updated on the next update() call.
+        void wake(Session& session) {
+            if (!session.is_scheduled()) {
+                this->timer_wheel.schedule(session, this->current);
+            }
+        }
+
+    public:
+        explicit SessionManager(const u32 current = 0) : timer_wheel(current), current(current) { }
+
+        SessionManager(const SessionManager&) = delete;
+        SessionManager& operator=(const SessionManager&) = delete;
+
+        /**
+         *Creates a new connection. The returned pointer is valid until the connection is removed.
+         *It is meant for settings only: data must go through send(), input() and recv() of the manager, which reschedule
+         *the connection. Calling them on the pointer leaves a parked connection parked, call wake() afterwards if you do.
+         */
+        [[nodiscard]] tl::expected<ImKcpp<MTU>*, error> create(const Conv conv) {
+            if (this->find_slot(conv.get()) != nullptr) {
+                return tl::unexpected(error::conv_already_exists);
+            }
+
+            this->reserve_one();
+
+            auto session = std::make_unique<Session>(conv);
+            Session* ptr = session.get();
+
+            this->insert_slot(conv.get(), std::move(session));
+            this->wake(*ptr);
+
+            return &ptr->kcp;
+        }
+
+        /**
+         *Removes the connection. Returns false if it doesn't exist.
+         *Can be called from the output callback of update(), also for the connection being updated,
+         *which is then destroyed once its update returns.
+         */
+        bool remove(const Conv conv) {
+            Slot* slot = this->find_slot(conv.get());
+
+            if (slot == nullptr) {
+                return false;
+            }
+
+            this->timer_wheel.cancel(*slot->session);
+
+            if (slot->session.get() == this->updating) {
+                this->retired = std::move(slot->session);
+            } else {
+                slot->session.reset();
+            }
+
+            slot->state = SlotState::Deleted;
+            --this->live;
+            ++this->tombstones;
+
+            return true;
+        }
+
+        /// Finds the connection. Returns nullptr if it doesn't exist. Data must go through the manager, see create().
+        [[nodiscard]] ImKcpp<MTU>* find(const Conv conv) {
+            Session* session = this->find_session(conv);
+            return session != nullptr ? &session->kcp : nullptr;
+        }
+
+        /// Routes a datagram to its connection.
+        tl::expected<InputResult, error> input(const std::span<const std::byte> data) {
+            const std::optional<Conv> conv = peek_conv(data);
+
+            if (!conv.has_value()) {
+                return tl::unexpected(error::less_than_header_size);
+            }
+
+            Session* session = this->find_session(conv.value());
+
+            if (session == nullptr) {
+                return tl::unexpected(error::unknown_conv);
+            }
+
+            this->wake(*session);
+
+            return session->kcp.input(data);
+        }
+
+        /// Sends data on the given connection.
+        tl::expected<size_t, error> send(const Conv conv, const std::span<const std::byte> buffer) {
+            Session* session = this->find_session(conv);
+
+            if (session == nullptr) {
+                return tl::unexpected(error::unknown_conv);
+            }
+
+            this->wake(*session);
+
+            return session->kcp.send(buffer);
+        }
+
+        /// Reads data from the given connection.
+        tl::expected<size_t, error> recv(const Conv conv, const std::span<std::byte> buffer) {
+            Session* session = this->find_session(conv);
+
+            if (session == nullptr) {
+                return tl::unexpected(error::unknown_conv);
+            }
+
+            // Reading may reopen the receive window, which has to be told to the remote side
+            this->wake(*session);
+
+            return session->kcp.recv(buffer);
+        }
+
+        /// Makes sure the connection is updated on the next update() call, e.g. after its settings were changed.
+        bool wake(const Conv conv) {
+            Session* session = this->find_session(conv);
+
+            if (session == nullptr) {
+                return false;
+            }
+
+            this->wake(*session);
+
+            return true;
+        }
+
+        /// Updates all connections whose deadline has arrived.
+        FlushResult update(const u32 current, const session_output_callback_t& callback) {
+            this->current = current;
+
+            this->expired.clear();
+            this->timer_wheel.advance(current, this->expired);
+
+            // Convert to keys first, the callback may remove sessions while we are updating others
+            this->due.clear();
+            for (TimerNode* node : this->expired) {
+                this->due.push_back(static_cast<Session*>(node)->kcp.get_conv().get());
+            }
+
+            FlushResult flush_result{};
+
+            for (const Conv::UT key : this->due) {
+                Session* session = this->find_session(Conv{key});
+
+                if (session == nullptr) {
+                    continue;
+                }
+
+                const Conv conv{key};
+
+                this->updating = session;
+                flush_result += session->kcp.update(current, [&callback, conv](const std::span<const std::byte> data) {
+                    callback(conv, data);
+                });
+                this->updating = nullptr;
+                this->retired.reset();
+
+                // The callback may have removed it
+                session = this->find_session(conv);
+
+                if (session == nullptr || session->is_scheduled() || session->kcp.is_idle()) {
+                    continue;
+                }
+
+                this->timer_wheel.schedule(*session, session->kcp.check(current));
+            }
+
+            return flush_result;
+        }
+
+        /// Returns a time no later than when the next connection has to be updated, or nothing if all are parked.
+        [[nodiscard]] std::optional<u32> next_update_time() const {
+            return this->timer_wheel.next_expiry();
+        }
+
+        /// Returns the number of connections.
+        [[nodiscard]] size_t size() const {
+            return this->live;
+        }
+
+        /// Returns the number of connections waiting for an update, i.e. not parked.
+        [[nodiscard]] size_t active_count() const {
+            return this->timer_wheel.size();
+        }
+    };
+}
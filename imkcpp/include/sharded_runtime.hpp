@@ -0,0 +1,225 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "types.hpp"
+#include "types/conv.hpp"
+#include "session_manager.hpp"
+#include "mpsc_queue.hpp"
+
+namespace imkcpp {
+    /**
+     *ShardedRuntime runs connections on a fixed number of threads, one shard per thread.
+     *A connection belongs to the shard selected by hashing its conv, and is only ever touched by that shard's thread,
+     *so the connections themselves need no locking. Other threads hand work over through bounded lock-free queues.
+     */
+    template <size_t MTU>
+    class ShardedRuntime final {
+    public:
+        /// Called on the shard thread with the shard's manager.
+        using task_t = std::function<void(SessionManager<MTU>&)>;
+
+        /// Called on the shard thread after a datagram has been passed to the connection, e.g. to recv() from it.
+        using input_callback_t = std::function<void(SessionManager<MTU>&, Conv)>;
+
+        struct Config final {
+            /// Number of shards. Zero means one per hardware thread.
+            size_t shards = 0;
+
+            /// Capacity of each shard's datagram and task queues.
+            size_t queue_capacity = 4096;
+
+            /// Whether shard threads are pinned to CPUs. Shard state is allocated by the shard thread itself,
+            /// so with pinning it is also placed on the thread's NUMA node.
+            bool pin_threads = false;
+
+            /// CPU the first shard is pinned to, the following shards take the next ones. Lets runtimes in the same
+            /// process pin to disjoint CPUs.
+            size_t first_cpu = 0;
+
+            /// Maximum number of queued items handled between two updates.
+            size_t batch_size = 256;
+        };
+
+    private:
+        struct Datagram final {
+            std::array<std::byte, MTU> data{};
+            size_t size = 0;
+        };
+
+        struct Shard final {
+            MpscQueue<Datagram> datagrams;
+            MpscQueue<task_t> tasks;
+            std::thread thread{};
+
+            explicit Shard(const size_t capacity) : datagrams(capacity), tasks(capacity) { }
+        };
+
+        using clock = std::chrono::steady_clock;
+
+        Config config;
+        session_output_callback_t output_callback;
+        input_callback_t input_callback;
+
+        clock::time_point start = clock::now();
+        std::atomic<bool> running{true};
+
+        std::vector<std::unique_ptr<Shard>> shards{};
+
+        [[nodiscard]] u32 now() const {
+            return static_cast<u32>(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - this->start).count());
+        }
+
+        static void pin_current_thread(const size_t cpu) {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+            (void)cpu;
+#endif
+        }
+
+        void run(const size_t index) {
+            if (this->config.pin_threads) {
+                pin_current_thread(this->config.first_cpu + index);
+            }
+
+            Shard& shard = *this->shards[index];
+            SessionManager<MTU> manager(this->now());
+
+            u32 idle_rounds = 0;
+
+            while (this->running.load(std::memory_order_relaxed)) {
+                size_t handled = 0;
+
+                while (handled < this->config.batch_size) {
+                    task_t* task = shard.tasks.front();
+
+                    if (task == nullptr) {
+                        break;
+                    }
+
+                    (*task)(manager);
+                    *task = nullptr;
+                    shard.tasks.pop();
+                    ++handled;
+                }
+
+                while (handled < this->config.batch_size) {
+                    const Datagram* datagram = shard.datagrams.front();
+
+                    if (datagram == nullptr) {
+                        break;
+                    }
+
+                    const std::span<const std::byte> data(datagram->data.data(), datagram->size);
+
+                    if (manager.input(data).has_value() && this->input_callback) {
+                        this->input_callback(manager, peek_conv(data).value());
+                    }
+
+                    shard.datagrams.pop();
+                    ++handled;
+                }
+
+                manager.update(this->now(), this->output_callback);
+
+                if (handled > 0) {
+                    idle_rounds = 0;
+                } else if (++idle_rounds < 64) {
+                    std::this_thread::yield();
+                } else {
+                    // Timers have a millisecond resolution, there is nothing to do before the next tick
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                }
+            }
+        }
+
+        [[nodiscard]] Shard& shard_for(const Conv conv) {
+            return *this->shards[this->shard_index(conv)];
+        }
+
+    public:
+        /**
+         *Starts the shard threads.
+         *The output callback is called from shard threads, concurrently for connections of different shards.
+         */
+        ShardedRuntime(const Config& config, session_output_callback_t output, input_callback_t on_input = {})
+            : config(config), output_callback(std::move(output)), input_callback(std::move(on_input)) {
+
+            if (this->config.shards == 0) {
+                this->config.shards = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            for (size_t i = 0; i < this->config.shards; ++i) {
+                this->shards.push_back(std::make_unique<Shard>(this->config.queue_capacity));
+            }
+
+            for (size_t i = 0; i < this->config.shards; ++i) {
+                this->shards[i]->thread = std::thread([this, i] { this->run(i); });
+            }
+        }
+
+        ShardedRuntime(const ShardedRuntime&) = delete;
+        ShardedRuntime& operator=(const ShardedRuntime&) = delete;
+
+        ~ShardedRuntime() {
+            this->stop();
+        }
+
+        /// Stops and joins shard threads. Connections are destroyed by their shards.
+        void stop() {
+            this->running.store(false, std::memory_order_relaxed);
+
+            for (const auto& shard : this->shards) {
+                if (shard->thread.joinable()) {
+                    shard->thread.join();
+                }
+            }
+        }
+
+        /// Returns the shard index owning the given conv.
+        [[nodiscard]] size_t shard_index(const Conv conv) const {
+            return static_cast<size_t>(static_cast<u64>(conv.get()) * 0x9E3779B97F4A7C15ull >> 32) % this->shards.size();
+        }
+
+        [[nodiscard]] size_t shard_count() const {
+            return this->shards.size();
+        }
+
+        /// Runs the task on the shard owning the conv. Can be called from any thread. Returns false if the queue is full.
+        bool post(const Conv conv, task_t task) {
+            return this->shard_for(conv).tasks.try_push(std::move(task));
+        }
+
+        /**
+         *Copies a datagram to the queue of the shard owning its conv. Can be called from any thread.
+         *Returns false if the datagram is malformed or larger than MTU, or if the queue is full, in which case it's dropped.
+         */
+        bool post_input(const std::span<const std::byte> data) {
+            const std::optional<Conv> conv = peek_conv(data);
+
+            if (!conv.has_value() || data.size() > MTU) {
+                return false;
+            }
+
+            return this->shard_for(conv.value()).datagrams.try_push_with([data](Datagram& datagram) {
+                std::memcpy(datagram.data.data(), data.data(), data.size());
+                datagram.size = data.size();
+            });
+        }
+    };
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <span>
+#include <vector>
+
+#include "../types.hpp"
+#include "../results.hpp"
+#include "../imkcpp.hpp"
+
+namespace imkcpp::simulator {
+    /// Small deterministic PRNG (splitmix64), so results don't depend on the standard library implementation.
+    class Random final {
+        u64 state;
+
+    public:
+        explicit Random(const u64 seed) : state(seed) { }
+
+        u64 next() {
+            u64 z = (this->state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        /// Returns a number in [0, 1).
+        double uniform() {
+            return static_cast<double>(this->next() >> 11) * 0x1.0p-53;
+        }
+
+        bool chance(const double probability) {
+            return probability > 0.0 && this->uniform() < probability;
+        }
+    };
+
+    /// Two state Markov loss model. Each datagram first moves the state, then is lost with the state's loss probability.
+    struct GilbertElliott final {
+        double good_to_bad = 0.0;
+        double bad_to_good = 1.0;
+        double loss_in_good = 0.0;
+        double loss_in_bad = 1.0;
+    };
+
+    struct LinkConfig final {
+        /// Bottleneck bandwidth in bits per second, 0 means unlimited.
+        u64 bandwidth_bps = 0;
+
+        /// One way propagation delay.
+        u32 latency_ms = 0;
+
+        /// Additional uniformly distributed delay in [0, jitter_ms].
+        u32 jitter_ms = 0;
+
+        /// Probability of independent (Bernoulli) loss.
+        double loss = 0.0;
+
+        /// Burst loss, applied in addition to the independent loss.
+        std::optional<GilbertElliott> burst_loss{};
+
+        /// Probability that a datagram is held back by reorder_delay_ms, letting later ones overtake it.
+        double reorder = 0.0;
+        u32 reorder_delay_ms = 0;
+
+        /// Probability that a datagram is delivered twice.
+        double duplicate = 0.0;
+
+        /// Bytes which may be waiting for or being serialized by the bottleneck, beyond it datagrams are tail dropped. 0 means unlimited.
+        size_t queue_bytes = 0;
+    };
+
+    struct LinkStats final {
+        u64 datagrams_sent = 0;
+        u64 bytes_sent = 0;
+        u64 lost = 0;
+        u64 queue_dropped = 0;
+        u64 duplicated = 0;
+        u64 delivered = 0;
+        u64 bytes_delivered = 0;
+    };
+
+    /**
+     *Link is one direction of a simulated path. Datagrams first wait in the bottleneck queue,
+     *are serialized at the configured bandwidth, may be lost, and arrive after latency, jitter and reordering delay.
+     *Time is virtual and given in microseconds, so runs are reproducible for a given seed.
+     */
+    class Link final {
+        struct InFlight final {
+            u64 arrival_us = 0;
+            u64 sequence = 0;
+            std::vector<std::byte> data{};
+
+            bool operator>(const InFlight& other) const {
+                return this->arrival_us != other.arrival_us ? this->arrival_us > other.arrival_us : this->sequence > other.sequence;
+            }
+        };
+
+        LinkConfig config;
+        Random random;
+        LinkStats stats{};
+
+        bool bad_state = false;
+
+        /// Time when the bottleneck finishes serializing the datagrams accepted so far.
+        u64 busy_until_us = 0;
+
+        /// Breaks ties between datagrams arriving at the same time, keeping them in sending order.
+        u64 sequence = 0;
+
+        std::priority_queue<InFlight, std::vector<InFlight>, std::greater<>> in_flight{};
+
+        [[nodiscard]] bool is_lost() {
+            if (this->random.chance(this->config.loss)) {
+                return true;
+            }
+
+            if (!this->config.burst_loss.has_value()) {
+                return false;
+            }
+
+            const GilbertElliott& model = this->config.burst_loss.value();
+            this->bad_state = this->bad_state ? !this->random.chance(model.bad_to_good) : this->random.chance(model.good_to_bad);
+
+            return this->random.chance(this->bad_state ? model.loss_in_bad : model.loss_in_good);
+        }
+
+        [[nodiscard]] u64 delay_us() {
+            u64 delay = static_cast<u64>(this->config.latency_ms) * 1000;
+
+            if (this->config.jitter_ms > 0) {
+                delay += this->random.next() % (static_cast<u64>(this->config.jitter_ms) * 1000 + 1);
+            }
+
+            if (this->random.chance(this->config.reorder)) {
+                delay += static_cast<u64>(this->config.reorder_delay_ms) * 1000;
+            }
+
+            return delay;
+        }
+
+    public:
+        Link(const LinkConfig& config, const u64 seed) : config(config), random(seed) { }
+
+        void send(const u64 now_us, const std::span<const std::byte> data) {
+            this->stats.datagrams_sent++;
+            this->stats.bytes_sent += data.size();
+
+            u64 departure_us = now_us;
+
+            if (this->config.bandwidth_bps > 0) {
+                const u64 start_us = std::max(now_us, this->busy_until_us);
+                const u64 backlog_bytes = (start_us - now_us) * this->config.bandwidth_bps / 8000000;
+
+                if (this->config.queue_bytes > 0 && backlog_bytes + data.size() > this->config.queue_bytes) {
+                    this->stats.queue_dropped++;
+                    return;
+                }
+
+                this->busy_until_us = start_us + (data.size() * 8 * 1000000 + this->config.bandwidth_bps - 1) / this->config.bandwidth_bps;
+                departure_us = this->busy_until_us;
+            }
+
+            if (this->is_lost()) {
+                this->stats.lost++;
+                return;
+            }
+
+            const size_t copies = this->random.chance(this->config.duplicate) ? 2 : 1;
+            this->stats.duplicated += copies - 1;
+
+            for (size_t i = 0; i < copies; ++i) {
+                this->in_flight.push(InFlight{ departure_us + this->delay_us(), this->sequence++, { data.begin(), data.end() } });
+            }
+        }
+
+        /// Calls the function for every datagram which has arrived by now, in arrival order.
+        template <typename F>
+        void deliver(const u64 now_us, F&& fn) {
+            while (!this->in_flight.empty() && this->in_flight.top().arrival_us <= now_us) {
+                // Take ownership first, fn may send on this link
+                InFlight datagram = std::move(const_cast<InFlight&>(this->in_flight.top()));
+                this->in_flight.pop();
+
+                this->stats.delivered++;
+                this->stats.bytes_delivered += datagram.data.size();
+
+                fn(std::span<const std::byte>(datagram.data));
+            }
+        }
+
+        [[nodiscard]] std::optional<u64> next_arrival_us() const {
+            if (this->in_flight.empty()) {
+                return std::nullopt;
+            }
+
+            return this->in_flight.top().arrival_us;
+        }
+
+        [[nodiscard]] const LinkStats& get_stats() const {
+            return this->stats;
+        }
+    };
+
+    /// What the simulation needs from a protocol implementation, so other implementations can be compared on the same links.
+    template <typename T>
+    concept SimulatedEndpoint = requires(T& t, const std::span<const std::byte> in, const std::span<std::byte> out, const u32 current, const output_callback_t& callback) {
+        { t.send(in) } -> std::same_as<bool>;
+        { t.recv(out) } -> std::same_as<std::optional<size_t>>;
+        { t.input(in) };
+        { t.update(current, callback) };
+        { t.get_waiting_send_count() } -> std::convertible_to<size_t>;
+        { t.get_segments_sent() } -> std::convertible_to<u64>;
+        { t.get_segments_retransmitted() } -> std::convertible_to<u64>;
+    };
+
+    /// Adapts ImKcpp to SimulatedEndpoint and counts its segments.
+    template <size_t MTU>
+    class KcpEndpoint final {
+        ImKcpp<MTU>& kcp;
+        FlushResult flushed{};
+
+    public:
+        explicit KcpEndpoint(ImKcpp<MTU>& kcp) : kcp(kcp) { }
+
+        bool send(const std::span<const std::byte> data) {
+            return this->kcp.send(data).has_value();
+        }
+
+        std::optional<size_t> recv(const std::span<std::byte> buffer) {
+            const auto size = this->kcp.recv(buffer);
+            return size.has_value() ? std::optional(size.value()) : std::nullopt;
+        }
+
+        void input(const std::span<const std::byte> data) {
+            (void)this->kcp.input(data);
+        }
+
+        void update(const u32 current, const output_callback_t& callback) {
+            this->flushed += this->kcp.update(current, callback);
+        }
+
+        [[nodiscard]] size_t get_waiting_send_count() const {
+            return this->kcp.get_waiting_send_count();
+        }
+
+        [[nodiscard]] u64 get_segments_sent() const {
+            return this->flushed.cmd_push_count;
+        }
+
+        [[nodiscard]] u64 get_segments_retransmitted() const {
+            return this->flushed.timeout_retransmitted_count + this->flushed.fast_retransmitted_count +
+                   this->flushed.tail_loss_probe_count + this->flushed.nack_retransmitted_count;
+        }
+    };
+
+    struct SimulationConfig final {
+        /// Link from the sender to the receiver.
+        LinkConfig forward{};
+
+        /// Link carrying acknowledgements back.
+        LinkConfig backward{};
+
+        u64 seed = 1;
+
+        size_t message_size = 1024;
+        u32 message_count = 1000;
+
+        /// Time between messages, 0 means sending as fast as max_waiting_segments allows.
+        u32 send_interval_ms = 0;
+
+        /// Application backpressure: messages wait while the sender has this many segments queued or in flight.
+        size_t max_waiting_segments = 256;
+
+        /// The run stops at this virtual time even if not all messages were delivered.
+        u32 time_limit_ms = 600000;
+    };
+
+    struct SimulationResult final {
+        bool completed = false;
+
+        u32 messages_delivered = 0;
+        u64 bytes_delivered = 0;
+        u32 duration_ms = 0;
+
+        u64 segments_sent = 0;
+        u64 segments_retransmitted = 0;
+
+        LinkStats forward{};
+        LinkStats backward{};
+
+        /// Message latencies in milliseconds, sorted.
+        std::vector<u32> latencies_ms{};
+
+        [[nodiscard]] double goodput_bps() const {
+            return this->duration_ms == 0 ? 0.0 : static_cast<double>(this->bytes_delivered) * 8.0 * 1000.0 / this->duration_ms;
+        }
+
+        [[nodiscard]] double retransmission_ratio() const {
+            return this->segments_sent == 0 ? 0.0 : static_cast<double>(this->segments_retransmitted) / static_cast<double>(this->segments_sent);
+        }
+
+        /// Bytes sent in both directions, including what the links dropped.
+        [[nodiscard]] u64 wire_bytes() const {
+            return this->forward.bytes_sent + this->backward.bytes_sent;
+        }
+
+        /// Nearest rank percentile, p in [0, 100].
+        [[nodiscard]] u32 latency_percentile(const double p) const {
+            if (this->latencies_ms.empty()) {
+                return 0;
+            }
+
+            const double rank = std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(this->latencies_ms.size());
+            const size_t index = std::min(this->latencies_ms.size() - 1, static_cast<size_t>(std::max(1.0, std::ceil(rank))) - 1);
+
+            return this->latencies_ms[index];
+        }
+    };
+
+    /**
+     *Runs a one way transfer from sender to receiver over a pair of simulated links on a 1 ms virtual clock.
+     *Message latency is measured from when the application wanted to send the message, so it includes backpressure.
+     *Both endpoints must be freshly created and configured.
+     */
+    template <SimulatedEndpoint Endpoint>
+    SimulationResult simulate(Endpoint& sender, Endpoint& receiver, const SimulationConfig& config) {
+        Link forward(config.forward, config.seed);
+        Link backward(config.backward, config.seed ^ 0x5DEECE66Dull);
+
+        u32 current = 0;
+
+        const output_callback_t forward_output = [&forward, &current](const std::span<const std::byte> data) {
+            forward.send(static_cast<u64>(current) * 1000, data);
+        };
+
+        const output_callback_t backward_output = [&backward, &current](const std::span<const std::byte> data) {
+            backward.send(static_cast<u64>(current) * 1000, data);
+        };
+
+        const std::vector<std::byte> message(config.message_size, std::byte{0x5A});
+        std::vector<std::byte> buffer(config.message_size);
+        std::vector<u32> send_times{};
+        send_times.reserve(config.message_count);
+
+        SimulationResult result{};
+        result.latencies_ms.reserve(config.message_count);
+
+        for (; current < config.time_limit_ms && result.messages_delivered < config.message_count; ++current) {
+            while (send_times.size() < config.message_count && sender.get_waiting_send_count() < config.max_waiting_segments) {
+                const u32 scheduled = static_cast<u32>(send_times.size()) * config.send_interval_ms;
+
+                if (config.send_interval_ms > 0 && scheduled > current) {
+                    break;
+                }
+
+                if (!sender.send(message)) {
+                    break;
+                }
+
+                send_times.push_back(config.send_interval_ms > 0 ? scheduled : current);
+            }
+
+            const u64 now_us = static_cast<u64>(current) * 1000;
+            forward.deliver(now_us, [&receiver](const std::span<const std::byte> data) { receiver.input(data); });
+            backward.deliver(now_us, [&sender](const std::span<const std::byte> data) { sender.input(data); });
+
+            sender.update(current, forward_output);
+            receiver.update(current, backward_output);
+
+            while (const std::optional<size_t> size = receiver.recv(buffer)) {
+                result.latencies_ms.push_back(current - send_times[result.messages_delivered]);
+                result.messages_delivered++;
+                result.bytes_delivered += size.value();
+            }
+        }
+
+        std::sort(result.latencies_ms.begin(), result.latencies_ms.end());
+
+        result.completed = result.messages_delivered == config.message_count;
+        result.duration_ms = current;
+        result.segments_sent = sender.get_segments_sent();
+        result.segments_retransmitted = sender.get_segments_retransmitted();
+        result.forward = forward.get_stats();
+        result.backward = backward.get_stats();
+
+        return result;
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <memory>
+#include <optional>
+#include "types.hpp"
+#include "mpsc_queue.hpp"
+
+namespace imkcpp {
+    /**
+     *SpscQueue is a bounded lock-free queue for a single producer and a single consumer.
+     *Each side keeps a cached copy of the other side's index, so the shared indices are only read when the cache runs out.
+     */
+    template <typename T>
+    class SpscQueue final {
+        size_t mask = 0;
+        std::unique_ptr<T[]> items{};
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0};
+        size_t cached_tail = 0;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+        size_t cached_head = 0;
+
+    public:
+        /// Capacity is rounded up to a power of two.
+        explicit SpscQueue(const size_t capacity) {
+            const size_t size = std::bit_ceil(std::max<size_t>(capacity, 2));
+
+            this->mask = size - 1;
+            this->items = std::make_unique<T[]>(size);
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        /// Must only be called from the producer thread.
+        [[nodiscard]] bool full() {
+            const size_t tail = this->tail.load(std::memory_order_relaxed);
+
+            if (tail - this->cached_head <= this->mask) {
+                return false;
+            }
+
+            this->cached_head = this->head.load(std::memory_order_acquire);
+            return tail - this->cached_head > this->mask;
+        }
+
+        /// Must only be called from the producer thread. Returns false if the queue is full.
+        template <typename U>
+        bool try_push(U&& value) {
+            if (this->full()) {
+                return false;
+            }
+
+            const size_t tail = this->tail.load(std::memory_order_relaxed);
+
+            this->items[tail & this->mask] = std::forward<U>(value);
+            this->tail.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /// Must only be called from the consumer thread. Returns nullptr if the queue is empty.
+        /// The returned element stays valid until pop() is called.
+        [[nodiscard]] T* front() {
+            const size_t head = this->head.load(std::memory_order_relaxed);
+
+            if (head == this->cached_tail) {
+                this->cached_tail = this->tail.load(std::memory_order_acquire);
+
+                if (head == this->cached_tail) {
+                    return nullptr;
+                }
+            }
+
+            return &this->items[head & this->mask];
+        }
+
+        /// Must only be called from the consumer thread after front() returned an element.
+        void pop() {
+            const size_t head = this->head.load(std::memory_order_relaxed);
+
+            assert(head != this->cached_tail);
+
+            this->head.store(head + 1, std::memory_order_release);
+        }
+
+        /// Must only be called from the consumer thread.
+        [[nodiscard]] std::optional<T> try_pop() {
+            T* value = this->front();
+
+            if (value == nullptr) {
+                return std::nullopt;
+            }
+
+            std::optional<T> result(std::move(*value));
+            this->pop();
+
+            return result;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return this->mask + 1;
+        }
+    };
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+
+#include "types.hpp"
+#include "utility.hpp"
+
+namespace imkcpp {
+    /// Snapshot of a connection's counters and state, see ImKcpp::get_stats().
+    struct Stats final {
+        /// Time of the flush which produced this snapshot.
+        u32 timestamp = 0;
+
+        /// Bytes passed to the output callback, including headers.
+        u64 bytes_sent = 0;
+
+        /// Bytes passed to input(), including headers.
+        u64 bytes_received = 0;
+
+        /// PUSH segments sent, including retransmissions.
+        u64 segments_sent = 0;
+
+        /// Retransmissions by cause. Fast retransmissions include time-based (RACK) loss detection.
+        u64 timeout_retransmitted = 0;
+        u64 fast_retransmitted = 0;
+        u64 nack_retransmitted = 0;
+        u64 tail_loss_probes = 0;
+
+        /// Retransmissions found to be unnecessary when the original transmission was acknowledged.
+        u64 spurious_retransmitted = 0;
+
+        /// Segments and payload bytes removed from the send buffer by the remote side's acknowledgements.
+        u64 segments_acked = 0;
+        u64 bytes_acked = 0;
+
+        /// PUSH segments received and the ones dropped as duplicates or out of the receive window.
+        u64 segments_received = 0;
+        u64 segments_dropped = 0;
+
+        u32 srtt = 0;
+        u32 rttvar = 0;
+        u32 rto = 0;
+
+        u32 cwnd = 0;
+        u32 ssthresh = 0;
+        u32 send_window = 0;
+        u32 remote_window = 0;
+        u32 receive_window = 0;
+
+        /// Segments sent but not acknowledged yet.
+        u32 inflight = 0;
+
+        /// Segments waiting for the send window.
+        u32 send_queue = 0;
+
+        /// Out of order segments waiting for the gaps before them to be filled.
+        u32 receive_buffer = 0;
+
+        /// Segments ready to be read by recv().
+        u32 receive_queue = 0;
+
+        /// Smoothed rate at which payload is acknowledged, in bytes per second.
+        double delivery_rate = 0.0;
+
+        /// Smoothed share of sent segments which were retransmissions.
+        double loss_rate = 0.0;
+
+        [[nodiscard]] u64 get_retransmitted() const {
+            return this->timeout_retransmitted + this->fast_retransmitted + this->nack_retransmitted + this->tail_loss_probes;
+        }
+    };
+
+    /**
+     *StatsEstimator turns cumulative counters into smoothed delivery and loss rates.
+     *A sample is taken once per round trip, but at most every MIN_SAMPLE_INTERVAL, and smoothed with an EWMA.
+     */
+    class StatsEstimator final {
+        constexpr static u32 MIN_SAMPLE_INTERVAL = 100;
+        constexpr static double GAIN = 1.0 / 8.0;
+
+        bool started = false;
+        bool sampled = false;
+        u32 sample_start = 0;
+        u64 bytes_acked = 0;
+        u64 segments_sent = 0;
+        u64 retransmitted = 0;
+
+        double delivery_rate = 0.0;
+        double loss_rate = 0.0;
+
+        void restart(const u32 current, const Stats& stats) {
+            this->started = true;
+            this->sample_start = current;
+            this->bytes_acked = stats.bytes_acked;
+            this->segments_sent = stats.segments_sent;
+            this->retransmitted = stats.get_retransmitted();
+        }
+
+    public:
+        /// Updates the estimates from the snapshot's counters and writes them into it.
+        void update(Stats& stats) {
+            if (!this->started) {
+                this->restart(stats.timestamp, stats);
+            }
+
+            const i32 elapsed = time_delta(stats.timestamp, this->sample_start);
+
+            if (elapsed >= static_cast<i32>(std::max(MIN_SAMPLE_INTERVAL, stats.srtt))) {
+                const double delivery_sample = static_cast<double>(stats.bytes_acked - this->bytes_acked) * 1000.0 / elapsed;
+                const u64 sent = stats.segments_sent - this->segments_sent;
+
+                // The first sample initializes the estimate instead of being averaged with zero
+                const double gain = this->sampled ? GAIN : 1.0;
+                this->delivery_rate += gain * (delivery_sample - this->delivery_rate);
+
+                if (sent > 0) {
+                    const double loss_sample = static_cast<double>(stats.get_retransmitted() - this->retransmitted) / static_cast<double>(sent);
+                    this->loss_rate += gain * (loss_sample - this->loss_rate);
+                }
+
+                this->sampled = true;
+                this->restart(stats.timestamp, stats);
+            } else if (elapsed < 0) {
+                this->restart(stats.timestamp, stats);
+            }
+
+            stats.delivery_rate = this->delivery_rate;
+            stats.loss_rate = this->loss_rate;
+        }
+    };
+}
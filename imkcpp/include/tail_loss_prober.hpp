@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include "types.hpp"
+#include "utility.hpp"
+
+namespace imkcpp {
+    /**
+     *TailLossProber decides when the last in-flight segment should be retransmitted early.
+     *When the tail of a message is lost there are no later acks to trigger fast resend,
+     *so instead of waiting for a full RTO we probe after roughly two smoothed RTTs without ack progress.
+     */
+    class TailLossProber final {
+        /// Whether tail loss probes are enabled.
+        bool enabled = false;
+
+        /// Whether a probe has been sent and no ack progress has been observed since.
+        bool probe_outstanding = false;
+
+        /// Timestamp of the last ack progress.
+        u32 ts_last_progress = 0;
+
+    public:
+        void set_enabled(const bool state) {
+            this->enabled = state;
+        }
+
+        [[nodiscard]] bool is_enabled() const {
+            return this->enabled;
+        }
+
+        /// Must be called whenever an ack acknowledges new data. Allows another probe to be sent.
+        void ack_progress(const u32 current) {
+            this->ts_last_progress = current;
+            this->probe_outstanding = false;
+        }
+
+        /// Must be called after a probe has been sent. Only one probe is sent until the next ack progress.
+        void probe_sent() {
+            this->probe_outstanding = true;
+        }
+
+        /// Calculates the probe timeout.
+        [[nodiscard]] static u32 calculate_pto(const u32 srtt, const u32 interval) {
+            // PTO = 2 * SRTT, but never less than a single flush interval since acks are delayed by it.
+            return std::max(2 * srtt, interval);
+        }
+
+        /**
+         *Returns true if the tail segment should be probed.
+         *last_sent is the timestamp of the latest transmission of the tail segment and resendts is its RTO deadline.
+         */
+        [[nodiscard]] bool should_probe(const u32 current, const u32 last_sent, const u32 resendts, const u32 pto) const {
+            if (!this->enabled || this->probe_outstanding) {
+                return false;
+            }
+
+            const u32 reference = time_delta(last_sent, this->ts_last_progress) > 0 ? last_sent : this->ts_last_progress;
+            const u32 deadline = reference + pto;
+
+            // There is no point in probing if the RTO fires first anyway.
+            if (time_delta(resendts, deadline) <= 0) {
+                return false;
+            }
+
+            return time_delta(current, deadline) >= 0;
+        }
+    };
+}
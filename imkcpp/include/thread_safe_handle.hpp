@@ -0,0 +1,121 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <optional>
+
+#include "types.hpp"
+#include "imkcpp.hpp"
+#include "mpsc_queue.hpp"
+#include "spsc_queue.hpp"
+
+namespace imkcpp {
+    struct PumpResult final {
+        /// Messages passed to send().
+        size_t sent_count = 0;
+
+        /// Messages which send() rejected and which have been dropped.
+        size_t send_error_count = 0;
+
+        /// Messages read with recv() and handed to the consumer.
+        size_t received_count = 0;
+    };
+
+    /**
+     *ThreadSafeHandle lets application threads exchange messages with a connection owned by another thread.
+     *Any thread may enqueue outbound messages, and one consumer thread dequeues received messages.
+     *The owning thread, the one calling input() and update(), moves messages between the rings and the connection
+     *in batches with pump(), so neither side takes a lock.
+     */
+    template <size_t MTU>
+    class ThreadSafeHandle final {
+    public:
+        using message_t = std::vector<std::byte>;
+
+        struct Config final {
+            /// Capacity of the outbound ring.
+            size_t send_capacity = 1024;
+
+            /// Capacity of the inbound ring.
+            size_t recv_capacity = 1024;
+
+            /// Outbound messages are left in the ring while this many segments are waiting to be acknowledged.
+            size_t max_waiting_segments = 4096;
+
+            /// Maximum number of messages moved in each direction per pump() call.
+            size_t batch_size = 256;
+        };
+
+    private:
+        Config config;
+        MpscQueue<message_t> outbound;
+        SpscQueue<message_t> inbound;
+
+    public:
+        explicit ThreadSafeHandle(const Config& config = {})
+            : config(config), outbound(config.send_capacity), inbound(config.recv_capacity) { }
+
+        ThreadSafeHandle(const ThreadSafeHandle&) = delete;
+        ThreadSafeHandle& operator=(const ThreadSafeHandle&) = delete;
+
+        /// Enqueues a message to be sent. Can be called from any thread. Returns false if the ring is full.
+        bool try_send(message_t&& message) {
+            return this->outbound.try_push(std::move(message));
+        }
+
+        /// Copies and enqueues a message to be sent. Can be called from any thread. Returns false if the ring is full.
+        bool try_send(const std::span<const std::byte> message) {
+            return this->try_send(message_t(message.begin(), message.end()));
+        }
+
+        /// Dequeues a received message. Must only be called from a single consumer thread.
+        [[nodiscard]] std::optional<message_t> try_recv() {
+            return this->inbound.try_pop();
+        }
+
+        /// Moves queued messages into the connection and received messages out of it. Must be called by the owning thread.
+        PumpResult pump(ImKcpp<MTU>& kcp) {
+            PumpResult result{};
+
+            while (result.sent_count + result.send_error_count < this->config.batch_size &&
+                   kcp.get_waiting_send_count() < this->config.max_waiting_segments) {
+                message_t* message = this->outbound.front();
+
+                if (message == nullptr) {
+                    break;
+                }
+
+                if (kcp.send(*message).has_value()) {
+                    result.sent_count++;
+                } else {
+                    result.send_error_count++;
+                }
+
+                // Release the memory now rather than when the cell is reused
+                *message = message_t{};
+                this->outbound.pop();
+            }
+
+            while (result.received_count < this->config.batch_size && !this->inbound.full()) {
+                const auto size = kcp.peek_size();
+
+                if (!size.has_value()) {
+                    break;
+                }
+
+                message_t message(size.value());
+                const auto received = kcp.recv(message);
+
+                if (!received.has_value()) {
+                    break;
+                }
+
+                message.resize(received.value());
+                this->inbound.try_push(std::move(message));
+                result.received_count++;
+            }
+
+            return result;
+        }
+    };
+}
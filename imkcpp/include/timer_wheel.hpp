@@ -0,0 +1,276 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <optional>
+#include <vector>
+#include <limits>
+#include "types.hpp"
+#include "utility.hpp"
+
+namespace imkcpp {
+    class TimerWheel;
+
+    /// TimerNode is an intrusive node which can be scheduled in a TimerWheel. Objects embedding it must not move while scheduled.
+    class TimerNode {
+        friend class TimerWheel;
+
+        TimerNode* prev = nullptr;
+        TimerNode* next = nullptr;
+        u32 expires = 0;
+        u8 level = 0;
+        u8 slot = 0;
+        bool scheduled = false;
+
+    public:
+        TimerNode() = default;
+        TimerNode(const TimerNode&) = delete;
+        TimerNode& operator=(const TimerNode&) = delete;
+
+        /// Returns true if the node is currently scheduled.
+        [[nodiscard]] bool is_scheduled() const {
+            return this->scheduled;
+        }
+
+        /// Returns the time the node is scheduled for.
+        [[nodiscard]] u32 get_expires() const {
+            return this->expires;
+        }
+    };
+
+    /**
+     *TimerWheel is a hierarchical timing wheel with 1 ms ticks.
+     *Scheduling and cancelling are O(1), advancing costs O(expired nodes) plus a small constant per
+     *level boundary crossed, independently of how many nodes are scheduled in the future.
+     */
+    class TimerWheel final {
+        constexpr static u32 LEVEL_BITS = 6;
+        constexpr static u32 SLOTS = 1u << LEVEL_BITS;
+        constexpr static u32 SLOT_MASK = SLOTS - 1;
+        constexpr static u32 LEVELS = 4;
+
+        /// Nodes further in the future are kept at the last level and cascaded down when it's reached.
+        constexpr static u32 MAX_DELTA = (1u << (LEVEL_BITS * LEVELS)) - 1;
+
+        std::array<std::array<TimerNode*, SLOTS>, LEVELS> slots{};
+
+        /// Bit per slot, set if the slot is not empty.
+        std::array<u64, LEVELS> occupied{};
+
+        /// Next tick to be processed.
+        u32 now = 0;
+
+        /// Number of scheduled nodes.
+        size_t count = 0;
+
+        void link(TimerNode& node) {
+            const i32 delta = time_delta(node.expires, this->now);
+
+            u32 level = 0;
+            u32 slot = 0;
+
+            if (delta < 0) {
+                // Already expired, processed at the next tick
+                slot = this->now & SLOT_MASK;
+            } else {
+                const u32 target = static_cast<u32>(delta) > MAX_DELTA ? this->now + MAX_DELTA : node.expires;
+                const u32 distance = target - this->now;
+
+                while (level < LEVELS - 1 && distance >= (1u << (LEVEL_BITS * (level + 1)))) {
+                    ++level;
+                }
+
+                slot = (target >> (LEVEL_BITS * level)) & SLOT_MASK;
+            }
+
+            node.level = static_cast<u8>(level);
+            node.slot = static_cast<u8>(slot);
+            node.prev = nullptr;
+            node.next = this->slots[level][slot];
+
+            if (node.next != nullptr) {
+                node.next->prev = &node;
+            }
+
+            this->slots[level][slot] = &node;
+            this->occupied[level] |= static_cast<u64>(1) << slot;
+        }
+
+        void unlink(TimerNode& node) {
+            if (node.prev != nullptr) {
+                node.prev->next = node.next;
+            } else {
+                this->slots[node.level][node.slot] = node.next;
+            }
+
+            if (node.next != nullptr) {
+                node.next->prev = node.prev;
+            }
+
+            if (this->slots[node.level][node.slot] == nullptr) {
+                this->occupied[node.level] &= ~(static_cast<u64>(1) << node.slot);
+            }
+
+            node.prev = nullptr;
+            node.next = nullptr;
+        }
+
+        /// Detaches all nodes of a slot and returns the head of the detached list.
+        TimerNode* take(const u32 level, const u32 slot) {
+            TimerNode* head = this->slots[level][slot];
+
+            this->slots[level][slot] = nullptr;
+            this->occupied[level] &= ~(static_cast<u64>(1) << slot);
+
+            return head;
+        }
+
+        /// Moves nodes of the current slot of the given level (and higher levels, if they wrap too) down.
+        void cascade(const u32 level) {
+            if (level >= LEVELS) {
+                return;
+            }
+
+            const u32 slot = (this->now >> (LEVEL_BITS * level)) & SLOT_MASK;
+
+            if (slot == 0) {
+                this->cascade(level + 1);
+            }
+
+            TimerNode* node = this->take(level, slot);
+
+            while (node != nullptr) {
+                TimerNode* next = node->next;
+                this->link(*node);
+                node = next;
+            }
+        }
+
+    public:
+        explicit TimerWheel(const u32 start = 0) : now(start) { }
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        /// Schedules the node to expire at the given time. Reschedules it if it's already scheduled.
+        void schedule(TimerNode& node, const u32 expires) {
+            if (node.scheduled) {
+                this->unlink(node);
+            } else {
+                node.scheduled = true;
+                ++this->count;
+            }
+
+            node.expires = expires;
+            this->link(node);
+        }
+
+        /// Removes the node from the wheel if it's scheduled.
+        void cancel(TimerNode& node) {
+            if (!node.scheduled) {
+                return;
+            }
+
+            this->unlink(node);
+            node.scheduled = false;
+            --this->count;
+        }
+
+        /// Processes all ticks up to and including current, appending expired nodes to the given vector.
+        void advance(const u32 current, std::vector<TimerNode*>& expired) {
+            while (time_delta(current, this->now) >= 0) {
+                if (this->count == 0) {
+                    this->now = current + 1;
+                    return;
+                }
+
+                if ((this->now & SLOT_MASK) == 0) {
+                    this->cascade(1);
+                }
+
+                // Find the lowest level which has anything scheduled. Nothing can expire until its next boundary.
+                u32 level = 0;
+                while (level < LEVELS && this->occupied[level] == 0) {
+                    ++level;
+                }
+
+                if (level > 0) {
+                    const u32 boundary_mask = level < LEVELS ? (1u << (LEVEL_BITS * level)) - 1 : std::numeric_limits<u32>::max();
+                    const u32 boundary = (this->now | boundary_mask) + 1;
+
+                    if (time_delta(boundary, current) > 0) {
+                        this->now = current + 1;
+                        return;
+                    }
+
+                    this->now = boundary;
+                    continue;
+                }
+
+                TimerNode* node = this->take(0, this->now & SLOT_MASK);
+
+                while (node != nullptr) {
+                    TimerNode* next = node->next;
+
+                    node->prev = nullptr;
+                    node->next = nullptr;
+                    node->scheduled = false;
+                    --this->count;
+
+                    expired.push_back(node);
+                    node = next;
+                }
+
+                ++this->now;
+            }
+        }
+
+        /**
+         *Returns a time no later than the earliest expiry, or nothing if no node is scheduled.
+         *Exact for nodes expiring within the current level 0 rotation, otherwise the next cascade boundary.
+         */
+        [[nodiscard]] std::optional<u32> next_expiry() const {
+            if (this->count == 0) {
+                return std::nullopt;
+            }
+
+            std::optional<u32> result{};
+
+            if (this->occupied[0] != 0) {
+                // Slots are ordered starting from the current one
+                const u32 index = this->now & SLOT_MASK;
+                result = this->now + static_cast<u32>(std::countr_zero(std::rotr(this->occupied[0], static_cast<int>(index))));
+            }
+
+            for (u32 level = 1; level < LEVELS; ++level) {
+                if (this->occupied[level] == 0) {
+                    continue;
+                }
+
+                const u32 boundary = (this->now | ((1u << (LEVEL_BITS * level)) - 1)) + 1;
+
+                if (!result.has_value() || time_delta(boundary, result.value()) < 0) {
+                    result = boundary;
+                }
+
+                break;
+            }
+
+            return result;
+        }
+
+        /// Returns the next tick to be processed.
+        [[nodiscard]] u32 get_now() const {
+            return this->now;
+        }
+
+        /// Returns the number of scheduled nodes.
+        [[nodiscard]] size_t size() const {
+            return this->count;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return this->count == 0;
+        }
+    };
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+
+#include "types.hpp"
+#include "types/cmd.hpp"
+
+namespace imkcpp {
+    enum class RetransmitCause : u8 {
+        Timeout,
+        Fast,
+        Nack,
+        TailLossProbe,
+    };
+
+    /**
+     *Tracers observe protocol events of a connection, see ImKcpp's Tracer template parameter.
+     *Hooks are called synchronously from the thread driving the connection, current is the connection's clock.
+     *Tracers with enabled == false are never called, so arguments aren't even computed.
+     */
+    template <typename T>
+    concept TracerPolicy = requires(T& t, const u32 u, const RetransmitCause cause, const Cmd cmd) {
+        { T::enabled } -> std::convertible_to<bool>;
+        // A new segment was sent for the first time
+        { t.segment_sent(u, u, u) };
+        // A segment was sent again, xmit is its transmission count
+        { t.segment_retransmitted(u, u, cause, u) };
+        // An ACK removed an in-flight segment, rtt is measured from its latest transmission
+        { t.ack_received(u, u, u) };
+        // The first unacknowledged sequence number moved forward
+        { t.una_advanced(u, u) };
+        // The congestion window or slow start threshold changed
+        { t.cwnd_changed(u, u, u) };
+        // A WASK or WINS command was sent (sent == 1) or received (sent == 0)
+        { t.window_probe(u, cmd, u) };
+    };
+
+    /// Default tracer. Has no state and no effect, so it compiles away completely.
+    struct NoopTracer final {
+        constexpr static bool enabled = false;
+
+        void segment_sent(u32, u32, u32) { }
+        void segment_retransmitted(u32, u32, RetransmitCause, u32) { }
+        void ack_received(u32, u32, u32) { }
+        void una_advanced(u32, u32) { }
+        void cwnd_changed(u32, u32, u32) { }
+        void window_probe(u32, Cmd, u32) { }
+    };
+
+    static_assert(TracerPolicy<NoopTracer>);
+
+    enum class TraceEvent : u8 {
+        SegmentSent,
+        SegmentRetransmitted,
+        AckReceived,
+        UnaAdvanced,
+        CwndChanged,
+        WindowProbe,
+    };
+
+    /// Compact binary trace record. The meaning of the fields depends on the event.
+    struct TraceRecord final {
+        u32 time = 0;
+
+        /// Sequence number, una or cwnd.
+        u32 a = 0;
+
+        /// Length, xmit, rtt, ssthresh or whether a probe was sent.
+        u32 b = 0;
+
+        TraceEvent event = TraceEvent::SegmentSent;
+
+        /// RetransmitCause or probe command.
+        u8 detail = 0;
+    };
+
+    static_assert(sizeof(TraceRecord) == 16);
+
+    /**
+     *RingBufferTracer records events into a fixed size ring buffer, overwriting the oldest ones.
+     *It doesn't allocate, so it can stay enabled under load and be dumped when something goes wrong.
+     */
+    template <size_t Capacity>
+    class RingBufferTracer final {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        std::array<TraceRecord, Capacity> records{};
+        u64 written = 0;
+
+        void record(const TraceEvent event, const u32 time, const u32 a, const u32 b, const u8 detail = 0) {
+            this->records[this->written & (Capacity - 1)] = TraceRecord{ time, a, b, event, detail };
+            this->written++;
+        }
+
+    public:
+        constexpr static bool enabled = true;
+
+        void segment_sent(const u32 current, const u32 sn, const u32 len) {
+            this->record(TraceEvent::SegmentSent, current, sn, len);
+        }
+
+        void segment_retransmitted(const u32 current, const u32 sn, const RetransmitCause cause, const u32 xmit) {
+            this->record(TraceEvent::SegmentRetransmitted, current, sn, xmit, static_cast<u8>(cause));
+        }
+
+        void ack_received(const u32 current, const u32 sn, const u32 rtt) {
+            this->record(TraceEvent::AckReceived, current, sn, rtt);
+        }
+
+        void una_advanced(const u32 current, const u32 una) {
+            this->record(TraceEvent::UnaAdvanced, current, una, 0);
+        }
+
+        void cwnd_changed(const u32 current, const u32 cwnd, const u32 ssthresh) {
+            this->record(TraceEvent::CwndChanged, current, cwnd, ssthresh);
+        }
+
+        void window_probe(const u32 current, const Cmd cmd, const u32 sent) {
+            this->record(TraceEvent::WindowProbe, current, sent, 0, cmd.get());
+        }
+
+        /// Calls the function for every retained record, oldest first.
+        template <typename F>
+        void for_each(F&& fn) const {
+            const u64 first = this->written > Capacity ? this->written - Capacity : 0;
+
+            for (u64 i = first; i < this->written; ++i) {
+                fn(this->records[i & (Capacity - 1)]);
+            }
+        }
+
+        /// Returns the number of retained records.
+        [[nodiscard]] size_t size() const {
+            return static_cast<size_t>(std::min<u64>(this->written, Capacity));
+        }
+
+        /// Returns the number of records which were overwritten.
+        [[nodiscard]] u64 get_overwritten() const {
+            return this->written - this->size();
+        }
+
+        void clear() {
+            this->written = 0;
+        }
+    };
+}
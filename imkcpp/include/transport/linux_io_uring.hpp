@@ -0,0 +1,785 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "../third_party/expected.hpp"
+#include "../types.hpp"
+#include "../errors.hpp"
+#include "../session_manager.hpp"
+#include "linux_udp.hpp"
+
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace imkcpp::transport {
+    namespace detail {
+        /// Minimal io_uring instance using the raw system calls, so that there is no dependency on liburing.
+        class IoUring final {
+            int fd = -1;
+            io_uring_params params{};
+
+            void* sq_ring = MAP_FAILED;
+            size_t sq_ring_size = 0;
+            void* cq_ring = MAP_FAILED;
+            size_t cq_ring_size = 0;
+            io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+            size_t sqes_size = 0;
+
+            u32* sq_head = nullptr;
+            u32* sq_tail = nullptr;
+            u32 sq_mask = 0;
+            u32* cq_head = nullptr;
+            u32* cq_tail = nullptr;
+            u32 cq_mask = 0;
+            io_uring_cqe* cqes = nullptr;
+
+            /// Submission queue entries filled since the last submit.
+            u32 pending = 0;
+
+            /// Number of io_uring_enter calls.
+            size_t enter_count = 0;
+
+            template <typename T>
+            [[nodiscard]] static T* at(void* base, const u32 offset) {
+                return reinterpret_cast<T*>(static_cast<std::byte*>(base) + offset);
+            }
+
+        public:
+            IoUring() = default;
+            IoUring(const IoUring&) = delete;
+            IoUring& operator=(const IoUring&) = delete;
+
+            ~IoUring() {
+                if (this->sqes != MAP_FAILED) {
+                    ::munmap(this->sqes, this->sqes_size);
+                }
+
+                if (this->cq_ring != MAP_FAILED && this->cq_ring != this->sq_ring) {
+                    ::munmap(this->cq_ring, this->cq_ring_size);
+                }
+
+                if (this->sq_ring != MAP_FAILED) {
+                    ::munmap(this->sq_ring, this->sq_ring_size);
+                }
+
+                if (this->fd >= 0) {
+                    ::close(this->fd);
+                }
+            }
+
+            [[nodiscard]] bool init(const u32 entries) {
+                this->params = {};
+                this->params.flags = IORING_SETUP_CLAMP;
+
+                this->fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &this->params));
+
+                if (this->fd < 0) {
+                    return false;
+                }
+
+                const auto& sq = this->params.sq_off;
+                const auto& cq = this->params.cq_off;
+
+                this->sq_ring_size = sq.array + this->params.sq_entries * sizeof(u32);
+                this->cq_ring_size = cq.cqes + this->params.cq_entries * sizeof(io_uring_cqe);
+
+                const bool single_mmap = (this->params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+                if (single_mmap) {
+                    this->sq_ring_size = this->cq_ring_size = std::max(this->sq_ring_size, this->cq_ring_size);
+                }
+
+                this->sq_ring = ::mmap(nullptr, this->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+
+                if (this->sq_ring == MAP_FAILED) {
+                    return false;
+                }
+
+                this->cq_ring = single_mmap
+                    ? this->sq_ring
+                    : ::mmap(nullptr, this->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+
+                if (this->cq_ring == MAP_FAILED) {
+                    return false;
+                }
+
+                this->sqes_size = this->params.sq_entries * sizeof(io_uring_sqe);
+                this->sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQES));
+
+                if (this->sqes == MAP_FAILED) {
+                    return false;
+                }
+
+                this->sq_head = at<u32>(this->sq_ring, sq.head);
+                this->sq_tail = at<u32>(this->sq_ring, sq.tail);
+                this->sq_mask = *at<u32>(this->sq_ring, sq.ring_mask);
+                this->cq_head = at<u32>(this->cq_ring, cq.head);
+                this->cq_tail = at<u32>(this->cq_ring, cq.tail);
+                this->cq_mask = *at<u32>(this->cq_ring, cq.ring_mask);
+                this->cqes = at<io_uring_cqe>(this->cq_ring, cq.cqes);
+
+                // Submission entries are always used in ring order, so the indirection array is the identity
+                u32* array = at<u32>(this->sq_ring, sq.array);
+                for (u32 i = 0; i < this->params.sq_entries; ++i) {
+                    array[i] = i;
+                }
+
+                return true;
+            }
+
+            /// Returns a zeroed submission entry, submitting pending ones first if the queue is full.
+            [[nodiscard]] io_uring_sqe* get_sqe() {
+                u32 tail = std::atomic_ref(*this->sq_tail).load(std::memory_order_relaxed);
+
+                if (tail - std::atomic_ref(*this->sq_head).load(std::memory_order_acquire) >= this->params.sq_entries) {
+                    this->submit(0);
+
+                    if (tail - std::atomic_ref(*this->sq_head).load(std::memory_order_acquire) >= this->params.sq_entries) {
+                        return nullptr;
+                    }
+                }
+
+                io_uring_sqe* sqe = &this->sqes[tail & this->sq_mask];
+                *sqe = {};
+
+                std::atomic_ref(*this->sq_tail).store(tail + 1, std::memory_order_release);
+                ++this->pending;
+
+                return sqe;
+            }
+
+            /// Submits pending entries and optionally waits for completions. Returns the result of io_uring_enter.
+            int submit(const u32 wait_nr) {
+                const u32 to_submit = this->pending;
+                this->pending = 0;
+
+                if (to_submit == 0 && wait_nr == 0) {
+                    return 0;
+                }
+
+                const u32 flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+                ++this->enter_count;
+
+                return static_cast<int>(::syscall(__NR_io_uring_enter, this->fd, to_submit, wait_nr, flags, nullptr, 0));
+            }
+
+            /// Calls the function for every available completion and consumes them. Returns the number of completions.
+            template <typename F>
+            u32 for_each_cqe(F&& fn) {
+                u32 head = std::atomic_ref(*this->cq_head).load(std::memory_order_relaxed);
+                const u32 tail = std::atomic_ref(*this->cq_tail).load(std::memory_order_acquire);
+                const u32 count = tail - head;
+
+                for (; head != tail; ++head) {
+                    fn(this->cqes[head & this->cq_mask]);
+                }
+
+                std::atomic_ref(*this->cq_head).store(tail, std::memory_order_release);
+
+                return count;
+            }
+
+            [[nodiscard]] size_t get_enter_count() const {
+                return this->enter_count;
+            }
+
+            [[nodiscard]] int register_resource(const u32 opcode, const void* arg, const u32 count) const {
+                return static_cast<int>(::syscall(__NR_io_uring_register, this->fd, opcode, arg, count));
+            }
+        };
+    }
+
+    struct IoUringConfig final {
+        /// Local address to bind to. Port 0 picks a free port.
+        UdpAddress bind_address = UdpAddress::ipv4("0.0.0.0", 0).value();
+
+        /// Submission queue size.
+        u32 entries = 256;
+
+        /// Number of receive buffers in the provided buffer ring. Must be a power of two.
+        u16 recv_buffers = 256;
+
+        /// Number of send buffers, i.e. datagrams which can be in flight in the kernel.
+        u32 send_buffers = 256;
+
+        /// SO_RCVBUF and SO_SNDBUF size, 0 keeps the system default.
+        int socket_buffer_size = 4 * 1024 * 1024;
+
+        /// Whether datagrams with an unknown conv create a new connection.
+        bool accept_connections = false;
+    };
+
+    /// Cumulative transport counters.
+    struct IoUringStats final {
+        size_t datagrams_received = 0;
+        size_t datagrams_sent = 0;
+
+        /// Datagrams which were not sent because no send buffer was free or the send failed.
+        size_t datagrams_dropped = 0;
+
+        /// Datagrams which could not be routed to a connection.
+        size_t datagrams_rejected = 0;
+
+        /// Calls to io_uring_enter.
+        size_t enter_syscalls = 0;
+
+        /// Times the multishot receive had to be armed again, e.g. because buffers ran out.
+        size_t recv_rearms = 0;
+
+        /// Times arming the receive failed because the submission queue was full. It's retried before the next submit.
+        size_t recv_arm_failures = 0;
+    };
+
+    /**
+     *IoUringTransport drives connections over a UDP socket with io_uring.
+     *A multishot receive stays armed and the kernel picks buffers from a provided buffer ring, input() parses directly
+     *out of them before they are handed back. Output is copied into preallocated send buffers and submitted in batches,
+     *and check() deadlines are waited for with io_uring timeouts, so a busy loop needs one system call per poll().
+     *It's not thread-safe, use one transport per thread.
+     */
+    template <size_t MTU>
+    class IoUringTransport final {
+    public:
+        using receive_callback_t = std::function<void(IoUringTransport&, Conv)>;
+        using accept_callback_t = std::function<void(IoUringTransport&, Conv, ImKcpp<MTU>&)>;
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        enum Tag : u64 {
+            TAG_RECV = 1ull << 62,
+            TAG_SEND = 2ull << 62,
+            TAG_TIMEOUT = 3ull << 62,
+            TAG_MASK = 3ull << 62,
+        };
+
+        /// Updates of the armed timeout, only completed when they fail.
+        constexpr static u64 TIMEOUT_UPDATE = TAG_TIMEOUT | 1;
+
+        constexpr static u16 BUFFER_GROUP = 0;
+
+        /// Room for the recvmsg header, the source address and the payload.
+        constexpr static size_t RECV_BUFFER_SIZE = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage) + MTU;
+
+        struct SendSlot final {
+            msghdr header{};
+            iovec iov{};
+            UdpAddress peer{};
+        };
+
+        IoUringConfig config;
+        int socket_fd = -1;
+        std::unique_ptr<detail::IoUring> ring = std::make_unique<detail::IoUring>();
+
+        SessionManager<MTU> sessions{};
+        std::unordered_map<Conv::UT, UdpAddress> peers{};
+
+        receive_callback_t receive_callback{};
+        accept_callback_t accept_callback{};
+
+        clock::time_point start = clock::now();
+        IoUringStats stats{};
+
+        // Provided receive buffers
+        void* buffer_ring = MAP_FAILED;
+        size_t buffer_ring_size = 0;
+        u16 buffer_ring_tail = 0;
+        std::vector<std::byte> recv_storage{};
+        msghdr recv_template{};
+
+        // Send buffers, a plain sendmsg copies them into the socket, so they aren't registered with the ring
+        std::vector<std::byte> send_storage{};
+        std::vector<SendSlot> send_slots{};
+        std::vector<u32> free_send_slots{};
+
+        /// Completions reaped while reclaiming send buffers, handled by the next process_completions().
+        std::vector<io_uring_cqe> deferred_completions{};
+
+        __kernel_timespec timeout{};
+        bool timeout_armed = false;
+
+        /// Whether the multishot receive is armed, nothing is received while it isn't.
+        bool recv_armed = false;
+
+        explicit IoUringTransport(const IoUringConfig& config) : config(config) { }
+
+        [[nodiscard]] io_uring_buf* buffer_entries() const {
+            return static_cast<io_uring_buf*>(this->buffer_ring);
+        }
+
+        /// Queues a receive buffer to be handed to the kernel with the next commit_buffers().
+        void recycle_buffer(const u16 bid) {
+            io_uring_buf& entry = this->buffer_entries()[this->buffer_ring_tail & (this->config.recv_buffers - 1)];
+
+            entry.addr = reinterpret_cast<u64>(this->recv_storage.data() + static_cast<size_t>(bid) * RECV_BUFFER_SIZE);
+            entry.len = RECV_BUFFER_SIZE;
+            entry.bid = bid;
+
+            ++this->buffer_ring_tail;
+        }
+
+        void commit_buffers() {
+            // The ring tail overlays the reserved field of the first entry
+            auto* tail = reinterpret_cast<u16*>(reinterpret_cast<std::byte*>(this->buffer_ring) + offsetof(io_uring_buf, resv));
+            std::atomic_ref(*tail).store(this->buffer_ring_tail, std::memory_order_release);
+        }
+
+        [[nodiscard]] error open_ring() {
+            this->socket_fd = ::socket(this->config.bind_address.storage.ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+            if (this->socket_fd < 0) {
+                return error::socket_error;
+            }
+
+            if (const int size = this->config.socket_buffer_size; size > 0) {
+                ::setsockopt(this->socket_fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+                ::setsockopt(this->socket_fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+            }
+
+            if (::bind(this->socket_fd, this->config.bind_address.get(), this->config.bind_address.length) != 0) {
+                return error::socket_error;
+            }
+
+            if (!this->ring->init(this->config.entries)) {
+                return error::socket_error;
+            }
+
+            // Provided buffer ring
+            const u16 count = this->config.recv_buffers;
+
+            if (count == 0 || (count & (count - 1)) != 0) {
+                return error::socket_error;
+            }
+
+            this->buffer_ring_size = static_cast<size_t>(count) * sizeof(io_uring_buf);
+            this->buffer_ring = ::mmap(nullptr, this->buffer_ring_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+            if (this->buffer_ring == MAP_FAILED) {
+                return error::socket_error;
+            }
+
+            io_uring_buf_reg reg{};
+            reg.ring_addr = reinterpret_cast<u64>(this->buffer_ring);
+            reg.ring_entries = count;
+            reg.bgid = BUFFER_GROUP;
+
+            if (this->ring->register_resource(IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+                return error::socket_error;
+            }
+
+            this->recv_storage.resize(static_cast<size_t>(count) * RECV_BUFFER_SIZE);
+
+            for (u16 bid = 0; bid < count; ++bid) {
+                this->recycle_buffer(bid);
+            }
+
+            this->commit_buffers();
+
+            // Send buffers
+            this->send_storage.resize(static_cast<size_t>(this->config.send_buffers) * MTU);
+            this->send_slots.resize(this->config.send_buffers);
+            this->free_send_slots.reserve(this->config.send_buffers);
+
+            for (u32 i = this->config.send_buffers; i > 0; --i) {
+                this->free_send_slots.push_back(i - 1);
+            }
+
+            // Every deferred receive holds a buffer, the rest are the odd receive termination or timeout
+            this->deferred_completions.reserve(static_cast<size_t>(count) + 4);
+
+            this->recv_template.msg_namelen = sizeof(sockaddr_storage);
+
+            if (!this->arm_recv()) {
+                return error::socket_error;
+            }
+
+            this->recv_armed = true;
+
+            return error::none;
+        }
+
+        [[nodiscard]] bool arm_recv() {
+            io_uring_sqe* sqe = this->ring->get_sqe();
+
+            if (sqe == nullptr) {
+                return false;
+            }
+
+            sqe->opcode = IORING_OP_RECVMSG;
+            sqe->fd = this->socket_fd;
+            sqe->addr = reinterpret_cast<u64>(&this->recv_template);
+            sqe->len = 1;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = BUFFER_GROUP;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->user_data = TAG_RECV;
+
+            return true;
+        }
+
+        [[nodiscard]] u32 now() const {
+            return static_cast<u32>(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - this->start).count());
+        }
+
+        void rearm_recv() {
+            this->recv_armed = this->arm_recv();
+
+            if (!this->recv_armed) {
+                this->stats.recv_arm_failures++;
+            }
+        }
+
+        int enter(const u32 wait_nr) {
+            if (!this->recv_armed) {
+                this->rearm_recv();
+            }
+
+            const int result = this->ring->submit(wait_nr);
+            this->stats.enter_syscalls = this->ring->get_enter_count();
+
+            return result;
+        }
+
+        void queue_send(const Conv conv, const std::span<const std::byte> data) {
+            const auto peer = this->peers.find(conv.get());
+
+            if (peer == this->peers.end()) {
+                return;
+            }
+
+            if (this->free_send_slots.empty()) {
+                // Reclaim buffers of completed sends. This runs inside the output callback of a connection, so received
+                // datagrams are left for process_completions(), their input could erase segments being flushed.
+                this->enter(0);
+                this->ring->for_each_cqe([this](const io_uring_cqe& cqe) {
+                    if ((cqe.user_data & TAG_MASK) == TAG_SEND) {
+                        this->complete_send(cqe);
+                    } else {
+                        this->deferred_completions.push_back(cqe);
+                    }
+                });
+
+                if (this->free_send_slots.empty()) {
+                    this->stats.datagrams_dropped++;
+                    return;
+                }
+            }
+
+            io_uring_sqe* sqe = this->ring->get_sqe();
+
+            if (sqe == nullptr) {
+                this->stats.datagrams_dropped++;
+                return;
+            }
+
+            const u32 index = this->free_send_slots.back();
+            this->free_send_slots.pop_back();
+
+            std::byte* buffer = this->send_storage.data() + static_cast<size_t>(index) * MTU;
+            std::memcpy(buffer, data.data(), data.size());
+
+            SendSlot& slot = this->send_slots[index];
+            slot.peer = peer->second;
+            slot.iov = { buffer, data.size() };
+            slot.header = {};
+            slot.header.msg_name = &slot.peer.storage;
+            slot.header.msg_namelen = slot.peer.length;
+            slot.header.msg_iov = &slot.iov;
+            slot.header.msg_iovlen = 1;
+
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = this->socket_fd;
+            sqe->addr = reinterpret_cast<u64>(&slot.header);
+            sqe->len = 1;
+            sqe->user_data = TAG_SEND | index;
+        }
+
+        void receive_datagram(const std::span<const std::byte> data, const sockaddr_storage& address, const socklen_t length) {
+            const std::optional<Conv> conv = peek_conv(data);
+
+            if (!conv.has_value()) {
+                this->stats.datagrams_rejected++;
+                return;
+            }
+
+            if (this->sessions.find(conv.value()) == nullptr) {
+                if (!this->config.accept_connections) {
+                    this->stats.datagrams_rejected++;
+                    return;
+                }
+
+                const auto kcp = this->sessions.create(conv.value());
+
+                // Only a valid first datagram opens a connection, anything else would leave a session behind
+                if (!this->sessions.input(data).has_value()) {
+                    this->sessions.remove(conv.value());
+                    this->stats.datagrams_rejected++;
+                    return;
+                }
+
+                this->peers[conv.value().get()] = UdpAddress{ address, length };
+
+                if (this->accept_callback) {
+                    this->accept_callback(*this, conv.value(), *kcp.value());
+                }
+            } else if (!this->sessions.input(data).has_value()) {
+                this->stats.datagrams_rejected++;
+                return;
+            }
+
+            if (this->receive_callback) {
+                this->receive_callback(*this, conv.value());
+            }
+        }
+
+        void handle_recv(const io_uring_cqe& cqe) {
+            if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+                // The multishot receive has terminated, e.g. with -ENOBUFS when all buffers are in use
+                this->stats.recv_rearms++;
+                this->rearm_recv();
+            }
+
+            if (cqe.res < 0 || (cqe.flags & IORING_CQE_F_BUFFER) == 0) {
+                return;
+            }
+
+            const auto bid = static_cast<u16>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            const std::byte* buffer = this->recv_storage.data() + static_cast<size_t>(bid) * RECV_BUFFER_SIZE;
+
+            io_uring_recvmsg_out out{};
+            std::memcpy(&out, buffer, sizeof(out));
+
+            this->stats.datagrams_received++;
+
+            // Layout: header, name (msg_namelen of the template), control, payload
+            const std::byte* name = buffer + sizeof(io_uring_recvmsg_out);
+            const std::byte* payload = name + this->recv_template.msg_namelen + this->recv_template.msg_controllen;
+
+            if ((out.flags & MSG_TRUNC) != 0 || out.payloadlen > MTU) {
+                this->stats.datagrams_rejected++;
+            } else {
+                sockaddr_storage address{};
+                const socklen_t length = std::min<socklen_t>(out.namelen, sizeof(sockaddr_storage));
+                std::memcpy(&address, name, length);
+
+                this->receive_datagram(std::span(payload, out.payloadlen), address, length);
+            }
+
+            this->recycle_buffer(bid);
+        }
+
+        void complete_send(const io_uring_cqe& cqe) {
+            this->free_send_slots.push_back(static_cast<u32>(cqe.user_data & ~TAG_MASK));
+
+            if (cqe.res < 0) {
+                this->stats.datagrams_dropped++;
+            } else {
+                this->stats.datagrams_sent++;
+            }
+        }
+
+        void handle_completion(const io_uring_cqe& cqe) {
+            switch (cqe.user_data & TAG_MASK) {
+                case TAG_RECV: {
+                    this->handle_recv(cqe);
+                    break;
+                }
+                case TAG_SEND: {
+                    this->complete_send(cqe);
+                    break;
+                }
+                case TAG_TIMEOUT: {
+                    // A failed update, e.g. because the timeout has just fired, its own completion follows
+                    if (cqe.user_data != TIMEOUT_UPDATE) {
+                        this->timeout_armed = false;
+                    }
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+        }
+
+        void process_completions() {
+            const u16 tail_before = this->buffer_ring_tail;
+
+            // Deferred completions are older than the ones still in the ring
+            for (const io_uring_cqe& cqe : this->deferred_completions) {
+                this->handle_completion(cqe);
+            }
+
+            this->deferred_completions.clear();
+
+            this->ring->for_each_cqe([this](const io_uring_cqe& cqe) {
+                this->handle_completion(cqe);
+            });
+
+            if (this->buffer_ring_tail != tail_before) {
+                this->commit_buffers();
+            }
+        }
+
+        /// Arms a timeout which completes after the given time or as soon as anything else completes.
+        void arm_timeout(const u32 milliseconds) {
+            this->timeout.tv_sec = milliseconds / 1000;
+            this->timeout.tv_nsec = static_cast<long long>(milliseconds % 1000) * 1000000;
+
+            io_uring_sqe* sqe = this->ring->get_sqe();
+
+            if (sqe == nullptr) {
+                return;
+            }
+
+            if (this->timeout_armed) {
+                sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+                sqe->addr = TAG_TIMEOUT;
+                sqe->addr2 = reinterpret_cast<u64>(&this->timeout);
+                sqe->timeout_flags = IORING_TIMEOUT_UPDATE;
+                sqe->user_data = TIMEOUT_UPDATE;
+
+                // A successful update posts no completion, which would otherwise end the wait for one right away
+                sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+
+                return;
+            }
+
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->addr = reinterpret_cast<u64>(&this->timeout);
+            sqe->len = 1;
+            sqe->off = 1;
+            sqe->user_data = TAG_TIMEOUT;
+
+            this->timeout_armed = true;
+        }
+
+    public:
+        /// Sets up the ring and the socket. Fails with socket_error if the kernel lacks the required io_uring features (6.0+).
+        [[nodiscard]] static tl::expected<std::unique_ptr<IoUringTransport>, error> open(const IoUringConfig& config) {
+            std::unique_ptr<IoUringTransport> transport(new IoUringTransport(config));
+
+            if (const error err = transport->open_ring(); err != error::none) {
+                return tl::unexpected(err);
+            }
+
+            return transport;
+        }
+
+        IoUringTransport(const IoUringTransport&) = delete;
+        IoUringTransport& operator=(const IoUringTransport&) = delete;
+
+        ~IoUringTransport() {
+            // Closing the socket cancels the receive, the ring is torn down before the buffers it points to
+            if (this->socket_fd >= 0) {
+                ::close(this->socket_fd);
+            }
+
+            this->ring.reset();
+
+            if (this->buffer_ring != MAP_FAILED) {
+                ::munmap(this->buffer_ring, this->buffer_ring_size);
+            }
+        }
+
+        void set_receive_callback(receive_callback_t callback) {
+            this->receive_callback = std::move(callback);
+        }
+
+        /// Called for every accepted connection, after its first datagram has been input and before it is first updated.
+        void set_accept_callback(accept_callback_t callback) {
+            this->accept_callback = std::move(callback);
+        }
+
+        /// Creates a connection to the given peer.
+        [[nodiscard]] tl::expected<ImKcpp<MTU>*, error> connect(const Conv conv, const UdpAddress& peer) {
+            auto kcp = this->sessions.create(conv);
+
+            if (kcp.has_value()) {
+                this->peers[conv.get()] = peer;
+            }
+
+            return kcp;
+        }
+
+        /// Removes the connection.
+        bool close(const Conv conv) {
+            this->peers.erase(conv.get());
+            return this->sessions.remove(conv);
+        }
+
+        /// Sends data on the connection. Connections must be written through the transport so that they are scheduled.
+        tl::expected<size_t, error> send(const Conv conv, const std::span<const std::byte> buffer) {
+            return this->sessions.send(conv, buffer);
+        }
+
+        /// Reads data from the connection.
+        tl::expected<size_t, error> recv(const Conv conv, const std::span<std::byte> buffer) {
+            return this->sessions.recv(conv, buffer);
+        }
+
+        [[nodiscard]] ImKcpp<MTU>* find(const Conv conv) {
+            return this->sessions.find(conv);
+        }
+
+        void wake(const Conv conv) {
+            this->sessions.wake(conv);
+        }
+
+        /**
+         *Waits up to max_wait_ms for completions or the next connection deadline, whichever comes first,
+         *then processes received datagrams, updates due connections and submits their output.
+         */
+        void poll(const u32 max_wait_ms) {
+            this->process_completions();
+
+            u32 current = this->now();
+            u32 wait = max_wait_ms;
+
+            if (const std::optional<u32> next = this->sessions.next_update_time(); next.has_value()) {
+                wait = static_cast<u32>(std::clamp(time_delta(next.value(), current), 0, static_cast<i32>(wait)));
+            }
+
+            if (wait > 0) {
+                this->arm_timeout(wait);
+                this->enter(1);
+            } else {
+                this->enter(0);
+            }
+
+            this->process_completions();
+
+            current = this->now();
+            this->sessions.update(current, [this](const Conv conv, const std::span<const std::byte> data) {
+                this->queue_send(conv, data);
+            });
+
+            this->enter(0);
+        }
+
+        /// Returns the locally bound address.
+        [[nodiscard]] UdpAddress local_address() const {
+            UdpAddress address;
+            address.length = sizeof(address.storage);
+            ::getsockname(this->socket_fd, reinterpret_cast<sockaddr*>(&address.storage), &address.length);
+
+            return address;
+        }
+
+        [[nodiscard]] const IoUringStats& get_stats() const {
+            return this->stats;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,594 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "../third_party/expected.hpp"
+#include "../types.hpp"
+#include "../errors.hpp"
+#include "../session_manager.hpp"
+
+// Included after the library headers, glibc may define htons / htonl as macros which clash with imkcpp::endian
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace imkcpp::transport {
+    /// Address of a UDP peer.
+    struct UdpAddress final {
+        sockaddr_storage storage{};
+        socklen_t length = 0;
+
+        /// Creates an IPv4 address from dotted notation. Returns nothing if it can't be parsed.
+        [[nodiscard]] static std::optional<UdpAddress> ipv4(const char* host, const u16 port) {
+            UdpAddress address;
+            auto* in = reinterpret_cast<sockaddr_in*>(&address.storage);
+
+            in->sin_family = AF_INET;
+            in->sin_port = htons(port);
+
+            if (inet_pton(AF_INET, host, &in->sin_addr) != 1) {
+                return std::nullopt;
+            }
+
+            address.length = sizeof(sockaddr_in);
+            return address;
+        }
+
+        [[nodiscard]] const sockaddr* get() const {
+            return reinterpret_cast<const sockaddr*>(&this->storage);
+        }
+    };
+
+    struct UdpConfig final {
+        /// Local address to bind to. Port 0 picks a free port.
+        UdpAddress bind_address = UdpAddress::ipv4("0.0.0.0", 0).value();
+
+        /// Number of datagrams read or written by a single recvmmsg / sendmmsg call.
+        size_t batch_size = 64;
+
+        /// SO_RCVBUF and SO_SNDBUF size, 0 keeps the system default.
+        int socket_buffer_size = 4 * 1024 * 1024;
+
+        /// Whether datagrams with an unknown conv create a new connection.
+        bool accept_connections = false;
+
+        /**
+         *Whether consecutive datagrams of the same size to the same peer are sent as one UDP_SEGMENT (GSO) buffer.
+         *Falls back to plain batching if the kernel doesn't support it.
+         */
+        bool gso = false;
+
+        /// Whether the kernel may coalesce received datagrams into UDP_GRO super buffers, which are split again on input.
+        bool gro = false;
+    };
+
+    /// Cumulative transport counters.
+    struct UdpStats final {
+        size_t datagrams_received = 0;
+        size_t datagrams_sent = 0;
+
+        /// Datagrams which were not sent because the socket buffer was full.
+        size_t datagrams_dropped = 0;
+
+        /// Datagrams which could not be routed to a connection.
+        size_t datagrams_rejected = 0;
+
+        size_t recv_syscalls = 0;
+        size_t send_syscalls = 0;
+
+        /// Buffers sent with UDP_SEGMENT and received with UDP_GRO, each carrying more than one datagram.
+        size_t gso_buffers_sent = 0;
+        size_t gro_buffers_received = 0;
+    };
+
+    /**
+     *UdpTransport drives connections over a single non-blocking UDP socket on Linux.
+     *Datagrams are read and written in batches with recvmmsg / sendmmsg, optionally coalesced with GSO / GRO,
+     *connections are routed and scheduled by a SessionManager, and epoll waits until the socket is readable or the next check() deadline.
+     *It's not thread-safe, use one transport per thread.
+     */
+    template <size_t MTU>
+    class UdpTransport final {
+    public:
+        /// Called after a datagram has been passed to a connection, e.g. to recv() from it.
+        using receive_callback_t = std::function<void(UdpTransport&, Conv)>;
+
+        /// Called when a datagram with an unknown conv created a new connection.
+        using accept_callback_t = std::function<void(UdpTransport&, Conv, ImKcpp<MTU>&)>;
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        UdpConfig config;
+        int socket_fd = -1;
+        int epoll_fd = -1;
+
+        SessionManager<MTU> sessions{};
+        std::unordered_map<Conv::UT, UdpAddress> peers{};
+
+        receive_callback_t receive_callback{};
+        accept_callback_t accept_callback{};
+
+        clock::time_point start = clock::now();
+        UdpStats stats{};
+
+        /// Largest UDP payload, the size of a GRO super buffer.
+        constexpr static size_t MAX_UDP_PAYLOAD = 65507;
+
+        /// Kernel limit of segments in a single GSO buffer.
+        constexpr static size_t MAX_GSO_SEGMENTS = 64;
+
+        /// Control message buffer holding a single int or u16 option.
+        struct alignas(cmsghdr) Control final {
+            std::array<std::byte, CMSG_SPACE(sizeof(int))> data{};
+        };
+
+        /// Consecutive datagrams in the send storage which are sent with a single message.
+        struct SendGroup final {
+            UdpAddress peer{};
+            size_t offset = 0;
+            size_t size = 0;
+            size_t segment_size = 0;
+            size_t segments = 0;
+
+            /// A shorter datagram can only be the last segment of a GSO buffer.
+            bool closed = false;
+        };
+
+        size_t recv_buffer_size = MTU;
+
+        // Receive batch
+        std::vector<std::byte> recv_storage{};
+        std::vector<iovec> recv_iovs{};
+        std::vector<sockaddr_storage> recv_addresses{};
+        std::vector<Control> recv_controls{};
+        std::vector<mmsghdr> recv_messages{};
+
+        // Send batch, datagrams are copied back to back so that groups are contiguous
+        std::vector<std::byte> send_storage{};
+        size_t send_bytes = 0;
+        size_t send_datagrams = 0;
+        std::vector<SendGroup> send_groups{};
+        std::vector<iovec> send_iovs{};
+        std::vector<Control> send_controls{};
+        std::vector<mmsghdr> send_messages{};
+
+        explicit UdpTransport(const UdpConfig& config) : config(config) {
+            const size_t batch = this->config.batch_size;
+
+            if (this->config.gro) {
+                this->recv_buffer_size = MAX_UDP_PAYLOAD;
+            }
+
+            this->recv_storage.resize(batch * this->recv_buffer_size);
+            this->recv_iovs.resize(batch);
+            this->recv_addresses.resize(batch);
+            this->recv_controls.resize(batch);
+            this->recv_messages.resize(batch);
+
+            for (size_t i = 0; i < batch; ++i) {
+                this->recv_iovs[i] = { this->recv_storage.data() + i * this->recv_buffer_size, this->recv_buffer_size };
+            }
+
+            this->send_storage.resize(batch * MTU);
+            this->send_groups.reserve(batch);
+            this->send_iovs.resize(batch);
+            this->send_controls.resize(batch);
+            this->send_messages.resize(batch);
+        }
+
+        [[nodiscard]] error open_socket() {
+            this->socket_fd = ::socket(this->config.bind_address.storage.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+            if (this->socket_fd < 0) {
+                return error::socket_error;
+            }
+
+            if (const int size = this->config.socket_buffer_size; size > 0) {
+                ::setsockopt(this->socket_fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+                ::setsockopt(this->socket_fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+            }
+
+            if (this->config.gso) {
+                // Probe support, the segment size is set per message
+                const int size = 0;
+                this->config.gso = ::setsockopt(this->socket_fd, SOL_UDP, UDP_SEGMENT, &size, sizeof(size)) == 0;
+            }
+
+            if (this->config.gro) {
+                const int enabled = 1;
+                this->config.gro = ::setsockopt(this->socket_fd, SOL_UDP, UDP_GRO, &enabled, sizeof(enabled)) == 0;
+            }
+
+            if (::bind(this->socket_fd, this->config.bind_address.get(), this->config.bind_address.length) != 0) {
+                return error::socket_error;
+            }
+
+            this->epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+
+            if (this->epoll_fd < 0) {
+                return error::socket_error;
+            }
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = this->socket_fd;
+
+            if (::epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, this->socket_fd, &event) != 0) {
+                return error::socket_error;
+            }
+
+            return error::none;
+        }
+
+        [[nodiscard]] u32 now() const {
+            return static_cast<u32>(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - this->start).count());
+        }
+
+        void flush_sends() {
+            const size_t count = this->send_groups.size();
+
+            for (size_t i = 0; i < count; ++i) {
+                SendGroup& group = this->send_groups[i];
+
+                this->send_iovs[i] = { this->send_storage.data() + group.offset, group.size };
+
+                msghdr& header = this->send_messages[i].msg_hdr;
+                header = {};
+                header.msg_name = &group.peer.storage;
+                header.msg_namelen = group.peer.length;
+                header.msg_iov = &this->send_iovs[i];
+                header.msg_iovlen = 1;
+
+                if (group.segments > 1) {
+                    header.msg_control = this->send_controls[i].data.data();
+                    header.msg_controllen = CMSG_SPACE(sizeof(u16));
+
+                    cmsghdr* control = CMSG_FIRSTHDR(&header);
+                    control->cmsg_level = SOL_UDP;
+                    control->cmsg_type = UDP_SEGMENT;
+                    control->cmsg_len = CMSG_LEN(sizeof(u16));
+
+                    const auto segment_size = static_cast<u16>(group.segment_size);
+                    std::memcpy(CMSG_DATA(control), &segment_size, sizeof(segment_size));
+                }
+            }
+
+            size_t offset = 0;
+
+            while (offset < count) {
+                const int sent = ::sendmmsg(this->socket_fd, this->send_messages.data() + offset, static_cast<unsigned>(count - offset), 0);
+                this->stats.send_syscalls++;
+
+                if (sent <= 0) {
+                    if (sent < 0 && errno == EINTR) {
+                        continue;
+                    }
+
+                    if (sent < 0 && errno == EIO && this->config.gso) {
+                        // The device can't segment, e.g. checksum offload is off. Send the rest without GSO from now on.
+                        this->config.gso = false;
+                    }
+
+                    // Socket buffer is full, the protocol retransmits whatever is lost here
+                    for (size_t i = offset; i < count; ++i) {
+                        this->stats.datagrams_dropped += this->send_groups[i].segments;
+                    }
+                    break;
+                }
+
+                for (size_t i = offset; i < offset + static_cast<size_t>(sent); ++i) {
+                    this->stats.datagrams_sent += this->send_groups[i].segments;
+
+                    if (this->send_groups[i].segments > 1) {
+                        this->stats.gso_buffers_sent++;
+                    }
+                }
+
+                offset += static_cast<size_t>(sent);
+            }
+
+            this->send_groups.clear();
+            this->send_bytes = 0;
+            this->send_datagrams = 0;
+        }
+
+        /// Returns true if the datagram can be appended to the last group as another GSO segment.
+        [[nodiscard]] bool extends_last_group(const UdpAddress& peer, const size_t size) const {
+            if (!this->config.gso || this->send_groups.empty()) {
+                return false;
+            }
+
+            const SendGroup& group = this->send_groups.back();
+
+            return !group.closed &&
+                   size <= group.segment_size &&
+                   group.segments < MAX_GSO_SEGMENTS &&
+                   group.size + size <= MAX_UDP_PAYLOAD &&
+                   group.peer.length == peer.length &&
+                   std::memcmp(&group.peer.storage, &peer.storage, peer.length) == 0;
+        }
+
+        void queue_send(const Conv conv, const std::span<const std::byte> data) {
+            const auto peer = this->peers.find(conv.get());
+
+            if (peer == this->peers.end()) {
+                return;
+            }
+
+            if (this->send_datagrams == this->config.batch_size) {
+                this->flush_sends();
+            }
+
+            std::memcpy(this->send_storage.data() + this->send_bytes, data.data(), data.size());
+
+            if (this->extends_last_group(peer->second, data.size())) {
+                SendGroup& group = this->send_groups.back();
+
+                group.size += data.size();
+                group.segments++;
+                group.closed = data.size() < group.segment_size;
+            } else {
+                this->send_groups.push_back({ peer->second, this->send_bytes, data.size(), data.size(), 1, false });
+            }
+
+            this->send_bytes += data.size();
+            this->send_datagrams++;
+        }
+
+        void receive_datagram(const std::span<const std::byte> data, const sockaddr_storage& address, const socklen_t length) {
+            const std::optional<Conv> conv = peek_conv(data);
+
+            if (!conv.has_value()) {
+                this->stats.datagrams_rejected++;
+                return;
+            }
+
+            if (this->sessions.find(conv.value()) == nullptr) {
+                if (!this->config.accept_connections) {
+                    this->stats.datagrams_rejected++;
+                    return;
+                }
+
+                const auto kcp = this->sessions.create(conv.value());
+
+                // Only a valid first datagram opens a connection, anything else would leave a session behind
+                if (!this->sessions.input(data).has_value()) {
+                    this->sessions.remove(conv.value());
+                    this->stats.datagrams_rejected++;
+                    return;
+                }
+
+                this->peers[conv.value().get()] = UdpAddress{ address, length };
+
+                if (this->accept_callback) {
+                    this->accept_callback(*this, conv.value(), *kcp.value());
+                }
+            } else if (!this->sessions.input(data).has_value()) {
+                this->stats.datagrams_rejected++;
+                return;
+            }
+
+            if (this->receive_callback) {
+                this->receive_callback(*this, conv.value());
+            }
+        }
+
+        /// Returns the segment size of a UDP_GRO super buffer, or nothing for a plain datagram.
+        [[nodiscard]] static std::optional<size_t> gro_segment_size(const msghdr& header) {
+            for (const cmsghdr* control = CMSG_FIRSTHDR(&header); control != nullptr; control = CMSG_NXTHDR(const_cast<msghdr*>(&header), const_cast<cmsghdr*>(control))) {
+                if (control->cmsg_level == SOL_UDP && control->cmsg_type == UDP_GRO) {
+                    int size = 0;
+                    std::memcpy(&size, CMSG_DATA(control), sizeof(size));
+
+                    if (size > 0) {
+                        return static_cast<size_t>(size);
+                    }
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        /// Reads until the socket is drained or the limit of batches is reached.
+        void receive_batches(const size_t max_batches) {
+            for (size_t batch = 0; batch < max_batches; ++batch) {
+                for (size_t i = 0; i < this->config.batch_size; ++i) {
+                    msghdr& header = this->recv_messages[i].msg_hdr;
+                    header = {};
+                    header.msg_name = &this->recv_addresses[i];
+                    header.msg_namelen = sizeof(sockaddr_storage);
+                    header.msg_iov = &this->recv_iovs[i];
+                    header.msg_iovlen = 1;
+
+                    if (this->config.gro) {
+                        header.msg_control = this->recv_controls[i].data.data();
+                        header.msg_controllen = sizeof(Control);
+                    }
+                }
+
+                const int received = ::recvmmsg(this->socket_fd, this->recv_messages.data(), static_cast<unsigned>(this->config.batch_size), MSG_DONTWAIT, nullptr);
+                this->stats.recv_syscalls++;
+
+                if (received <= 0) {
+                    return;
+                }
+
+                for (size_t i = 0; i < static_cast<size_t>(received); ++i) {
+                    const mmsghdr& message = this->recv_messages[i];
+
+                    // Truncated datagrams are larger than MTU and can't be valid
+                    if ((message.msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+                        this->stats.datagrams_received++;
+                        this->stats.datagrams_rejected++;
+                        continue;
+                    }
+
+                    const std::span<const std::byte> buffer(this->recv_storage.data() + i * this->recv_buffer_size, message.msg_len);
+                    const size_t segment_size = this->gro_segment_size(message.msg_hdr).value_or(buffer.size());
+
+                    if (segment_size < buffer.size()) {
+                        this->stats.gro_buffers_received++;
+                    }
+
+                    // Split a GRO super buffer back into the original datagrams, in place
+                    for (size_t offset = 0; offset < buffer.size(); offset += segment_size) {
+                        const auto datagram = buffer.subspan(offset, std::min(segment_size, buffer.size() - offset));
+
+                        this->stats.datagrams_received++;
+
+                        if (datagram.size() > MTU) {
+                            this->stats.datagrams_rejected++;
+                            continue;
+                        }
+
+                        this->receive_datagram(datagram, this->recv_addresses[i], message.msg_hdr.msg_namelen);
+                    }
+                }
+
+                if (static_cast<size_t>(received) < this->config.batch_size) {
+                    return;
+                }
+            }
+        }
+
+    public:
+        /// Opens and binds the socket. The transport isn't movable since the batch headers point into it.
+        [[nodiscard]] static tl::expected<std::unique_ptr<UdpTransport>, error> open(const UdpConfig& config) {
+            std::unique_ptr<UdpTransport> transport(new UdpTransport(config));
+
+            if (const error err = transport->open_socket(); err != error::none) {
+                return tl::unexpected(err);
+            }
+
+            return transport;
+        }
+
+        UdpTransport(const UdpTransport&) = delete;
+        UdpTransport& operator=(const UdpTransport&) = delete;
+
+        ~UdpTransport() {
+            if (this->epoll_fd >= 0) {
+                ::close(this->epoll_fd);
+            }
+
+            if (this->socket_fd >= 0) {
+                ::close(this->socket_fd);
+            }
+        }
+
+        void set_receive_callback(receive_callback_t callback) {
+            this->receive_callback = std::move(callback);
+        }
+
+        /// Called for every accepted connection, after its first datagram has been input and before it is first updated.
+        void set_accept_callback(accept_callback_t callback) {
+            this->accept_callback = std::move(callback);
+        }
+
+        /// Creates a connection to the given peer.
+        [[nodiscard]] tl::expected<ImKcpp<MTU>*, error> connect(const Conv conv, const UdpAddress& peer) {
+            auto kcp = this->sessions.create(conv);
+
+            if (kcp.has_value()) {
+                this->peers[conv.get()] = peer;
+            }
+
+            return kcp;
+        }
+
+        /// Removes the connection.
+        bool close(const Conv conv) {
+            this->peers.erase(conv.get());
+            return this->sessions.remove(conv);
+        }
+
+        /// Sends data on the connection. Connections must be written through the transport so that they are scheduled.
+        tl::expected<size_t, error> send(const Conv conv, const std::span<const std::byte> buffer) {
+            return this->sessions.send(conv, buffer);
+        }
+
+        /// Reads data from the connection.
+        tl::expected<size_t, error> recv(const Conv conv, const std::span<std::byte> buffer) {
+            return this->sessions.recv(conv, buffer);
+        }
+
+        /// Finds the connection, e.g. to change its settings. Call wake() afterwards if it may need an update.
+        [[nodiscard]] ImKcpp<MTU>* find(const Conv conv) {
+            return this->sessions.find(conv);
+        }
+
+        void wake(const Conv conv) {
+            this->sessions.wake(conv);
+        }
+
+        /**
+         *Waits up to max_wait_ms for datagrams or the next connection deadline, whichever comes first,
+         *then processes received datagrams, updates due connections and sends their output in batches.
+         */
+        void poll(const u32 max_wait_ms) {
+            u32 current = this->now();
+            int timeout = static_cast<int>(max_wait_ms);
+
+            if (const std::optional<u32> next = this->sessions.next_update_time(); next.has_value()) {
+                timeout = std::clamp(time_delta(next.value(), current), 0, timeout);
+            }
+
+            std::array<epoll_event, 1> events{};
+            const int ready = ::epoll_wait(this->epoll_fd, events.data(), static_cast<int>(events.size()), timeout);
+
+            if (ready > 0) {
+                // Bound the work per poll so that timers aren't starved by a flood
+                this->receive_batches(16);
+            }
+
+            current = this->now();
+            this->sessions.update(current, [this](const Conv conv, const std::span<const std::byte> data) {
+                this->queue_send(conv, data);
+            });
+
+            this->flush_sends();
+        }
+
+        /// Returns the locally bound address.
+        [[nodiscard]] UdpAddress local_address() const {
+            UdpAddress address;
+            address.length = sizeof(address.storage);
+            ::getsockname(this->socket_fd, reinterpret_cast<sockaddr*>(&address.storage), &address.length);
+
+            return address;
+        }
+
+        /// Returns the epoll descriptor, e.g. to be nested in another event loop.
+        [[nodiscard]] int get_epoll_fd() const {
+            return this->epoll_fd;
+        }
+
+        /// Returns true if GSO is in use, it may be disabled at runtime if the device doesn't support it.
+        [[nodiscard]] bool is_gso_enabled() const {
+            return this->config.gso;
+        }
+
+        [[nodiscard]] bool is_gro_enabled() const {
+            return this->config.gro;
+        }
+
+        [[nodiscard]] const UdpStats& get_stats() const {
+            return this->stats;
+        }
+    };
+}
+
+#endif
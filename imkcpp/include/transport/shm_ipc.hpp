@@ -0,0 +1,288 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "../third_party/expected.hpp"
+#include "../types.hpp"
+#include "../errors.hpp"
+#include "../mpsc_queue.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+
+namespace imkcpp::transport {
+    namespace detail {
+        /// Single producer single consumer ring of datagrams living in shared memory. Only uses lock-free atomics on plain words.
+        template <size_t MTU>
+        struct ShmRing final {
+            struct Slot final {
+                u32 size = 0;
+                std::array<std::byte, MTU> data{};
+            };
+
+            alignas(CACHE_LINE_SIZE) std::atomic<u32> head{0};
+
+            alignas(CACHE_LINE_SIZE) std::atomic<u32> tail{0};
+
+            /// Futex word, bumped by the producer whenever the consumer announced it's going to sleep.
+            alignas(CACHE_LINE_SIZE) std::atomic<u32> wakeups{0};
+            std::atomic<u32> sleeping{0};
+
+            static_assert(std::atomic<u32>::is_always_lock_free);
+        };
+
+        inline long futex(std::atomic<u32>& word, const int op, const u32 value, const timespec* timeout) {
+            return ::syscall(SYS_futex, reinterpret_cast<u32*>(&word), op, value, timeout, nullptr, 0);
+        }
+    }
+
+    /**
+     *ShmChannel is a bidirectional datagram channel between two processes on the same host.
+     *It consists of two SPSC rings in a shared memory region, one per direction, and uses futexes to wake a sleeping reader.
+     *Each side owns one endpoint: the creator writes to the first ring and reads from the second, the opener the other way round.
+     *It plugs into the output_callback_t / input() boundary, so connections don't need to change.
+     */
+    template <size_t MTU>
+    class ShmChannel final {
+        using Ring = detail::ShmRing<MTU>;
+        using Slot = typename Ring::Slot;
+
+        constexpr static u32 MAGIC = 0x696B6370; // "ikcp"
+
+        struct Header final {
+            u32 magic = 0;
+            u32 mtu = 0;
+            u32 capacity = 0;
+        };
+
+        void* region = MAP_FAILED;
+        size_t region_size = 0;
+        std::string name{};
+        bool owner = false;
+
+        u32 capacity = 0;
+        Ring* tx = nullptr;
+        Ring* rx = nullptr;
+        Slot* tx_slots = nullptr;
+        Slot* rx_slots = nullptr;
+
+        [[nodiscard]] static size_t ring_size(const u32 capacity) {
+            return sizeof(Ring) + static_cast<size_t>(capacity) * sizeof(Slot);
+        }
+
+        [[nodiscard]] static size_t total_size(const u32 capacity) {
+            return CACHE_LINE_SIZE + 2 * ring_size(capacity);
+        }
+
+        void attach(const bool creator) {
+            auto* base = static_cast<std::byte*>(this->region);
+            auto* first = reinterpret_cast<Ring*>(base + CACHE_LINE_SIZE);
+            auto* second = reinterpret_cast<Ring*>(base + CACHE_LINE_SIZE + ring_size(this->capacity));
+
+            this->tx = creator ? first : second;
+            this->rx = creator ? second : first;
+            this->tx_slots = reinterpret_cast<Slot*>(reinterpret_cast<std::byte*>(this->tx) + sizeof(Ring));
+            this->rx_slots = reinterpret_cast<Slot*>(reinterpret_cast<std::byte*>(this->rx) + sizeof(Ring));
+        }
+
+        ShmChannel() = default;
+
+    public:
+        ShmChannel(const ShmChannel&) = delete;
+        ShmChannel& operator=(const ShmChannel&) = delete;
+
+        ~ShmChannel() {
+            if (this->region != MAP_FAILED) {
+                ::munmap(this->region, this->region_size);
+            }
+
+            if (this->owner && !this->name.empty()) {
+                ::shm_unlink(this->name.c_str());
+            }
+        }
+
+        /**
+         *Creates a named channel with the given number of slots per direction, which must be a power of two.
+         *The name is removed when the creator is destroyed, mapped regions stay valid for the other side.
+         */
+        [[nodiscard]] static tl::expected<std::unique_ptr<ShmChannel>, error> create(const std::string& name, const u32 capacity) {
+            if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+                return tl::unexpected(error::shm_error);
+            }
+
+            const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+            if (fd < 0) {
+                return tl::unexpected(error::shm_error);
+            }
+
+            std::unique_ptr<ShmChannel> channel(new ShmChannel());
+            channel->name = name;
+            channel->owner = true;
+            channel->capacity = capacity;
+            channel->region_size = total_size(capacity);
+
+            if (::ftruncate(fd, static_cast<off_t>(channel->region_size)) != 0) {
+                ::close(fd);
+                return tl::unexpected(error::shm_error);
+            }
+
+            channel->region = ::mmap(nullptr, channel->region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+
+            if (channel->region == MAP_FAILED) {
+                return tl::unexpected(error::shm_error);
+            }
+
+            // The region is zero filled, which is a valid empty state for both rings
+            channel->attach(true);
+
+            // Publish the header last, the opener checks the magic
+            auto* header = static_cast<Header*>(channel->region);
+            header->mtu = MTU;
+            header->capacity = capacity;
+            std::atomic_ref(header->magic).store(MAGIC, std::memory_order_release);
+
+            return channel;
+        }
+
+        /// Opens a channel created by another process.
+        [[nodiscard]] static tl::expected<std::unique_ptr<ShmChannel>, error> open(const std::string& name) {
+            const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+
+            if (fd < 0) {
+                return tl::unexpected(error::shm_error);
+            }
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < CACHE_LINE_SIZE) {
+                ::close(fd);
+                return tl::unexpected(error::shm_error);
+            }
+
+            std::unique_ptr<ShmChannel> channel(new ShmChannel());
+            channel->region_size = static_cast<size_t>(st.st_size);
+            channel->region = ::mmap(nullptr, channel->region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+
+            if (channel->region == MAP_FAILED) {
+                return tl::unexpected(error::shm_error);
+            }
+
+            auto* header = static_cast<Header*>(channel->region);
+            const u32 capacity = header->capacity;
+
+            // The capacity is used as a mask, so it has to be checked like create() does before the size is computed from it
+            if (std::atomic_ref(header->magic).load(std::memory_order_acquire) != MAGIC ||
+                header->mtu != MTU ||
+                capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+                total_size(capacity) != channel->region_size) {
+                return tl::unexpected(error::shm_error);
+            }
+
+            channel->capacity = capacity;
+            channel->attach(false);
+
+            return channel;
+        }
+
+        /// Copies a datagram into the outgoing ring. Returns false if it's full or the datagram is larger than MTU, like a dropped packet.
+        bool send(const std::span<const std::byte> data) {
+            if (data.size() > MTU) {
+                return false;
+            }
+
+            const u32 tail = this->tx->tail.load(std::memory_order_relaxed);
+
+            if (tail - this->tx->head.load(std::memory_order_acquire) >= this->capacity) {
+                return false;
+            }
+
+            Slot& slot = this->tx_slots[tail & (this->capacity - 1)];
+            slot.size = static_cast<u32>(data.size());
+            std::memcpy(slot.data.data(), data.data(), data.size());
+
+            this->tx->tail.store(tail + 1, std::memory_order_seq_cst);
+
+            // Pairs with the reader announcing sleep before it rechecks the ring
+            if (this->tx->sleeping.load(std::memory_order_seq_cst) != 0) {
+                this->tx->wakeups.fetch_add(1, std::memory_order_release);
+                detail::futex(this->tx->wakeups, FUTEX_WAKE, 1, nullptr);
+            }
+
+            return true;
+        }
+
+        /// Returns an output callback which sends into this channel.
+        [[nodiscard]] output_callback_t output() {
+            return [this](const std::span<const std::byte> data) {
+                this->send(data);
+            };
+        }
+
+        /**
+         *Calls the function for up to max_count incoming datagrams, which point directly into shared memory
+         *and are only valid during the call. Returns the number of datagrams consumed.
+         */
+        template <typename F>
+        size_t receive(F&& fn, const size_t max_count = std::numeric_limits<size_t>::max()) {
+            u32 head = this->rx->head.load(std::memory_order_relaxed);
+            const u32 tail = this->rx->tail.load(std::memory_order_acquire);
+
+            size_t count = 0;
+
+            while (head != tail && count < max_count) {
+                const Slot& slot = this->rx_slots[head & (this->capacity - 1)];
+                fn(std::span<const std::byte>(slot.data.data(), std::min<size_t>(slot.size, MTU)));
+
+                ++head;
+                ++count;
+
+                // Free slots as we go so that the writer can continue
+                this->rx->head.store(head, std::memory_order_release);
+            }
+
+            return count;
+        }
+
+        /// Returns true if there is at least one incoming datagram.
+        [[nodiscard]] bool readable() const {
+            return this->rx->head.load(std::memory_order_relaxed) != this->rx->tail.load(std::memory_order_acquire);
+        }
+
+        /// Sleeps until a datagram arrives or the timeout passes. Returns true if there is something to read.
+        bool wait(const u32 timeout_ms) {
+            if (this->readable()) {
+                return true;
+            }
+
+            const u32 seen = this->rx->wakeups.load(std::memory_order_acquire);
+            this->rx->sleeping.store(1, std::memory_order_seq_cst);
+
+            if (!this->readable()) {
+                const timespec timeout{ static_cast<time_t>(timeout_ms / 1000), static_cast<long>(timeout_ms % 1000) * 1000000 };
+                detail::futex(this->rx->wakeups, FUTEX_WAIT, seen, &timeout);
+            }
+
+            this->rx->sleeping.store(0, std::memory_order_relaxed);
+
+            return this->readable();
+        }
+    };
+}
+
+#endif
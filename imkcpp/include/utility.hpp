@@ -2,6 +2,7 @@
 
 #include "types.hpp"
 #include "serializer.hpp"
+#include "segment.hpp"
 
 namespace imkcpp {
     /// Returns i32 value of the difference between two u32 values, aka a - b.
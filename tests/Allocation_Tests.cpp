@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "imkcpp.hpp"
+
+// Global operator new / delete are replaced, which is why this is built as its own executable, imkcpp_allocation_tests.
+namespace {
+    std::atomic<size_t> allocation_count{0};
+
+    /// Every replaced operator new ends up here, aligned ones included, so that nothing escapes the count.
+    void* allocate(const std::size_t size, const std::size_t alignment) noexcept {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return std::malloc(size == 0 ? 1 : size);
+        }
+
+        // aligned_alloc() wants a multiple of the alignment
+        return std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment);
+    }
+
+    // Kept out of line, otherwise GCC sees free() inlined next to operator new and warns with -Wmismatched-new-delete
+    [[gnu::noinline]] void deallocate(void* ptr) noexcept {
+        std::free(ptr);
+    }
+}
+
+void* operator new(const std::size_t size) {
+    if (void* ptr = allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+    if (void* ptr = allocate(size, static_cast<std::size_t>(alignment))) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+    constexpr u32 INTERVAL = 10;
+
+    /// Returns the allocations per transferred segment once both sides have reached a steady state.
+    double allocations_per_segment(const size_t message_size, const u32 window) {
+        ImKcpp<MTU> sender(Conv{1});
+        ImKcpp<MTU> receiver(Conv{1});
+
+        for (ImKcpp<MTU>* kcp : {&sender, &receiver}) {
+            kcp->set_nodelay(1);
+            kcp->set_interval(INTERVAL);
+            kcp->set_congestion_window_enabled(false);
+            kcp->set_send_window(window);
+            kcp->set_receive_window(window);
+        }
+
+        const size_t segments_per_message = sender.estimate_segments_count(message_size);
+        const size_t messages_per_step = std::max<size_t>(1, window / 2 / segments_per_message);
+
+        std::vector<std::byte> message(message_size, std::byte{1});
+        std::vector<std::byte> buffer(message_size);
+
+        // Datagrams are kept in preallocated storage so that only the connections allocate
+        std::vector<std::byte> wire(1 << 22);
+        std::vector<std::span<const std::byte>> datagrams{};
+        datagrams.reserve(1 << 14);
+        size_t used = 0;
+
+        const output_callback_t output = [&](const std::span<const std::byte> data) {
+            std::memcpy(wire.data() + used, data.data(), data.size());
+            datagrams.emplace_back(wire.data() + used, data.size());
+            used += data.size();
+        };
+
+        const auto deliver = [&](ImKcpp<MTU>& target) {
+            for (const auto datagram : datagrams) {
+                EXPECT_TRUE(target.input(datagram).has_value());
+            }
+
+            datagrams.clear();
+            used = 0;
+        };
+
+        u32 current = 0;
+        size_t received = 0;
+
+        const auto step = [&] {
+            for (size_t i = 0; i < messages_per_step; ++i) {
+                EXPECT_TRUE(sender.send(message).has_value());
+            }
+
+            current += INTERVAL;
+
+            sender.update(current, output);
+            deliver(receiver);
+
+            while (receiver.recv(buffer).has_value()) {
+                received++;
+            }
+
+            receiver.update(current, output);
+            deliver(sender);
+        };
+
+        for (u32 i = 0; i < 100; ++i) {
+            step();
+        }
+
+        const size_t received_before = received;
+        const size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+
+        for (u32 i = 0; i < 1000; ++i) {
+            step();
+        }
+
+        const size_t allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+        const size_t segments = (received - received_before) * segments_per_message;
+
+        EXPECT_EQ(received - received_before, 1000 * messages_per_step);
+
+        return static_cast<double>(allocations) / static_cast<double>(segments);
+    }
+}
+
+// Every segment currently owns a payload vector on each side, and the four segment deques it passes through
+// churn a block every few segments, about 3.5 allocations in total. Anything more per segment, e.g. a payload copy
+// or a per call scratch buffer, pushes the ratio over the bound.
+constexpr double MAX_ALLOCATIONS_PER_SEGMENT = 4.0;
+
+TEST(Allocation_Tests, SingleSegmentMessages) {
+    const double ratio = allocations_per_segment(1024, 128);
+
+    RecordProperty("allocations_per_segment", std::to_string(ratio));
+    ASSERT_LE(ratio, MAX_ALLOCATIONS_PER_SEGMENT);
+}
+
+TEST(Allocation_Tests, SmallMessages) {
+    const double ratio = allocations_per_segment(64, 128);
+
+    RecordProperty("allocations_per_segment", std::to_string(ratio));
+    ASSERT_LE(ratio, MAX_ALLOCATIONS_PER_SEGMENT);
+}
+
+TEST(Allocation_Tests, FragmentedMessages) {
+    const double ratio = allocations_per_segment(16 * 1024, 256);
+
+    RecordProperty("allocations_per_segment", std::to_string(ratio));
+    ASSERT_LE(ratio, MAX_ALLOCATIONS_PER_SEGMENT);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "async_connection.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    /// Minimal eagerly started coroutine which is destroyed when it finishes.
+    struct DetachedTask final {
+        struct promise_type final {
+            DetachedTask get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept { }
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    class AsyncConnectionTest : public testing::Test {
+    protected:
+        ImKcpp<MTU> client_kcp{Conv{1}};
+        ImKcpp<MTU> server_kcp{Conv{1}};
+
+        AsyncConnection<MTU> client{client_kcp};
+        AsyncConnection<MTU> server{server_kcp};
+
+        u32 current = 0;
+
+        void step() {
+            client.update(current, [this](const std::span<const std::byte> data) { (void)server.input(data); });
+            server.update(current, [this](const std::span<const std::byte> data) { (void)client.input(data); });
+            current += 100;
+        }
+    };
+}
+
+TEST_F(AsyncConnectionTest, RecvResumesOnInput) {
+    std::vector<size_t> received;
+    std::array<std::byte, 4096> buffer{};
+
+    const auto receiver = [&]() -> DetachedTask {
+        for (int i = 0; i < 2; ++i) {
+            const auto size = co_await server.recv(buffer);
+            received.push_back(size.value_or(0));
+        }
+    };
+
+    receiver();
+    ASSERT_TRUE(received.empty());
+
+    std::vector<std::byte> message(3000, std::byte{1});
+    ASSERT_TRUE(client.send(message).has_value());
+    ASSERT_TRUE(client.send(std::span(message).first(10)).has_value());
+
+    for (int i = 0; i < 5; ++i) {
+        step();
+    }
+
+    ASSERT_EQ(received, (std::vector<size_t>{3000, 10}));
+}
+
+TEST_F(AsyncConnectionTest, RecvReadyWithoutSuspending) {
+    std::vector<std::byte> message(10, std::byte{1});
+    ASSERT_TRUE(client.send(message).has_value());
+
+    for (int i = 0; i < 3; ++i) {
+        step();
+    }
+
+    std::array<std::byte, 100> buffer{};
+    bool done = false;
+
+    [&]() -> DetachedTask {
+        const auto size = co_await server.recv(buffer);
+        done = size.value_or(0) == 10;
+    }();
+
+    ASSERT_TRUE(done);
+}
+
+TEST_F(AsyncConnectionTest, RecvReportsBufferTooSmall) {
+    std::vector<std::byte> message(100, std::byte{1});
+    ASSERT_TRUE(client.send(message).has_value());
+
+    std::array<std::byte, 10> buffer{};
+    std::optional<error> result;
+
+    [&]() -> DetachedTask {
+        const auto size = co_await server.recv(buffer);
+        result = size.error();
+    }();
+
+    for (int i = 0; i < 3; ++i) {
+        step();
+    }
+
+    ASSERT_EQ(result, error::buffer_too_small);
+}
+
+TEST_F(AsyncConnectionTest, WritableAndFlushed) {
+    std::vector<std::byte> message(10 * 1000, std::byte{1});
+    ASSERT_TRUE(client.send(message).has_value());
+    ASSERT_GE(client_kcp.get_waiting_send_count(), 8);
+
+    bool writable = false;
+    bool flushed = false;
+
+    [&]() -> DetachedTask {
+        co_await client.writable(5);
+        writable = true;
+        co_await client.flushed();
+        flushed = true;
+    }();
+
+    ASSERT_FALSE(writable);
+
+    for (int i = 0; i < 10 && !flushed; ++i) {
+        step();
+    }
+
+    ASSERT_TRUE(writable);
+    ASSERT_TRUE(flushed);
+    ASSERT_EQ(client_kcp.get_waiting_send_count(), 0);
+}
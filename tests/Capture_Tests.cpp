@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include "simulator/network_simulator.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::simulator;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    std::string temp_path(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void configure(ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        kcp.set_fastresend(2);
+        kcp.set_send_window(128);
+        kcp.set_receive_window(128);
+    }
+
+    ReplayResult replay_file(const std::string& path) {
+        auto reader = CaptureReader::open(path.c_str());
+        EXPECT_TRUE(reader.has_value());
+        EXPECT_EQ(reader->get_info().mtu, MTU);
+
+        ImKcpp<MTU> kcp(reader->get_info().conv);
+        configure(kcp);
+
+        const ReplayResult result = replay(*reader, kcp);
+        EXPECT_FALSE(reader->is_malformed());
+
+        return result;
+    }
+}
+
+TEST(Capture_Tests, WriteAndRead) {
+    const std::string path = temp_path("imkcpp_capture_records.bin");
+
+    {
+        auto writer = CaptureWriter::create(path.c_str(), MTU, Conv{9});
+        ASSERT_TRUE(writer.has_value());
+
+        const std::vector<std::byte> datagram(100, std::byte{7});
+
+        writer->update(10);
+        writer->input(11, datagram);
+        writer->output(12, std::span(datagram).first(30));
+        writer->send(13, 5000);
+        writer->recv(14, 8192);
+        writer->flush(15);
+
+        ASSERT_TRUE(writer->close().has_value());
+    }
+
+    auto reader = CaptureReader::open(path.c_str());
+    ASSERT_TRUE(reader.has_value());
+    ASSERT_EQ(reader->get_info().mtu, MTU);
+    ASSERT_EQ(reader->get_info().conv, Conv{9});
+
+    const std::vector<std::pair<CaptureEvent, u32>> expected = {
+        {CaptureEvent::Update, 0}, {CaptureEvent::Input, 100}, {CaptureEvent::Output, 30}, {CaptureEvent::Send, 5000}, {CaptureEvent::Recv, 8192},
+        {CaptureEvent::Flush, 0},
+    };
+
+    for (u32 i = 0; i < expected.size(); ++i) {
+        const auto record = reader->next();
+        ASSERT_TRUE(record.has_value());
+        ASSERT_EQ(record->time, 10 + i);
+        ASSERT_EQ(record->event, expected[i].first);
+        ASSERT_EQ(record->size, expected[i].second);
+
+        if (record->event == CaptureEvent::Input || record->event == CaptureEvent::Output) {
+            ASSERT_EQ(record->data.size(), record->size);
+            ASSERT_EQ(record->data[0], std::byte{7});
+        } else {
+            ASSERT_TRUE(record->data.empty());
+        }
+    }
+
+    ASSERT_FALSE(reader->next().has_value());
+    ASSERT_FALSE(reader->is_malformed());
+
+    reader->rewind();
+    ASSERT_EQ(reader->next()->event, CaptureEvent::Update);
+
+    // A truncated datagram ends the capture as malformed
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 100);
+
+    auto truncated = CaptureReader::open(path.c_str());
+    ASSERT_TRUE(truncated.has_value());
+    ASSERT_TRUE(truncated->next().has_value());
+    ASSERT_FALSE(truncated->next().has_value());
+    ASSERT_TRUE(truncated->is_malformed());
+
+    std::filesystem::remove(path);
+    ASSERT_EQ(CaptureReader::open(path.c_str()).error(), error::file_error);
+}
+
+TEST(Capture_Tests, ReplayReproducesLossyTransfer) {
+    const std::string sender_path = temp_path("imkcpp_capture_sender.bin");
+    const std::string receiver_path = temp_path("imkcpp_capture_receiver.bin");
+
+    {
+        auto sender_capture = CaptureWriter::create(sender_path.c_str(), MTU, Conv{1});
+        auto receiver_capture = CaptureWriter::create(receiver_path.c_str(), MTU, Conv{1});
+        ASSERT_TRUE(sender_capture.has_value());
+        ASSERT_TRUE(receiver_capture.has_value());
+
+        ImKcpp<MTU> sender_kcp(Conv{1});
+        ImKcpp<MTU> receiver_kcp(Conv{1});
+        configure(sender_kcp);
+        configure(receiver_kcp);
+        sender_kcp.set_capture(&*sender_capture);
+        receiver_kcp.set_capture(&*receiver_capture);
+
+        KcpEndpoint<MTU> sender(sender_kcp);
+        KcpEndpoint<MTU> receiver(receiver_kcp);
+
+        SimulationConfig config;
+        config.forward.latency_ms = 20;
+        config.forward.jitter_ms = 5;
+        config.forward.loss = 0.05;
+        config.forward.reorder = 0.05;
+        config.backward.latency_ms = 20;
+        config.backward.loss = 0.02;
+        config.message_size = 3000;
+        config.message_count = 200;
+
+        ASSERT_TRUE(simulate(sender, receiver, config).completed);
+
+        ASSERT_TRUE(sender_capture->close().has_value());
+        ASSERT_TRUE(receiver_capture->close().has_value());
+    }
+
+    const ReplayResult sender = replay_file(sender_path);
+    ASSERT_EQ(sender.sends, 200);
+    ASSERT_GT(sender.inputs, 0);
+    ASSERT_GT(sender.outputs, 0);
+    ASSERT_EQ(sender.outputs, sender.captured_outputs);
+    ASSERT_EQ(sender.mismatched_outputs, 0);
+
+    const ReplayResult receiver = replay_file(receiver_path);
+    ASSERT_GE(receiver.recvs, 200);
+    ASSERT_GT(receiver.inputs, 0);
+    ASSERT_EQ(receiver.outputs, receiver.captured_outputs);
+    ASSERT_EQ(receiver.mismatched_outputs, 0);
+
+    std::filesystem::remove(sender_path);
+    std::filesystem::remove(receiver_path);
+}
+
+TEST(Capture_Tests, ReplayDetectsDifferentConfiguration) {
+    const std::string path = temp_path("imkcpp_capture_config.bin");
+
+    {
+        auto capture = CaptureWriter::create(path.c_str(), MTU, Conv{1});
+        ASSERT_TRUE(capture.has_value());
+
+        // Captured with the default interval instead of the one used for replay
+        ImKcpp<MTU> kcp(Conv{1});
+        kcp.set_capture(&*capture);
+
+        ASSERT_TRUE(kcp.send(std::vector<std::byte>(100)).has_value());
+
+        for (u32 current = 0; current < 1000; current += 10) {
+            kcp.update(current, [](std::span<const std::byte>) { });
+        }
+    }
+
+    ASSERT_GT(replay_file(path).mismatched_outputs, 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST(Capture_Tests, ReplayReproducesDirectFlush) {
+    const std::string path = temp_path("imkcpp_capture_flush.bin");
+
+    {
+        auto capture = CaptureWriter::create(path.c_str(), MTU, Conv{1});
+        ASSERT_TRUE(capture.has_value());
+
+        ImKcpp<MTU> kcp(Conv{1});
+        configure(kcp);
+        kcp.set_capture(&*capture);
+
+        kcp.update(0, [](std::span<const std::byte>) { });
+
+        // Messages are flushed right away instead of waiting for the next update
+        for (u32 current = 10; current < 100; current += 10) {
+            ASSERT_TRUE(kcp.send(std::vector<std::byte>(100)).has_value());
+            kcp.flush([](std::span<const std::byte>) { });
+
+            kcp.update(current, [](std::span<const std::byte>) { });
+        }
+
+        ASSERT_TRUE(capture->close().has_value());
+    }
+
+    const ReplayResult result = replay_file(path);
+    ASSERT_EQ(result.flushes, 9);
+    ASSERT_GT(result.outputs, 0);
+    ASSERT_EQ(result.outputs, result.captured_outputs);
+    ASSERT_EQ(result.mismatched_outputs, 0);
+
+    std::filesystem::remove(path);
+}
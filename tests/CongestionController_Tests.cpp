@@ -80,3 +80,35 @@ TEST_F(CongestionControllerTest, EnsureAtLeastOnePacket) {
     ASSERT_GE(controller.calculate_congestion_window(), 1);
 }
 
+TEST_F(CongestionControllerTest, UndoRestoresValuesBeforeReduction) {
+    using namespace imkcpp;
+
+    controller.packets_resent(60, 20);
+    const u32 ssthresh = controller.get_ssthresh();
+    const u32 cwnd = controller.calculate_congestion_window();
+
+    controller.save_undo_point(10);
+    controller.packet_lost();
+    ASSERT_EQ(controller.calculate_congestion_window(), 1);
+
+    // Only the first reduction of an episode is remembered
+    controller.save_undo_point(12);
+    controller.packet_lost();
+
+    ASSERT_TRUE(controller.undo());
+    ASSERT_EQ(controller.get_ssthresh(), ssthresh);
+    ASSERT_EQ(controller.calculate_congestion_window(), cwnd);
+
+    ASSERT_FALSE(controller.undo());
+}
+
+TEST_F(CongestionControllerTest, UndoNotAvailableAfterRecovery) {
+    controller.save_undo_point(10);
+    controller.packet_lost();
+
+    controller.una_advanced(9);
+    controller.una_advanced(10);
+
+    ASSERT_FALSE(controller.undo());
+    ASSERT_EQ(controller.calculate_congestion_window(), 1);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+#include "imkcpp.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    std::string temp_path(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    std::vector<FlightRecord> records_of(const FlightRecorder& recorder) {
+        std::vector<FlightRecord> records;
+        recorder.for_each([&records](const FlightRecord& record) { records.push_back(record); });
+        return records;
+    }
+
+    SegmentHeader push_header(const u32 sn) {
+        return SegmentHeader{ .conv = Conv{7}, .cmd = commands::PUSH, .sn = sn };
+    }
+}
+
+TEST(FlightRecorder_Tests, KeepsMostRecentRecords) {
+    FlightRecorder recorder(6);
+    ASSERT_EQ(recorder.capacity(), 8);
+
+    for (u32 sn = 0; sn < 20; ++sn) {
+        recorder.header_sent(sn * 10, push_header(sn));
+    }
+
+    const std::vector<FlightRecord> records = records_of(recorder);
+
+    ASSERT_EQ(recorder.get_written(), 20);
+    ASSERT_EQ(records.size(), 8);
+    ASSERT_EQ(records.front().b, 12);
+    ASSERT_EQ(records.back().b, 19);
+    ASSERT_EQ(records.back().time, 190);
+    ASSERT_EQ(records.back().conv, 7);
+    ASSERT_EQ(records.back().cmd, commands::PUSH.get());
+}
+
+TEST(FlightRecorder_Tests, DumpAndLoad) {
+    const std::string path = temp_path("imkcpp_flight_recorder_dump.bin");
+
+    FlightRecorder recorder(4);
+
+    for (u32 sn = 0; sn < 6; ++sn) {
+        recorder.header_received(sn, push_header(sn));
+    }
+
+    ASSERT_TRUE(recorder.dump(path.c_str()).has_value());
+
+    const auto dump = FlightRecorder::load(path.c_str());
+    ASSERT_TRUE(dump.has_value());
+    ASSERT_EQ(dump->overwritten, 2);
+    ASSERT_EQ(dump->records.size(), 4);
+
+    for (u32 i = 0; i < 4; ++i) {
+        ASSERT_EQ(dump->records[i].b, i + 2);
+        ASSERT_EQ(dump->records[i].event, FlightEvent::HeaderReceived);
+    }
+
+    // Truncated files are rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    ASSERT_EQ(FlightRecorder::load(path.c_str()).error(), error::malformed_payload);
+
+    std::filesystem::remove(path);
+    ASSERT_EQ(FlightRecorder::load(path.c_str()).error(), error::file_error);
+}
+
+TEST(FlightRecorder_Tests, RecordsConnectionEvents) {
+    FlightRecorder recorder(1024);
+
+    ImKcpp<MTU> sender(Conv{1});
+    ImKcpp<MTU> receiver(Conv{1});
+    sender.set_flight_recorder(&recorder);
+    receiver.set_flight_recorder(&recorder);
+
+    ASSERT_TRUE(sender.send(std::vector<std::byte>(3000)).has_value());
+
+    std::vector<std::vector<std::byte>> to_receiver;
+    std::vector<std::vector<std::byte>> to_sender;
+
+    for (u32 current = 0; current <= 1000; current += 10) {
+        sender.update(current, [&](const std::span<const std::byte> data) { to_receiver.emplace_back(data.begin(), data.end()); });
+        receiver.update(current, [&](const std::span<const std::byte> data) { to_sender.emplace_back(data.begin(), data.end()); });
+
+        for (const auto& datagram : to_receiver) {
+            ASSERT_TRUE(receiver.input(datagram).has_value());
+        }
+        for (const auto& datagram : to_sender) {
+            ASSERT_TRUE(sender.input(datagram).has_value());
+        }
+
+        to_receiver.clear();
+        to_sender.clear();
+    }
+
+    size_t pushes_sent = 0, pushes_received = 0, acks_received = 0, flushes = 0;
+
+    recorder.for_each([&](const FlightRecord& record) {
+        const bool push = record.cmd == commands::PUSH.get();
+
+        pushes_sent += record.event == FlightEvent::HeaderSent && push;
+        pushes_received += record.event == FlightEvent::HeaderReceived && push;
+        acks_received += record.event == FlightEvent::HeaderReceived && record.cmd == commands::ACK.get();
+        flushes += record.event == FlightEvent::Flushed;
+    });
+
+    ASSERT_EQ(pushes_sent, 3);
+    ASSERT_EQ(pushes_received, 3);
+    ASSERT_EQ(acks_received, 3);
+    ASSERT_GE(flushes, 2);
+
+    sender.set_flight_recorder(nullptr);
+    receiver.set_flight_recorder(nullptr);
+
+    const u64 written = recorder.get_written();
+    sender.update(2000, [](std::span<const std::byte>) { });
+    ASSERT_EQ(recorder.get_written(), written);
+}
+
+TEST(FlightRecorder_Tests, DumpsOnDeadLink) {
+    const std::string path = temp_path("imkcpp_flight_recorder_dead_link.bin");
+    std::filesystem::remove(path);
+
+    FlightRecorder recorder(256);
+    recorder.set_dead_link_dump(path);
+
+    ImKcpp<MTU> kcp(Conv{3});
+    kcp.set_flight_recorder(&recorder);
+    kcp.set_deadlink(3);
+
+    ASSERT_TRUE(kcp.send(std::vector<std::byte>(100)).has_value());
+
+    // Nothing ever comes back
+    for (u32 current = 0; current < 60000 && kcp.get_state() != State::DeadLink; current += 10) {
+        kcp.update(current, [](std::span<const std::byte>) { });
+    }
+
+    ASSERT_EQ(kcp.get_state(), State::DeadLink);
+
+    const auto dump = FlightRecorder::load(path.c_str());
+    ASSERT_TRUE(dump.has_value());
+    ASSERT_EQ(dump->records.back().event, FlightEvent::DeadLink);
+    ASSERT_EQ(dump->records.back().conv, 3);
+    ASSERT_EQ(dump->records.back().b, 1);
+
+    const size_t transmissions = std::count_if(dump->records.begin(), dump->records.end(), [](const FlightRecord& record) {
+        return record.event == FlightEvent::HeaderSent && record.cmd == commands::PUSH.get();
+    });
+
+    ASSERT_EQ(transmissions, 3);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <set>
+#include "imkcpp.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = constants::IKCP_MTU_DEF;
+
+    /// Builds datagrams the way a hostile or buggy peer could, segment by segment.
+    class DatagramBuilder final {
+        std::vector<std::byte> bytes{};
+
+    public:
+        DatagramBuilder& add(SegmentHeader header, const std::span<const std::byte> payload = {}) {
+            header.conv = Conv{1};
+            header.len = PayloadLen(static_cast<u32>(payload.size()));
+
+            size_t offset = this->bytes.size();
+            this->bytes.resize(offset + serializer::fixed_size<SegmentHeader>() + payload.size());
+
+            serializer::serialize(header, this->bytes, offset);
+            std::memcpy(this->bytes.data() + offset, payload.data(), payload.size());
+
+            return *this;
+        }
+
+        [[nodiscard]] std::span<const std::byte> get() const {
+            return this->bytes;
+        }
+    };
+}
+
+TEST(InputBounds_Tests, RejectsDatagramLargerThanMtu) {
+    ImKcpp<MTU> kcp(Conv{1});
+
+    const std::vector<std::byte> payload(MTU - serializer::fixed_size<SegmentHeader>());
+
+    DatagramBuilder fits;
+    fits.add(SegmentHeader{ .cmd = commands::PUSH, .wnd = 128, .sn = 0 }, payload);
+    ASSERT_TRUE(kcp.input(fits.get()).has_value());
+
+    const std::vector<std::byte> larger(payload.size() + 1);
+
+    DatagramBuilder too_large;
+    too_large.add(SegmentHeader{ .cmd = commands::PUSH, .wnd = 128, .sn = 1 }, larger);
+
+    const auto result = kcp.input(too_large.get());
+    ASSERT_FALSE(result.has_value());
+    ASSERT_EQ(result.error(), error::datagram_too_large);
+}
+
+TEST(InputBounds_Tests, ReverseOrderPushesAreReassembled) {
+    ImKcpp<MTU> kcp(Conv{1});
+
+    // Every segment lands in front of all the buffered ones
+    for (u32 sn = 100; sn > 0; --sn) {
+        const std::array<std::byte, 4> payload{ static_cast<std::byte>(sn - 1) };
+
+        DatagramBuilder datagram;
+        datagram.add(SegmentHeader{ .cmd = commands::PUSH, .wnd = 128, .sn = sn - 1 }, payload);
+        ASSERT_TRUE(kcp.input(datagram.get()).has_value());
+    }
+
+    std::array<std::byte, 4> buffer{};
+
+    for (u32 sn = 0; sn < 100; ++sn) {
+        ASSERT_EQ(kcp.recv(buffer).value_or(0), 4);
+        ASSERT_EQ(buffer[0], static_cast<std::byte>(sn));
+    }
+
+    ASSERT_FALSE(kcp.recv(buffer).has_value());
+}
+
+TEST(InputBounds_Tests, InterleavedPushesAreReassembled) {
+    ImKcpp<MTU> kcp(Conv{1});
+    kcp.set_receive_window(256);
+
+    std::array<std::byte, 1> buffer{};
+
+    // The second round starts in the middle of the receive buffer's slots
+    for (const u32 base : {0u, 200u}) {
+        // Odd sequence numbers first, then even ones from the back, so every one of those lands between buffered segments
+        std::vector<u32> order;
+        for (u32 offset = 1; offset < 200; offset += 2) {
+            order.push_back(base + offset);
+        }
+        for (u32 offset = 200; offset > 0; offset -= 2) {
+            order.push_back(base + offset - 2);
+        }
+
+        for (const u32 sn : order) {
+            const std::array<std::byte, 1> payload{ static_cast<std::byte>(sn) };
+
+            DatagramBuilder datagram;
+            datagram.add(SegmentHeader{ .cmd = commands::PUSH, .wnd = 128, .sn = sn }, payload);
+            ASSERT_TRUE(kcp.input(datagram.get()).has_value());
+        }
+
+        for (u32 sn = base; sn < base + 200; ++sn) {
+            ASSERT_EQ(kcp.recv(buffer).value_or(0), 1);
+            ASSERT_EQ(buffer[0], static_cast<std::byte>(sn));
+        }
+
+        ASSERT_FALSE(kcp.recv(buffer).has_value());
+    }
+}
+
+TEST(InputBounds_Tests, AckFloodForArbitrarySequenceNumbers) {
+    ImKcpp<MTU> kcp(Conv{1});
+    kcp.set_nodelay(1);
+    kcp.set_interval(10);
+    kcp.set_send_window(64);
+    kcp.set_congestion_window_enabled(false);
+
+    const std::array<std::byte, 16> message{};
+
+    for (u32 i = 0; i < 40; ++i) {
+        ASSERT_TRUE(kcp.send(message).has_value());
+    }
+
+    kcp.update(100, [](std::span<const std::byte>) { });
+    ASSERT_EQ(kcp.get_stats().inflight, 40);
+
+    // Unknown, duplicate and valid acks in no particular order, as many as fit in a datagram
+    DatagramBuilder datagram;
+    std::set<u32> acked;
+
+    for (u32 i = 0; i < MTU / serializer::fixed_size<SegmentHeader>(); ++i) {
+        const u32 sn = (i * 37) % 64;
+        datagram.add(SegmentHeader{ .cmd = commands::ACK, .wnd = 128, .ts = 100, .sn = sn });
+
+        if (sn < 40) {
+            acked.insert(sn);
+        }
+    }
+
+    ASSERT_TRUE(kcp.input(datagram.get()).has_value());
+
+    kcp.update(110, [](std::span<const std::byte>) { });
+    ASSERT_EQ(kcp.get_stats().inflight, 40 - acked.size());
+}
+
+TEST(InputBounds_Tests, NackRangesBeyondLimitAreIgnored) {
+    ImKcpp<MTU> kcp(Conv{1});
+    kcp.set_nodelay(1);
+    kcp.set_interval(10);
+    kcp.set_send_window(64);
+    kcp.set_congestion_window_enabled(false);
+
+    const std::array<std::byte, 16> message{};
+
+    for (u32 i = 0; i < 40; ++i) {
+        ASSERT_TRUE(kcp.send(message).has_value());
+    }
+
+    kcp.update(100, [](std::span<const std::byte>) { });
+
+    // One range per segment in flight, more than a NACK ever carries
+    std::vector<std::byte> ranges(40 * serializer::fixed_size<NackRange>());
+    size_t offset = 0;
+    for (u32 sn = 0; sn < 40; ++sn) {
+        serializer::serialize(NackRange{ .sn = sn, .count = 1 }, ranges, offset);
+    }
+
+    DatagramBuilder datagram;
+    datagram.add(SegmentHeader{ .cmd = commands::NACK, .wnd = 128 }, ranges);
+    ASSERT_TRUE(kcp.input(datagram.get()).has_value());
+
+    const FlushResult result = kcp.update(110, [](std::span<const std::byte>) { });
+    ASSERT_EQ(result.nack_retransmitted_count, constants::IKCP_NACK_MAX_RANGES);
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <thread>
+#include "transport/linux_io_uring.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::transport;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    std::unique_ptr<IoUringTransport<MTU>> open_loopback(const bool accept, const u32 send_buffers = 16) {
+        IoUringConfig config;
+        config.bind_address = UdpAddress::ipv4("127.0.0.1", 0).value();
+        config.accept_connections = accept;
+        config.recv_buffers = 16;
+        config.send_buffers = send_buffers;
+
+        auto transport = IoUringTransport<MTU>::open(config);
+        return transport.has_value() ? std::move(transport.value()) : nullptr;
+    }
+
+    /// Sends a datagram from a plain socket, bypassing any connection.
+    void send_raw(const UdpAddress& to, const std::span<const std::byte> data) {
+        const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(::sendto(fd, data.data(), data.size(), 0, to.get(), to.length), static_cast<ssize_t>(data.size()));
+        ::close(fd);
+    }
+}
+
+TEST(IoUringTransport_Tests, LoopbackExchange) {
+    auto server = open_loopback(true);
+    auto client = open_loopback(false);
+
+    if (server == nullptr || client == nullptr) {
+        GTEST_SKIP() << "io_uring with provided buffer rings is not available";
+    }
+
+    constexpr size_t MESSAGE_SIZE = 50 * 1000;
+    std::vector<std::byte> received;
+
+    server->set_accept_callback([](IoUringTransport<MTU>&, Conv, ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        kcp.set_receive_window(128);
+    });
+
+    server->set_receive_callback([&received](IoUringTransport<MTU>& transport, const Conv conv) {
+        std::vector<std::byte> buffer(MESSAGE_SIZE);
+
+        if (const auto size = transport.recv(conv, buffer); size.has_value()) {
+            buffer.resize(size.value());
+            received = std::move(buffer);
+        }
+    });
+
+    const auto kcp = client->connect(Conv{9}, server->local_address());
+    ASSERT_TRUE(kcp.has_value());
+    kcp.value()->set_nodelay(1);
+    kcp.value()->set_interval(10);
+    kcp.value()->set_send_window(128);
+
+    // More segments than receive buffers, so the multishot receive has to recycle them
+    std::vector<std::byte> message(MESSAGE_SIZE);
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<std::byte>(i * 7);
+    }
+
+    ASSERT_TRUE(client->send(Conv{9}, message).has_value());
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received.empty() && std::chrono::steady_clock::now() < deadline) {
+        client->poll(1);
+        server->poll(1);
+    }
+
+    ASSERT_EQ(received, message);
+    ASSERT_GT(server->get_stats().datagrams_received, 16);
+    ASSERT_GT(client->get_stats().datagrams_sent, 16);
+}
+
+TEST(IoUringTransport_Tests, SendBuffersRunOutWhileAcksArrive) {
+    auto server = open_loopback(true);
+    auto client = open_loopback(false, 2);
+
+    if (server == nullptr || client == nullptr) {
+        GTEST_SKIP() << "io_uring with provided buffer rings is not available";
+    }
+
+    constexpr size_t MESSAGE_SIZE = 50 * 1000;
+    constexpr size_t MESSAGES = 20;
+    std::vector<std::vector<std::byte>> received;
+    std::atomic<bool> done = false;
+
+    server->set_accept_callback([](IoUringTransport<MTU>&, Conv, ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(1);
+        kcp.set_receive_window(256);
+    });
+
+    server->set_receive_callback([&](IoUringTransport<MTU>& transport, const Conv conv) {
+        std::vector<std::byte> buffer(MESSAGE_SIZE);
+
+        while (true) {
+            const auto size = transport.recv(conv, buffer);
+
+            if (!size.has_value()) {
+                break;
+            }
+
+            received.emplace_back(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(size.value()));
+        }
+
+        done = received.size() == MESSAGES;
+    });
+
+    const auto kcp = client->connect(Conv{9}, server->local_address());
+    ASSERT_TRUE(kcp.has_value());
+    kcp.value()->set_nodelay(1);
+    kcp.value()->set_interval(1);
+    kcp.value()->set_send_window(256);
+
+    // Whole windows go out at once, so most segments wait for one of the two send buffers
+    kcp.value()->set_congestion_window_enabled(false);
+
+    std::vector<std::byte> message(MESSAGE_SIZE);
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<std::byte>(i * 13);
+    }
+
+    for (size_t i = 0; i < MESSAGES; ++i) {
+        ASSERT_TRUE(client->send(Conv{9}, message).has_value());
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    // The server acknowledges concurrently, so acks complete while the client is reclaiming send buffers
+    std::thread server_thread([&] {
+        while (!done && std::chrono::steady_clock::now() < deadline) {
+            server->poll(1);
+        }
+    });
+
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+        client->poll(1);
+    }
+
+    server_thread.join();
+
+    ASSERT_EQ(received.size(), MESSAGES);
+
+    for (const std::vector<std::byte>& data : received) {
+        ASSERT_EQ(data, message);
+    }
+
+    ASSERT_GT(client->get_stats().datagrams_received, 0);
+}
+
+TEST(IoUringTransport_Tests, TimeoutWakesForDeadline) {
+    auto transport = open_loopback(false);
+
+    if (transport == nullptr) {
+        GTEST_SKIP() << "io_uring with provided buffer rings is not available";
+    }
+
+    // Nothing is scheduled, so poll() sleeps for the whole wait
+    const auto start = std::chrono::steady_clock::now();
+    transport->poll(20);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_GE(elapsed, std::chrono::milliseconds(15));
+    ASSERT_LT(elapsed, std::chrono::seconds(1));
+}
+
+TEST(IoUringTransport_Tests, InvalidFirstDatagramIsNotAccepted) {
+    auto server = open_loopback(true);
+
+    if (server == nullptr) {
+        GTEST_SKIP() << "io_uring with provided buffer rings is not available";
+    }
+
+    size_t accepted = 0;
+    server->set_accept_callback([&accepted](IoUringTransport<MTU>&, Conv, ImKcpp<MTU>&) {
+        accepted++;
+    });
+
+    // Conv 0xFFFFFFFF with an unknown command
+    const std::vector<std::byte> junk(64, std::byte{0xFF});
+    send_raw(server->local_address(), junk);
+
+    for (int i = 0; i < 50 && server->get_stats().datagrams_rejected == 0; ++i) {
+        server->poll(1);
+    }
+
+    ASSERT_EQ(server->get_stats().datagrams_rejected, 1);
+    ASSERT_EQ(server->find(Conv{0xFFFFFFFF}), nullptr);
+    ASSERT_EQ(accepted, 0);
+}
+
+#endif
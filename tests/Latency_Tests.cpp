@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include "simulator/network_simulator.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::simulator;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    struct Transfer final {
+        SimulationResult result{};
+        MessageLatency sender{};
+        MessageLatency receiver{};
+    };
+
+    Transfer run(const SimulationConfig& config, const u32 send_window) {
+        ImKcpp<MTU> sender_kcp(Conv{1});
+        ImKcpp<MTU> receiver_kcp(Conv{1});
+
+        for (ImKcpp<MTU>* kcp : {&sender_kcp, &receiver_kcp}) {
+            kcp->set_nodelay(1);
+            kcp->set_interval(10);
+            kcp->set_fastresend(2);
+            kcp->set_send_window(send_window);
+            kcp->set_receive_window(256);
+            kcp->enable_latency_histograms();
+        }
+
+        KcpEndpoint<MTU> sender(sender_kcp);
+        KcpEndpoint<MTU> receiver(receiver_kcp);
+
+        Transfer transfer;
+        transfer.result = simulate(sender, receiver, config);
+        transfer.sender = sender_kcp.get_latency();
+        transfer.receiver = receiver_kcp.get_latency();
+
+        return transfer;
+    }
+}
+
+TEST(Latency_Tests, HistogramIsExactForSmallValues) {
+    LatencyHistogram histogram;
+
+    for (u32 value = 1; value <= 20; ++value) {
+        histogram.record(value);
+    }
+
+    ASSERT_EQ(histogram.get_count(), 20);
+    ASSERT_EQ(histogram.get_min(), 1);
+    ASSERT_EQ(histogram.get_max(), 20);
+    ASSERT_DOUBLE_EQ(histogram.get_mean(), 10.5);
+    ASSERT_EQ(histogram.percentile(50), 10);
+    ASSERT_EQ(histogram.percentile(100), 20);
+}
+
+TEST(Latency_Tests, HistogramRelativeError) {
+    for (const u32 value : {33u, 100u, 1000u, 12345u, 999999u}) {
+        LatencyHistogram histogram;
+        histogram.record(1);
+        histogram.record(value);
+        histogram.record(1u << 30);
+
+        const u32 reported = histogram.percentile(50);
+        ASSERT_GE(reported, value);
+        ASSERT_LE(reported - value, value / 16) << value;
+    }
+}
+
+TEST(Latency_Tests, HistogramsMerge) {
+    LatencyHistogram a;
+    LatencyHistogram b;
+    LatencyHistogram empty;
+
+    for (u32 i = 0; i < 90; ++i) {
+        a.record(10);
+    }
+
+    for (u32 i = 0; i < 10; ++i) {
+        b.record(500);
+    }
+
+    a += b;
+    a += empty;
+
+    ASSERT_EQ(a.get_count(), 100);
+    ASSERT_EQ(a.get_min(), 10);
+    ASSERT_EQ(a.get_max(), 500);
+    ASSERT_EQ(a.percentile(90), 10);
+    ASSERT_GE(a.percentile(95), 480);
+    ASSERT_EQ(empty.percentile(50), 0);
+}
+
+TEST(Latency_Tests, DisabledByDefault) {
+    const ImKcpp<MTU> kcp(Conv{1});
+
+    ASSERT_EQ(kcp.get_latency().queueing.get_count(), 0);
+}
+
+TEST(Latency_Tests, LosslessTransfer) {
+    SimulationConfig config;
+    config.forward.latency_ms = 50;
+    config.backward.latency_ms = 50;
+    config.message_size = 4000; // 3 fragments
+    config.message_count = 200;
+
+    const Transfer transfer = run(config, 16);
+    ASSERT_TRUE(transfer.result.completed);
+
+    // Every message is counted once, not once per fragment.
+    // The simulation stops once everything was read, when the last acknowledgement may still be in flight.
+    ASSERT_EQ(transfer.sender.queueing.get_count(), 200);
+    ASSERT_GE(transfer.sender.acknowledgement.get_count(), 199);
+    ASSERT_LE(transfer.sender.acknowledgement.get_count(), 200);
+    ASSERT_EQ(transfer.receiver.reassembly.get_count(), 200);
+    ASSERT_EQ(transfer.receiver.queueing.get_count(), 0);
+
+    // A small send window keeps messages in the send queue
+    ASSERT_GT(transfer.sender.queueing.get_max(), 100);
+
+    // An acknowledgement takes about one round trip, minus the clock granularity
+    ASSERT_GE(transfer.sender.acknowledgement.get_min(), 90);
+
+    // Without loss fragments arrive back to back, unless the window splits a message across round trips
+    ASSERT_LE(transfer.receiver.reassembly.percentile(50), 10);
+    ASSERT_GE(transfer.receiver.reassembly.get_max(), 90);
+}
+
+TEST(Latency_Tests, LossCausesHeadOfLineBlocking) {
+    SimulationConfig config;
+    config.forward.latency_ms = 20;
+    config.forward.loss = 0.05;
+    config.backward.latency_ms = 20;
+    config.message_count = 1000;
+
+    const Transfer transfer = run(config, 256);
+    ASSERT_TRUE(transfer.result.completed);
+
+    ASSERT_GE(transfer.sender.acknowledgement.get_count(), 990);
+    ASSERT_EQ(transfer.receiver.reassembly.get_count(), 1000);
+
+    // Messages behind a lost one wait for its retransmission
+    ASSERT_GT(transfer.receiver.reassembly.percentile(99), 10);
+    ASSERT_GT(transfer.sender.acknowledgement.percentile(99), transfer.sender.acknowledgement.percentile(50));
+}
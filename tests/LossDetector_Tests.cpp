@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "imkcpp.hpp"
+
+class LossDetectorTest : public testing::Test {
+protected:
+    imkcpp::LossDetector detector;
+
+    void SetUp() override {
+        detector.set_enabled(true);
+    }
+};
+
+TEST_F(LossDetectorTest, DisabledByDefault) {
+    imkcpp::LossDetector default_detector;
+    default_detector.ack_received(100, 2, 60);
+
+    ASSERT_FALSE(default_detector.is_enabled());
+    ASSERT_FALSE(default_detector.is_lost(1000, 1, 50, 40));
+}
+
+TEST_F(LossDetectorTest, NothingLostWithoutAcks) {
+    ASSERT_FALSE(detector.is_lost(1000, 1, 50, 40));
+}
+
+TEST_F(LossDetectorTest, EarlierSegmentLostAfterRttAndReorderingWindow) {
+    // Segment 2 sent at 60 is acknowledged at 100, RTT = 40, min RTT / 4 = 10
+    detector.ack_received(100, 2, 60);
+
+    ASSERT_EQ(detector.get_reordering_window(100, 40), 10);
+
+    // Segment 1 sent at 50 is lost at 50 + 40 + 10
+    ASSERT_FALSE(detector.is_lost(99, 1, 50, 40));
+    ASSERT_TRUE(detector.is_lost(100, 1, 50, 40));
+}
+
+TEST_F(LossDetectorTest, LaterSegmentsAreNotLost) {
+    detector.ack_received(100, 2, 60);
+
+    ASSERT_FALSE(detector.is_lost(1000, 3, 70, 40));
+}
+
+TEST_F(LossDetectorTest, SameTimestampUsesSequenceNumber) {
+    detector.ack_received(100, 2, 60);
+
+    ASSERT_TRUE(detector.is_lost(1000, 1, 60, 40));
+    ASSERT_FALSE(detector.is_lost(1000, 3, 60, 40));
+}
+
+TEST_F(LossDetectorTest, ReorderingGrowsWindow) {
+    detector.ack_received(100, 2, 60);
+
+    // Segment 1 sent before segment 2 is acknowledged 20 ms after it
+    detector.ack_received(120, 1, 50);
+
+    ASSERT_EQ(detector.get_reordering_window(120, 100), 30);
+
+    // Capped by srtt
+    ASSERT_EQ(detector.get_reordering_window(120, 25), 25);
+}
+
+TEST_F(LossDetectorTest, ReorderingWindowDecays) {
+    detector.ack_received(100, 2, 60);
+    detector.ack_received(120, 1, 50);
+
+    ASSERT_EQ(detector.get_reordering_window(120 + 16 * 40, 100), 30);
+    ASSERT_EQ(detector.get_reordering_window(120 + 16 * 40 + 1, 100), 10);
+}
+
+namespace {
+    /// Sends two segments at 100, acknowledges only the second at 110 and flushes at 125, past the reordering window.
+    imkcpp::FlushResult flush_after_reordered_ack(const imkcpp::u32 fastlimit) {
+        using namespace imkcpp;
+
+        ImKcpp<constants::IKCP_MTU_DEF> kcp(Conv{1});
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        kcp.set_congestion_window_enabled(false);
+        kcp.set_rack_enabled(true);
+        kcp.set_fastlimit(fastlimit);
+
+        const std::array<std::byte, 16> message{};
+        (void)kcp.send(message);
+        (void)kcp.send(message);
+
+        kcp.update(100, [](std::span<const std::byte>) { });
+        kcp.update(110, [](std::span<const std::byte>) { });
+
+        std::vector<std::byte> ack(serializer::fixed_size<SegmentHeader>());
+        size_t offset = 0;
+        serializer::serialize(SegmentHeader{ .conv = Conv{1}, .cmd = commands::ACK, .wnd = 128, .ts = 100, .sn = 1, .una = 0 }, ack, offset);
+        EXPECT_TRUE(kcp.input(ack).has_value());
+
+        return kcp.update(125, [](std::span<const std::byte>) { });
+    }
+}
+
+TEST(LossDetector_Tests, TimeLossResendsSegment) {
+    ASSERT_EQ(flush_after_reordered_ack(imkcpp::constants::IKCP_FASTACK_LIMIT).fast_retransmitted_count, 1);
+}
+
+TEST(LossDetector_Tests, TimeLossHonoursFastlimit) {
+    // The segment was already transmitted once, which uses up a limit of 1
+    ASSERT_EQ(flush_after_reordered_ack(1).fast_retransmitted_count, 0);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "imkcpp.hpp"
+
+class NackControllerTest : public testing::Test {
+protected:
+    imkcpp::Receiver receiver;
+    imkcpp::NackController controller;
+
+    void SetUp() override {
+        receiver.set_queue_limit(128);
+        controller.set_enabled(true);
+        controller.set_delay(20);
+    }
+
+    void receive(const imkcpp::u32 sn) {
+        imkcpp::SegmentData data{};
+        imkcpp::SegmentHeader header{ .sn = sn };
+        receiver.emplace_segment(header, data, 0);
+    }
+
+    [[nodiscard]] std::vector<imkcpp::NackRange> decode(const imkcpp::SegmentData& payload) const {
+        std::vector<imkcpp::NackRange> ranges;
+
+        size_t offset = 0;
+        while (offset < payload.dynamic_size()) {
+            imkcpp::NackRange range;
+            imkcpp::serializer::deserialize(range, payload.data, offset);
+            ranges.push_back(range);
+        }
+
+        return ranges;
+    }
+};
+
+TEST_F(NackControllerTest, NoGapsWhenInOrder) {
+    receive(0);
+    receive(1);
+
+    ASSERT_FALSE(receiver.has_gaps());
+}
+
+TEST_F(NackControllerTest, MissingRanges) {
+    receive(2);
+    receive(3);
+    receive(6);
+
+    ASSERT_TRUE(receiver.has_gaps());
+
+    const auto ranges = decode(controller.prepare(receiver, 0, 1000));
+    ASSERT_EQ(ranges.size(), 2);
+    ASSERT_EQ(ranges[0].sn, 0);
+    ASSERT_EQ(ranges[0].count, 2);
+    ASSERT_EQ(ranges[1].sn, 4);
+    ASSERT_EQ(ranges[1].count, 2);
+}
+
+TEST_F(NackControllerTest, PayloadIsLimitedBySize) {
+    receive(1);
+    receive(3);
+
+    const auto ranges = decode(controller.prepare(receiver, 0, imkcpp::serializer::fixed_size<imkcpp::NackRange>()));
+    ASSERT_EQ(ranges.size(), 1);
+    ASSERT_EQ(ranges[0].sn, 0);
+}
+
+TEST_F(NackControllerTest, SentAfterDelay) {
+    receive(1);
+
+    controller.update(receiver.has_gaps(), 100);
+    ASSERT_FALSE(controller.should_send(119));
+    ASSERT_TRUE(controller.should_send(120));
+
+    // Gap persisting doesn't restart the timer
+    controller.update(receiver.has_gaps(), 110);
+    ASSERT_TRUE(controller.should_send(120));
+
+    // Reported gaps are repeated after another delay
+    (void)controller.prepare(receiver, 120, 1000);
+    ASSERT_FALSE(controller.should_send(139));
+    ASSERT_TRUE(controller.should_send(140));
+}
+
+TEST_F(NackControllerTest, NotSentOnceGapIsFilled) {
+    receive(1);
+    controller.update(receiver.has_gaps(), 100);
+
+    receive(0);
+    controller.update(receiver.has_gaps(), 110);
+
+    ASSERT_FALSE(controller.should_send(200));
+}
+
+TEST_F(NackControllerTest, NotSentWhenDisabled) {
+    controller.set_enabled(false);
+
+    receive(1);
+    controller.update(receiver.has_gaps(), 100);
+
+    ASSERT_FALSE(controller.should_send(200));
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include "simulator/network_simulator.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::simulator;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    void configure(ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        kcp.set_fastresend(2);
+        kcp.set_send_window(256);
+        kcp.set_receive_window(256);
+    }
+
+    SimulationResult run(const SimulationConfig& config) {
+        ImKcpp<MTU> sender_kcp(Conv{1});
+        ImKcpp<MTU> receiver_kcp(Conv{1});
+        configure(sender_kcp);
+        configure(receiver_kcp);
+
+        KcpEndpoint<MTU> sender(sender_kcp);
+        KcpEndpoint<MTU> receiver(receiver_kcp);
+
+        return simulate(sender, receiver, config);
+    }
+
+    std::vector<u64> arrivals(Link& link, const u32 until_ms) {
+        std::vector<u64> result;
+
+        for (u32 t = 0; t <= until_ms; ++t) {
+            link.deliver(static_cast<u64>(t) * 1000, [&result, t](const std::span<const std::byte> data) {
+                result.push_back(t);
+                (void)data;
+            });
+        }
+
+        return result;
+    }
+}
+
+TEST(NetworkSimulator_Tests, LinkLatencyAndBandwidth) {
+    LinkConfig config;
+    config.latency_ms = 20;
+    config.bandwidth_bps = 8 * 1000 * 1000; // 1 byte per microsecond
+
+    Link link(config, 1);
+    const std::vector<std::byte> datagram(1000);
+
+    for (int i = 0; i < 3; ++i) {
+        link.send(0, datagram);
+    }
+
+    // Serialized one after another, 1 ms each
+    ASSERT_EQ(arrivals(link, 100), (std::vector<u64>{21, 22, 23}));
+}
+
+TEST(NetworkSimulator_Tests, LinkQueueDropsTail) {
+    LinkConfig config;
+    config.bandwidth_bps = 8 * 1000 * 1000;
+    config.queue_bytes = 3000;
+
+    Link link(config, 1);
+    const std::vector<std::byte> datagram(1000);
+
+    for (int i = 0; i < 5; ++i) {
+        link.send(0, datagram);
+    }
+
+    ASSERT_EQ(link.get_stats().queue_dropped, 2);
+    ASSERT_EQ(arrivals(link, 10).size(), 3);
+}
+
+TEST(NetworkSimulator_Tests, LinkLossModels) {
+    const std::vector<std::byte> datagram(100);
+
+    LinkConfig bernoulli;
+    bernoulli.loss = 0.1;
+
+    Link independent(bernoulli, 7);
+    for (int i = 0; i < 100000; ++i) {
+        independent.send(0, datagram);
+    }
+
+    ASSERT_NEAR(static_cast<double>(independent.get_stats().lost) / 100000.0, 0.1, 0.01);
+
+    // Mean burst length is 1 / bad_to_good, stationary loss is 0.01 / (0.01 + 0.25)
+    LinkConfig burst;
+    burst.burst_loss = GilbertElliott{ 0.01, 0.25, 0.0, 1.0 };
+
+    Link bursty(burst, 7);
+    std::vector<bool> lost;
+    u64 previous = 0;
+
+    for (int i = 0; i < 100000; ++i) {
+        bursty.send(0, datagram);
+        lost.push_back(bursty.get_stats().lost != previous);
+        previous = bursty.get_stats().lost;
+    }
+
+    size_t bursts = 0;
+    for (size_t i = 0; i < lost.size(); ++i) {
+        if (lost[i] && (i == 0 || !lost[i - 1])) {
+            bursts++;
+        }
+    }
+
+    ASSERT_NEAR(static_cast<double>(previous) / 100000.0, 0.01 / 0.26, 0.01);
+    ASSERT_NEAR(static_cast<double>(previous) / static_cast<double>(bursts), 4.0, 0.5);
+}
+
+TEST(NetworkSimulator_Tests, LinkReorderAndDuplicate) {
+    LinkConfig config;
+    config.latency_ms = 10;
+    config.reorder = 1.0;
+    config.reorder_delay_ms = 5;
+    config.duplicate = 1.0;
+
+    Link link(config, 3);
+    link.send(0, std::vector<std::byte>(10));
+
+    ASSERT_EQ(arrivals(link, 100), (std::vector<u64>{15, 15}));
+    ASSERT_EQ(link.get_stats().duplicated, 1);
+}
+
+TEST(NetworkSimulator_Tests, LosslessTransfer) {
+    SimulationConfig config;
+    config.forward.latency_ms = 25;
+    config.backward.latency_ms = 25;
+    config.message_count = 200;
+
+    const SimulationResult result = run(config);
+
+    ASSERT_TRUE(result.completed);
+    ASSERT_EQ(result.bytes_delivered, 200 * config.message_size);
+    ASSERT_EQ(result.segments_retransmitted, 0);
+    ASSERT_GE(result.latency_percentile(0), 25);
+    ASSERT_EQ(result.latencies_ms.size(), 200);
+}
+
+TEST(NetworkSimulator_Tests, LossyTransferIsDeterministic) {
+    SimulationConfig config;
+    config.forward = LinkConfig{ 10 * 1000 * 1000, 20, 5, 0.05 };
+    config.forward.reorder = 0.01;
+    config.forward.reorder_delay_ms = 10;
+    config.forward.duplicate = 0.01;
+    config.forward.queue_bytes = 64 * 1024;
+    config.backward = LinkConfig{ 10 * 1000 * 1000, 20, 5, 0.05 };
+    config.message_count = 500;
+    config.seed = 42;
+
+    const SimulationResult first = run(config);
+    const SimulationResult second = run(config);
+
+    ASSERT_TRUE(first.completed);
+    ASSERT_GT(first.segments_retransmitted, 0);
+    ASSERT_GT(first.retransmission_ratio(), 0.0);
+    ASSERT_LE(first.goodput_bps(), 10.0 * 1000 * 1000);
+
+    ASSERT_EQ(first.duration_ms, second.duration_ms);
+    ASSERT_EQ(first.segments_sent, second.segments_sent);
+    ASSERT_EQ(first.latencies_ms, second.latencies_ms);
+    ASSERT_EQ(first.wire_bytes(), second.wire_bytes());
+
+    config.seed = 43;
+    const SimulationResult other = run(config);
+    ASSERT_TRUE(other.completed);
+    ASSERT_NE(first.latencies_ms, other.latencies_ms);
+}
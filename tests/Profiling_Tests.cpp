@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include "imkcpp.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::profiling;
+
+namespace {
+    void spin(const u64 cycles) {
+        const u64 start = read_cycles();
+        while (read_cycles() - start < cycles) { }
+    }
+}
+
+TEST(Profiling_Tests, NestedScopesAreExclusive) {
+    const Profile before = collect();
+
+    {
+        const ScopedStage outer(Stage::RetransmitScan);
+        spin(20000);
+
+        {
+            const ScopedStage inner(Stage::FlusherSerialize);
+            spin(200000);
+        }
+    }
+
+    const Profile profile = difference(collect(), before);
+    const StageStats& outer = profile[static_cast<size_t>(Stage::RetransmitScan)];
+    const StageStats& inner = profile[static_cast<size_t>(Stage::FlusherSerialize)];
+
+    ASSERT_EQ(outer.count, 1);
+    ASSERT_EQ(inner.count, 1);
+    ASSERT_GE(inner.total_cycles, 200000);
+    ASSERT_GE(outer.total_cycles, 20000);
+    ASSERT_LT(outer.total_cycles, inner.total_cycles);
+}
+
+TEST(Profiling_Tests, HistogramPercentiles) {
+    StageStats stats{};
+
+    for (const u64 cycles : {100, 100, 100, 5000}) {
+        stats.count++;
+        stats.total_cycles += cycles;
+        stats.max_cycles = std::max(stats.max_cycles, cycles);
+        stats.buckets[std::bit_width(cycles)]++;
+    }
+
+    ASSERT_EQ(stats.mean(), 1325.0);
+    ASSERT_EQ(stats.percentile(50), 128);
+    ASSERT_EQ(stats.percentile(75), 128);
+    ASSERT_EQ(stats.percentile(100), 5000);
+    ASSERT_STREQ(stage_name(Stage::HeaderDecode), "header_decode");
+}
+
+TEST(Profiling_Tests, CollectsFinishedThreads) {
+    const Profile before = collect();
+
+    std::thread worker([] {
+        const ScopedStage scope(Stage::RecvCopy);
+    });
+    worker.join();
+
+    const Profile profile = difference(collect(), before);
+    ASSERT_EQ(profile[static_cast<size_t>(Stage::RecvCopy)].count, 1);
+}
+
+#if defined(IMKCPP_ENABLE_PROFILING)
+TEST(Profiling_Tests, InstrumentedStages) {
+    constexpr size_t MTU = 1400;
+
+    ImKcpp<MTU> sender(Conv{1});
+    ImKcpp<MTU> receiver(Conv{1});
+
+    const Profile before = collect();
+
+    ASSERT_TRUE(sender.send(std::vector<std::byte>(5000)).has_value());
+
+    std::vector<std::vector<std::byte>> to_receiver;
+    std::vector<std::vector<std::byte>> to_sender;
+
+    for (u32 current = 0; current < 1000; current += 100) {
+        sender.update(current, [&](const std::span<const std::byte> data) { to_receiver.emplace_back(data.begin(), data.end()); });
+        receiver.update(current, [&](const std::span<const std::byte> data) { to_sender.emplace_back(data.begin(), data.end()); });
+
+        for (const auto& datagram : to_receiver) {
+            ASSERT_TRUE(receiver.input(datagram).has_value());
+        }
+        for (const auto& datagram : to_sender) {
+            ASSERT_TRUE(sender.input(datagram).has_value());
+        }
+
+        to_receiver.clear();
+        to_sender.clear();
+    }
+
+    std::array<std::byte, 5000> buffer{};
+    ASSERT_EQ(receiver.recv(buffer).value(), 5000);
+
+    const Profile profile = difference(collect(), before);
+
+    for (size_t stage = 0; stage < STAGE_COUNT; ++stage) {
+        ASSERT_GT(profile[stage].count, 0) << stage_name(static_cast<Stage>(stage));
+    }
+}
+#endif
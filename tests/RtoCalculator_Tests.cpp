@@ -24,8 +24,12 @@ TEST_F(RtoCalculatorTest, UpdateRtoWithValidRtt) {
     constexpr u32 current_time = 1000;
     constexpr u32 timestamp = 950; // RTT of 50
 
+    EXPECT_FALSE(rto_calculator.has_rtt_sample());
+
     rto_calculator.update_rto(current_time, timestamp);
 
+    EXPECT_TRUE(rto_calculator.has_rtt_sample());
+    EXPECT_EQ(rto_calculator.get_srtt(), 50);
     EXPECT_EQ(rto_calculator.get_last_rtt(), 50);
     EXPECT_EQ(rto_calculator.get_rto(), 150);
 }
@@ -40,4 +44,14 @@ TEST_F(RtoCalculatorTest, UpdateRtoWithNegativeRtt) {
 
     EXPECT_EQ(rto_calculator.get_last_rtt(), 0);
     EXPECT_EQ(rto_calculator.get_rto(), constants::IKCP_RTO_DEF);
-}
\ No newline at end of file
+}
+
+TEST_F(RtoCalculatorTest, SpuriousRetransmissionRaisesEstimates) {
+    using namespace imkcpp;
+
+    rto_calculator.update_rto(1000, 950); // RTT of 50, RTO of 150
+    rto_calculator.spurious_retransmission(1400, 1000); // Delayed by 400
+
+    EXPECT_EQ(rto_calculator.get_srtt(), 400);
+    EXPECT_EQ(rto_calculator.get_rto(), 400 + 4 * 200);
+}
@@ -360,4 +360,376 @@ TEST(Send_Tests, Send_ReceivedMalformedData) {
 
         ASSERT_EQ(kcp.input(data).error(), error::header_and_payload_length_mismatch);
     }
-}
\ No newline at end of file
+}
+
+TEST(Send_Tests, Send_TailLossProbe) {
+    using namespace imkcpp;
+
+    constexpr size_t max_segment_size = MTU_TO_MSS<constants::IKCP_MTU_DEF>();
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_output(Conv{0});
+    kcp_output.set_interval(10);
+    kcp_output.set_tail_loss_probe_enabled(true);
+    kcp_output.update(0, [](std::span<const std::byte>) { });
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_input(Conv{0});
+    kcp_input.set_interval(10);
+    kcp_input.update(0, [](std::span<const std::byte>) { });
+
+    bool drop_tail = false;
+    u32 tail_sn = 0;
+
+    auto output_to_input = [&](const std::span<const std::byte> data) {
+        SegmentHeader header;
+        size_t offset = 0;
+        serializer::deserialize(header, data, offset);
+
+        if (drop_tail && header.sn == tail_sn) {
+            drop_tail = false;
+            return;
+        }
+
+        kcp_input.input(data);
+    };
+
+    auto input_to_output = [&](const std::span<const std::byte> data) {
+        kcp_output.input(data);
+    };
+
+    std::vector<std::byte> buffer(max_segment_size * 3);
+    std::vector<std::byte> recv_buffer(buffer.size());
+
+    u32 now = 0;
+    FlushResult total{};
+
+    const auto run_until_received = [&] {
+        for (size_t i = 0; i < 1000 && kcp_input.peek_size() != buffer.size(); ++i) {
+            now += 10;
+            total += kcp_output.update(now, output_to_input);
+            kcp_input.update(now, input_to_output);
+        }
+    };
+
+    // Warm up to get an RTT sample
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    // Drop the last segment of the second message
+    total = {};
+    drop_tail = true;
+    tail_sn = 5;
+
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    ASSERT_FALSE(drop_tail);
+    ASSERT_EQ(total.tail_loss_probe_count, 1);
+    ASSERT_EQ(total.timeout_retransmitted_count, 0);
+}
+
+TEST(Send_Tests, Send_TailLossProbeIsNotSpurious) {
+    using namespace imkcpp;
+
+    constexpr size_t max_segment_size = MTU_TO_MSS<constants::IKCP_MTU_DEF>();
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_output(Conv{0});
+    kcp_output.set_interval(10);
+    kcp_output.set_tail_loss_probe_enabled(true);
+    kcp_output.update(0, [](std::span<const std::byte>) { });
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_input(Conv{0});
+    kcp_input.set_interval(10);
+    kcp_input.update(0, [](std::span<const std::byte>) { });
+
+    bool delay_tail = false;
+    std::vector<std::byte> delayed{};
+    u32 tail_sn = 0;
+
+    // The original transmission of the tail is held back until the probe is sent, then delivered in its place
+    auto output_to_input = [&](const std::span<const std::byte> data) {
+        SegmentHeader header;
+        size_t offset = 0;
+        serializer::deserialize(header, data, offset);
+
+        if (delay_tail && header.sn == tail_sn) {
+            if (delayed.empty()) {
+                delayed.assign(data.begin(), data.end());
+                return;
+            }
+
+            delay_tail = false;
+            kcp_input.input(delayed);
+            return;
+        }
+
+        kcp_input.input(data);
+    };
+
+    InputResult input_total{};
+
+    auto input_to_output = [&](const std::span<const std::byte> data) {
+        const auto result = kcp_output.input(data);
+        ASSERT_TRUE(result.has_value());
+        input_total += result.value();
+    };
+
+    std::vector<std::byte> buffer(max_segment_size * 3);
+    std::vector<std::byte> recv_buffer(buffer.size());
+
+    u32 now = 0;
+    FlushResult total{};
+
+    const auto run_until_received = [&] {
+        for (size_t i = 0; i < 1000 && kcp_input.peek_size() != buffer.size(); ++i) {
+            now += 10;
+            total += kcp_output.update(now, output_to_input);
+            kcp_input.update(now, input_to_output);
+        }
+    };
+
+    // Warm up to get an RTT sample
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    total = {};
+    input_total = {};
+    delay_tail = true;
+    tail_sn = 5;
+
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    // Flush the ack which echoes the original transmission
+    now += 10;
+    kcp_input.update(now, input_to_output);
+
+    ASSERT_FALSE(delay_tail);
+    ASSERT_EQ(total.tail_loss_probe_count, 1);
+    ASSERT_EQ(input_total.spurious_retransmitted_count, 0);
+}
+
+TEST(Send_Tests, Send_RackDetectsLoss) {
+    using namespace imkcpp;
+
+    constexpr size_t max_segment_size = MTU_TO_MSS<constants::IKCP_MTU_DEF>();
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_output(Conv{0});
+    kcp_output.set_interval(10);
+    kcp_output.set_rack_enabled(true);
+    kcp_output.set_congestion_window_enabled(false);
+    kcp_output.update(0, [](std::span<const std::byte>) { });
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_input(Conv{0});
+    kcp_input.set_interval(10);
+    kcp_input.update(0, [](std::span<const std::byte>) { });
+
+    bool drop = false;
+    constexpr u32 dropped_sn = 4;
+
+    auto output_to_input = [&](const std::span<const std::byte> data) {
+        SegmentHeader header;
+        size_t offset = 0;
+        serializer::deserialize(header, data, offset);
+
+        if (drop && header.sn == dropped_sn) {
+            drop = false;
+            return;
+        }
+
+        kcp_input.input(data);
+    };
+
+    auto input_to_output = [&](const std::span<const std::byte> data) {
+        kcp_output.input(data);
+    };
+
+    std::vector<std::byte> buffer(max_segment_size * 3);
+    std::vector<std::byte> recv_buffer(buffer.size());
+
+    u32 now = 0;
+    FlushResult total{};
+
+    const auto run_until_received = [&] {
+        for (size_t i = 0; i < 1000 && kcp_input.peek_size() != buffer.size(); ++i) {
+            now += 10;
+            total += kcp_output.update(now, output_to_input);
+            kcp_input.update(now, input_to_output);
+        }
+    };
+
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    // Drop the middle segment of the second message, fastresend is disabled
+    total = {};
+    drop = true;
+
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    ASSERT_FALSE(drop);
+    ASSERT_EQ(total.fast_retransmitted_count, 1);
+    ASSERT_EQ(total.timeout_retransmitted_count, 0);
+}
+
+TEST(Send_Tests, Send_SpuriousRetransmission) {
+    using namespace imkcpp;
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_output(Conv{0});
+    kcp_output.set_interval(10);
+    kcp_output.update(0, [](std::span<const std::byte>) { });
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_input(Conv{0});
+    kcp_input.set_interval(10);
+    kcp_input.update(0, [](std::span<const std::byte>) { });
+
+    bool delay_spike = false;
+    std::vector<std::byte> delayed{};
+
+    auto output_to_input = [&](const std::span<const std::byte> data) {
+        if (delay_spike) {
+            SegmentHeader header;
+            size_t offset = 0;
+            serializer::deserialize(header, data, offset);
+
+            if (header.cmd == commands::PUSH) {
+                if (delayed.empty()) {
+                    // Original transmission is stuck in the network
+                    delayed.assign(data.begin(), data.end());
+                    return;
+                }
+
+                // Original arrives after the timeout, retransmission is lost
+                delay_spike = false;
+                kcp_input.input(delayed);
+                return;
+            }
+        }
+
+        kcp_input.input(data);
+    };
+
+    std::vector<std::byte> buffer(100);
+    std::vector<std::byte> recv_buffer(buffer.size());
+
+    u32 now = 0;
+    FlushResult flush_total{};
+    InputResult input_total{};
+
+    auto input_to_output_counted = [&](const std::span<const std::byte> data) {
+        const auto result = kcp_output.input(data);
+        ASSERT_TRUE(result.has_value());
+        input_total += result.value();
+    };
+
+    const auto run_until_received = [&] {
+        for (size_t i = 0; i < 1000 && kcp_input.peek_size() != buffer.size(); ++i) {
+            now += 10;
+            flush_total += kcp_output.update(now, output_to_input);
+            kcp_input.update(now, input_to_output_counted);
+        }
+    };
+
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    flush_total = {};
+    input_total = {};
+    delay_spike = true;
+
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+    run_until_received();
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    // Flush the ack for the delayed original
+    now += 10;
+    kcp_input.update(now, input_to_output_counted);
+
+    ASSERT_FALSE(delay_spike);
+    ASSERT_EQ(flush_total.timeout_retransmitted_count, 1);
+    ASSERT_EQ(input_total.spurious_retransmitted_count, 1);
+}
+
+TEST(Send_Tests, Send_NackRecovery) {
+    using namespace imkcpp;
+
+    constexpr size_t max_segment_size = MTU_TO_MSS<constants::IKCP_MTU_DEF>();
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_output(Conv{0});
+    kcp_output.set_interval(10);
+    kcp_output.set_congestion_window_enabled(false);
+    kcp_output.update(0, [](std::span<const std::byte>) { });
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp_input(Conv{0});
+    kcp_input.set_interval(10);
+    kcp_input.set_nack_enabled(true);
+    kcp_input.set_nack_delay(10);
+    kcp_input.update(0, [](std::span<const std::byte>) { });
+
+    bool drop = true;
+    constexpr u32 dropped_sn = 1;
+
+    auto output_to_input = [&](const std::span<const std::byte> data) {
+        SegmentHeader header;
+        size_t offset = 0;
+        serializer::deserialize(header, data, offset);
+
+        if (drop && header.sn == dropped_sn) {
+            drop = false;
+            return;
+        }
+
+        kcp_input.input(data);
+    };
+
+    InputResult input_total{};
+    auto input_to_output = [&](const std::span<const std::byte> data) {
+        const auto result = kcp_output.input(data);
+        ASSERT_TRUE(result.has_value()) << err_to_str(result.error());
+        input_total += result.value();
+    };
+
+    std::vector<std::byte> buffer(max_segment_size * 3);
+    std::vector<std::byte> recv_buffer(buffer.size());
+
+    ASSERT_TRUE(kcp_output.send(buffer).has_value());
+
+    FlushResult total{};
+    u32 now = 0;
+
+    for (size_t i = 0; i < 1000 && kcp_input.peek_size() != buffer.size(); ++i) {
+        now += 10;
+        total += kcp_output.update(now, output_to_input);
+        kcp_input.update(now, input_to_output);
+    }
+
+    ASSERT_TRUE(kcp_input.recv(recv_buffer).has_value());
+
+    ASSERT_FALSE(drop);
+    ASSERT_GE(input_total.cmd_nack_count, 1);
+    ASSERT_EQ(total.nack_retransmitted_count, 1);
+    ASSERT_EQ(total.timeout_retransmitted_count, 0);
+}
+
+TEST(Send_Tests, Send_ReceivedMalformedNack) {
+    using namespace imkcpp;
+
+    ImKcpp<constants::IKCP_MTU_DEF> kcp(Conv{0});
+
+    std::vector<std::byte> data(serializer::fixed_size<SegmentHeader>() + 3);
+    SegmentHeader header{};
+    header.cmd = commands::NACK;
+    header.len = PayloadLen(3);
+
+    size_t offset = 0;
+    serializer::serialize(header, data, offset);
+
+    ASSERT_EQ(kcp.input(data).error(), error::malformed_payload);
+}
@@ -28,7 +28,7 @@ TEST_F(SenderBufferTest, Erase) {
     Segment segment{ SegmentHeader{ .sn = 2 }, segment_data };
     buffer.push_segment(segment);
 
-    buffer.erase(2);
+    buffer.erase(2, 0);
     ASSERT_TRUE(buffer.empty());
 }
 
@@ -45,17 +45,17 @@ TEST_F(SenderBufferTest, EraseBefore) {
     buffer.push_segment(segment2);
     buffer.push_segment(segment3);
 
-    buffer.erase_before(3);
+    buffer.erase_before(3, 0);
 
     ASSERT_FALSE(buffer.empty());
     ASSERT_EQ(buffer.get_first_sequence_number_in_flight(), 3);
     ASSERT_EQ(buffer.size(), 2);
 
-    buffer.erase_before(4);
+    buffer.erase_before(4, 0);
     ASSERT_FALSE(buffer.empty());
     ASSERT_EQ(buffer.get_first_sequence_number_in_flight(), 4);
 
-    buffer.erase_before(5);
+    buffer.erase_before(5, 0);
     ASSERT_TRUE(buffer.empty());
     ASSERT_EQ(buffer.get_first_sequence_number_in_flight(), std::nullopt);
 }
@@ -99,4 +99,43 @@ TEST_F(SenderBufferTest, GetEarliestTransmitDelta) {
     const auto earliest_delta = buffer.get_earliest_transmit_delta(10);
     ASSERT_TRUE(earliest_delta.has_value());
     ASSERT_EQ(earliest_delta.value(), 90);
-}
\ No newline at end of file
+}
+
+TEST_F(SenderBufferTest, EraseInAnyOrder) {
+    using namespace imkcpp;
+
+    for (u32 sn = 0; sn < 10; ++sn) {
+        SegmentData data{};
+        Segment segment{ SegmentHeader{ .sn = sn }, data };
+        buffer.push_segment(segment);
+    }
+
+    for (const u32 sn : {7u, 2u, 9u, 0u, 5u}) {
+        const auto erased = buffer.erase(sn, 0);
+        ASSERT_TRUE(erased.has_value());
+        ASSERT_EQ(erased->header.sn, sn);
+    }
+
+    ASSERT_FALSE(buffer.erase(7, 0).has_value());
+    ASSERT_FALSE(buffer.erase(20, 0).has_value());
+
+    // Acked segments between ones still in flight are kept until they reach an end of the buffer
+    std::vector<u32> remaining;
+    for (const Segment& segment : buffer) {
+        if (!segment.metadata.acked) {
+            remaining.push_back(segment.header.sn);
+        }
+    }
+
+    ASSERT_EQ(remaining, (std::vector<u32>{1, 3, 4, 6, 8}));
+    ASSERT_EQ(buffer.size(), 5);
+    ASSERT_EQ(buffer.get_first_sequence_number_in_flight(), 1);
+    ASSERT_EQ(buffer.back().header.sn, 8);
+
+    buffer.erase_before(7, 0);
+    ASSERT_EQ(buffer.size(), 1);
+    ASSERT_EQ(buffer.get_first_sequence_number_in_flight(), 8);
+
+    buffer.erase(8, 0);
+    ASSERT_TRUE(buffer.empty());
+}
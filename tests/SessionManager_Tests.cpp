@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include "session_manager.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    struct Datagram final {
+        Conv conv;
+        std::vector<std::byte> data;
+    };
+}
+
+TEST(SessionManager_Tests, CreateFindRemove) {
+    SessionManager<MTU> manager;
+
+    for (u32 i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(manager.create(Conv{i}).has_value());
+    }
+
+    ASSERT_EQ(manager.size(), 1000);
+    ASSERT_EQ(manager.create(Conv{5}).error(), error::conv_already_exists);
+
+    for (u32 i = 0; i < 1000; i += 2) {
+        ASSERT_TRUE(manager.remove(Conv{i}));
+    }
+
+    ASSERT_FALSE(manager.remove(Conv{0}));
+    ASSERT_EQ(manager.size(), 500);
+
+    for (u32 i = 0; i < 1000; ++i) {
+        ImKcpp<MTU>* kcp = manager.find(Conv{i});
+
+        if (i % 2 == 0) {
+            ASSERT_EQ(kcp, nullptr);
+        } else {
+            ASSERT_NE(kcp, nullptr);
+            ASSERT_EQ(kcp->get_conv(), Conv{i});
+        }
+    }
+}
+
+TEST(SessionManager_Tests, PeekConv) {
+    std::array<std::byte, 4> data{ std::byte{0}, std::byte{0}, std::byte{1}, std::byte{2} };
+
+    ASSERT_EQ(peek_conv(data).value(), Conv{0x0102});
+    ASSERT_FALSE(peek_conv(std::span(data).first(3)).has_value());
+}
+
+TEST(SessionManager_Tests, InputUnknownConv) {
+    SessionManager<MTU> manager;
+    std::vector<std::byte> data(serializer::fixed_size<SegmentHeader>(), std::byte{0});
+
+    ASSERT_EQ(manager.input(std::span(data).first(2)).error(), error::less_than_header_size);
+    ASSERT_EQ(manager.input(data).error(), error::unknown_conv);
+    ASSERT_EQ(manager.send(Conv{1}, data).error(), error::unknown_conv);
+}
+
+TEST(SessionManager_Tests, IdleSessionsAreParked) {
+    SessionManager<MTU> manager;
+
+    for (u32 i = 0; i < 100; ++i) {
+        ASSERT_TRUE(manager.create(Conv{i}).has_value());
+    }
+
+    const auto ignore = [](Conv, std::span<const std::byte>) { };
+
+    ASSERT_EQ(manager.active_count(), 100);
+    manager.update(0, ignore);
+    ASSERT_EQ(manager.active_count(), 0);
+
+    std::vector<std::byte> payload(100, std::byte{1});
+    ASSERT_TRUE(manager.send(Conv{42}, payload).has_value());
+    ASSERT_EQ(manager.active_count(), 1);
+
+    size_t sent = 0;
+    manager.update(100, [&](const Conv conv, std::span<const std::byte>) {
+        ASSERT_EQ(conv, Conv{42});
+        sent++;
+    });
+
+    ASSERT_EQ(sent, 1);
+
+    // Waiting for the ack
+    ASSERT_EQ(manager.active_count(), 1);
+}
+
+TEST(SessionManager_Tests, ExchangeBetweenManagers) {
+    SessionManager<MTU> client;
+    SessionManager<MTU> server;
+
+    constexpr u32 CONNECTIONS = 50;
+
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        ASSERT_TRUE(client.create(Conv{i}).has_value());
+        ASSERT_TRUE(server.create(Conv{i}).has_value());
+    }
+
+    std::vector<Datagram> to_server;
+    std::vector<Datagram> to_client;
+
+    const auto capture = [](std::vector<Datagram>& queue) {
+        return [&queue](const Conv conv, const std::span<const std::byte> data) {
+            queue.push_back({conv, std::vector(data.begin(), data.end())});
+        };
+    };
+
+    // Only every fifth connection sends something
+    for (u32 i = 0; i < CONNECTIONS; i += 5) {
+        std::vector<std::byte> payload(3000, static_cast<std::byte>(i));
+        ASSERT_TRUE(client.send(Conv{i}, payload).has_value());
+    }
+
+    for (u32 current = 0; current < 1000; current += 10) {
+        client.update(current, capture(to_server));
+
+        for (const Datagram& datagram : to_server) {
+            ASSERT_TRUE(server.input(datagram.data).has_value());
+        }
+        to_server.clear();
+
+        server.update(current, capture(to_client));
+
+        for (const Datagram& datagram : to_client) {
+            ASSERT_TRUE(client.input(datagram.data).has_value());
+        }
+        to_client.clear();
+    }
+
+    std::vector<std::byte> buffer(4000);
+
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        const auto received = server.recv(Conv{i}, buffer);
+
+        if (i % 5 == 0) {
+            ASSERT_TRUE(received.has_value());
+            ASSERT_EQ(received.value(), 3000);
+            ASSERT_EQ(buffer[0], static_cast<std::byte>(i));
+        } else {
+            ASSERT_EQ(received.error(), error::queue_empty);
+        }
+    }
+
+    // Everything has been delivered and acknowledged
+    ASSERT_EQ(client.active_count(), 0);
+}
+
+TEST(SessionManager_Tests, RemoveFromCallback) {
+    SessionManager<MTU> manager;
+
+    ASSERT_TRUE(manager.create(Conv{1}).has_value());
+    ASSERT_TRUE(manager.create(Conv{2}).has_value());
+
+    std::vector<std::byte> payload(10, std::byte{1});
+    ASSERT_TRUE(manager.send(Conv{1}, payload).has_value());
+    ASSERT_TRUE(manager.send(Conv{2}, payload).has_value());
+
+    // The congestion window is opened by the first flush, so data goes out on the next one
+    manager.update(0, [](Conv, std::span<const std::byte>) { });
+    manager.update(100, [&](const Conv conv, std::span<const std::byte>) {
+        manager.remove(conv == Conv{1} ? Conv{2} : Conv{1});
+    });
+
+    ASSERT_EQ(manager.size(), 1);
+    ASSERT_EQ(manager.active_count(), 1);
+}
+
+TEST(SessionManager_Tests, RemoveItselfFromCallback) {
+    SessionManager<MTU> manager;
+
+    manager.create(Conv{1}).value()->set_congestion_window_enabled(false);
+    ASSERT_TRUE(manager.create(Conv{2}).has_value());
+
+    // Several segments, so the connection keeps flushing after the callback removed it
+    for (u32 i = 0; i < 4; ++i) {
+        std::vector<std::byte> payload(1000, std::byte{1});
+        ASSERT_TRUE(manager.send(Conv{1}, payload).has_value());
+    }
+
+    u32 outputs = 0;
+
+    manager.update(0, [&](const Conv conv, std::span<const std::byte>) {
+        outputs++;
+
+        if (conv == Conv{1}) {
+            (void)manager.remove(conv);
+            ASSERT_EQ(manager.find(conv), nullptr);
+        }
+    });
+
+    ASSERT_GT(outputs, 1);
+    ASSERT_EQ(manager.size(), 1);
+    ASSERT_EQ(manager.find(Conv{1}), nullptr);
+    ASSERT_FALSE(manager.remove(Conv{1}));
+}
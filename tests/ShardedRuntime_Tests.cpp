@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "sharded_runtime.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    bool wait_until(const std::function<bool()>& predicate) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (predicate()) {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return false;
+    }
+
+    /// Stops both runtimes before either is destroyed, also when a failed assertion returns early, since each one posts to the other.
+    struct StopRuntimes final {
+        std::unique_ptr<ShardedRuntime<MTU>>& client;
+        std::unique_ptr<ShardedRuntime<MTU>>& server;
+
+        ~StopRuntimes() {
+            if (this->client) {
+                this->client->stop();
+            }
+
+            if (this->server) {
+                this->server->stop();
+            }
+        }
+    };
+}
+
+TEST(MpscQueue_Tests, PushPop) {
+    MpscQueue<u32> queue(3);
+
+    ASSERT_EQ(queue.capacity(), 4);
+
+    for (u32 i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.try_push(i));
+    }
+
+    ASSERT_FALSE(queue.try_push(4));
+
+    for (u32 i = 0; i < 4; ++i) {
+        ASSERT_EQ(queue.try_pop(), i);
+    }
+
+    ASSERT_FALSE(queue.try_pop().has_value());
+}
+
+TEST(MpscQueue_Tests, ManyProducers) {
+    constexpr u32 PRODUCERS = 4;
+    constexpr u32 PER_PRODUCER = 20000;
+
+    MpscQueue<u32> queue(256);
+    std::vector<std::thread> producers;
+
+    for (u32 p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (u32 i = 0; i < PER_PRODUCER; ++i) {
+                while (!queue.try_push(p * PER_PRODUCER + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Every producer's values must arrive in order
+    std::vector<u32> next(PRODUCERS, 0);
+    u32 received = 0;
+
+    while (received < PRODUCERS * PER_PRODUCER) {
+        const auto value = queue.try_pop();
+
+        if (!value.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const u32 producer = value.value() / PER_PRODUCER;
+        ASSERT_EQ(value.value() % PER_PRODUCER, next[producer]);
+        next[producer]++;
+        received++;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+}
+
+TEST(ShardedRuntime_Tests, DeliversBetweenRuntimes) {
+    constexpr u32 CONNECTIONS = 16;
+    constexpr size_t MESSAGE_SIZE = 5000;
+
+    std::atomic<u32> delivered{0};
+    std::atomic<bool> corrupted{false};
+    std::atomic<u32> created{0};
+
+    std::unique_ptr<ShardedRuntime<MTU>> client;
+    std::unique_ptr<ShardedRuntime<MTU>> server;
+    const StopRuntimes stop_runtimes{client, server};
+
+    const ShardedRuntime<MTU>::Config config{ .shards = 2, .queue_capacity = 1024 };
+
+    server = std::make_unique<ShardedRuntime<MTU>>(config,
+        [&client](Conv, const std::span<const std::byte> data) { client->post_input(data); },
+        [&](SessionManager<MTU>& manager, const Conv conv) {
+            std::array<std::byte, MESSAGE_SIZE> buffer{};
+
+            while (manager.recv(conv, buffer).has_value()) {
+                if (buffer[MESSAGE_SIZE - 1] != static_cast<std::byte>(conv.get())) {
+                    corrupted = true;
+                }
+
+                delivered++;
+            }
+        });
+
+    client = std::make_unique<ShardedRuntime<MTU>>(config,
+        [&server](Conv, const std::span<const std::byte> data) { server->post_input(data); });
+
+    ASSERT_EQ(client->shard_count(), 2);
+
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        ASSERT_TRUE(server->post(Conv{i}, [i](SessionManager<MTU>& manager) {
+            (void)manager.create(Conv{i});
+        }));
+    }
+
+    // Server connections have to exist before the first datagram arrives
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        ASSERT_TRUE(server->post(Conv{i}, [&created](SessionManager<MTU>&) { created++; }));
+    }
+    ASSERT_TRUE(wait_until([&] { return created == CONNECTIONS; }));
+
+    for (u32 i = 0; i < CONNECTIONS; ++i) {
+        ASSERT_TRUE(client->post(Conv{i}, [i](SessionManager<MTU>& manager) {
+            (void)manager.create(Conv{i});
+
+            std::vector<std::byte> payload(MESSAGE_SIZE, static_cast<std::byte>(i));
+            (void)manager.send(Conv{i}, payload);
+        }));
+    }
+
+    ASSERT_TRUE(wait_until([&] { return delivered == CONNECTIONS; }));
+    ASSERT_FALSE(corrupted);
+
+    client->stop();
+    server->stop();
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include <thread>
+#include <unistd.h>
+#include "imkcpp.hpp"
+#include "transport/shm_ipc.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::transport;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    std::string unique_name(const char* test) {
+        return std::string("/imkcpp_test_") + test + "_" + std::to_string(::getpid());
+    }
+}
+
+TEST(ShmTransport_Tests, RingExchange) {
+    const std::string name = unique_name("ring");
+    auto creator = ShmChannel<MTU>::create(name, 4);
+
+    if (!creator.has_value()) {
+        GTEST_SKIP() << "Shared memory is not available";
+    }
+
+    auto opener = ShmChannel<MTU>::open(name);
+    ASSERT_TRUE(opener.has_value());
+
+    auto& a = *creator.value();
+    auto& b = *opener.value();
+
+    ASSERT_FALSE(ShmChannel<MTU>::create(name, 4).has_value());
+    ASSERT_FALSE(ShmChannel<MTU>::create(name + "_odd", 3).has_value());
+    ASSERT_FALSE(ShmChannel<512>::open(name).has_value());
+
+    const std::vector<std::byte> too_large(MTU + 1);
+    ASSERT_FALSE(a.send(too_large));
+
+    for (u8 i = 0; i < 4; ++i) {
+        const std::array<std::byte, 2> datagram{ std::byte{i}, std::byte{0xAB} };
+        ASSERT_TRUE(a.send(datagram));
+    }
+
+    // Full
+    ASSERT_FALSE(a.send(std::vector<std::byte>(1)));
+    ASSERT_FALSE(a.readable());
+    ASSERT_TRUE(b.readable());
+
+    std::vector<u8> order;
+    ASSERT_EQ(b.receive([&order](const std::span<const std::byte> data) {
+        ASSERT_EQ(data.size(), 2);
+        order.push_back(static_cast<u8>(data[0]));
+    }, 3), 3);
+
+    ASSERT_TRUE(a.send(std::vector<std::byte>(1)));
+    ASSERT_EQ(b.receive([&order](const std::span<const std::byte> data) { order.push_back(static_cast<u8>(data[0])); }), 2);
+    ASSERT_EQ(order, (std::vector<u8>{0, 1, 2, 3, 0}));
+    ASSERT_FALSE(b.readable());
+
+    // Other direction
+    ASSERT_TRUE(b.send(std::vector<std::byte>(MTU)));
+    ASSERT_TRUE(a.wait(0));
+    ASSERT_EQ(a.receive([](const std::span<const std::byte> data) { ASSERT_EQ(data.size(), MTU); }), 1);
+    ASSERT_FALSE(a.wait(1));
+}
+
+TEST(ShmTransport_Tests, OpenRejectsInvalidCapacity) {
+    using Ring = transport::detail::ShmRing<MTU>;
+
+    for (const u32 capacity : {0u, 3u}) {
+        const std::string name = unique_name("capacity") + "_" + std::to_string(capacity);
+        const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+        if (fd < 0) {
+            GTEST_SKIP() << "Shared memory is not available";
+        }
+
+        // A region whose size matches the capacity in its header, as a corrupt or hostile creator could leave it
+        const size_t size = CACHE_LINE_SIZE + 2 * (sizeof(Ring) + capacity * sizeof(Ring::Slot));
+        ASSERT_EQ(::ftruncate(fd, static_cast<off_t>(size)), 0);
+
+        void* region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        ASSERT_NE(region, MAP_FAILED);
+
+        const std::array<u32, 3> header{ 0x696B6370, static_cast<u32>(MTU), capacity };
+        std::memcpy(region, header.data(), sizeof(header));
+
+        const auto opened = ShmChannel<MTU>::open(name);
+
+        ::munmap(region, size);
+        ::shm_unlink(name.c_str());
+
+        ASSERT_FALSE(opened.has_value());
+        ASSERT_EQ(opened.error(), error::shm_error);
+    }
+}
+
+TEST(ShmTransport_Tests, WaitIsWokenByWriter) {
+    const std::string name = unique_name("wait");
+    auto creator = ShmChannel<MTU>::create(name, 16);
+
+    if (!creator.has_value()) {
+        GTEST_SKIP() << "Shared memory is not available";
+    }
+
+    auto opener = ShmChannel<MTU>::open(name);
+    ASSERT_TRUE(opener.has_value());
+
+    auto& a = *creator.value();
+    auto& b = *opener.value();
+
+    std::thread writer([&a] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        a.send(std::vector<std::byte>(10));
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    bool readable = false;
+    while (!readable && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        readable = b.wait(5000);
+    }
+
+    writer.join();
+
+    ASSERT_TRUE(readable);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(ShmTransport_Tests, KcpOverSharedMemory) {
+    const std::string name = unique_name("kcp");
+    auto creator = ShmChannel<MTU>::create(name, 256);
+
+    if (!creator.has_value()) {
+        GTEST_SKIP() << "Shared memory is not available";
+    }
+
+    auto opener = ShmChannel<MTU>::open(name);
+    ASSERT_TRUE(opener.has_value());
+
+    auto& a = *creator.value();
+    auto& b = *opener.value();
+
+    ImKcpp<MTU> client(Conv{1});
+    ImKcpp<MTU> server(Conv{1});
+
+    for (ImKcpp<MTU>* kcp : {&client, &server}) {
+        kcp->set_nodelay(1);
+        kcp->set_interval(10);
+    }
+
+    std::vector<std::byte> message(20000);
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<std::byte>(i * 7);
+    }
+
+    ASSERT_TRUE(client.send(message).has_value());
+
+    std::vector<std::byte> received(message.size());
+    tl::expected<size_t, error> size = tl::unexpected(error::queue_empty);
+
+    for (u32 current = 0; current < 2000 && !size.has_value(); current += 10) {
+        client.update(current, a.output());
+        server.update(current, b.output());
+
+        b.receive([&server](const std::span<const std::byte> data) { ASSERT_TRUE(server.input(data).has_value()); });
+        a.receive([&client](const std::span<const std::byte> data) { ASSERT_TRUE(client.input(data).has_value()); });
+
+        size = server.recv(received);
+    }
+
+    ASSERT_TRUE(size.has_value());
+    ASSERT_EQ(received, message);
+}
+
+#endif
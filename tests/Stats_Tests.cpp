@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include "imkcpp.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    struct Pair final {
+        ImKcpp<MTU> sender{Conv{1}};
+        ImKcpp<MTU> receiver{Conv{1}};
+
+        Pair() {
+            for (ImKcpp<MTU>* kcp : {&this->sender, &this->receiver}) {
+                kcp->set_nodelay(1);
+                kcp->set_interval(10);
+                kcp->set_fastresend(2);
+            }
+        }
+
+        /// Exchanges datagrams for the given time, dropping every drop_every-th datagram from the sender.
+        void run(u32& current, const u32 duration, const u32 drop_every) {
+            u32 counter = 0;
+            std::vector<std::vector<std::byte>> to_receiver;
+            std::vector<std::vector<std::byte>> to_sender;
+
+            for (const u32 end = current + duration; current < end; current += 10) {
+                this->sender.update(current, [&](const std::span<const std::byte> data) {
+                    if (drop_every == 0 || ++counter % drop_every != 0) {
+                        to_receiver.emplace_back(data.begin(), data.end());
+                    }
+                });
+                this->receiver.update(current, [&](const std::span<const std::byte> data) {
+                    to_sender.emplace_back(data.begin(), data.end());
+                });
+
+                for (const auto& datagram : to_receiver) {
+                    (void)this->receiver.input(datagram);
+                }
+                for (const auto& datagram : to_sender) {
+                    (void)this->sender.input(datagram);
+                }
+
+                to_receiver.clear();
+                to_sender.clear();
+
+                std::array<std::byte, 4096> buffer{};
+                while (this->receiver.recv(buffer).has_value()) { }
+            }
+        }
+    };
+}
+
+TEST(Stats_Tests, CountersAfterLossyTransfer) {
+    Pair pair;
+    const std::vector<std::byte> message(2000);
+    constexpr u32 MESSAGES = 200;
+
+    for (u32 i = 0; i < MESSAGES; ++i) {
+        ASSERT_TRUE(pair.sender.send(message).has_value());
+    }
+
+    u32 current = 0;
+    pair.run(current, 20000, 7);
+
+    const Stats sender = pair.sender.get_stats();
+    const Stats receiver = pair.receiver.get_stats();
+    const u64 segments = MESSAGES * pair.sender.estimate_segments_count(message.size());
+
+    ASSERT_EQ(sender.bytes_acked, MESSAGES * message.size());
+    ASSERT_EQ(sender.segments_acked, segments);
+    ASSERT_GT(sender.get_retransmitted(), 0);
+    ASSERT_EQ(sender.segments_sent, segments + sender.get_retransmitted());
+    ASSERT_GT(sender.bytes_sent, sender.bytes_acked);
+    ASSERT_EQ(sender.inflight, 0);
+    ASSERT_EQ(sender.send_queue, 0);
+    ASSERT_GT(sender.loss_rate, 0.0);
+    ASSERT_GT(sender.srtt, 0);
+    ASSERT_GE(sender.rto, sender.srtt);
+    ASSERT_GT(sender.cwnd, 0);
+    ASSERT_EQ(sender.timestamp, current - 10);
+
+    ASSERT_GE(receiver.segments_received, segments);
+    ASSERT_EQ(receiver.segments_received - receiver.segments_dropped, segments);
+    ASSERT_EQ(receiver.receive_queue, 0);
+    ASSERT_EQ(receiver.segments_sent, 0);
+}
+
+TEST(Stats_Tests, DeliveryRate) {
+    Pair pair;
+    const std::vector<std::byte> message(1000);
+    u32 current = 0;
+
+    // 1000 bytes every 10 ms, i.e. 100 KB/s
+    for (u32 i = 0; i < 300; ++i) {
+        ASSERT_TRUE(pair.sender.send(message).has_value());
+        pair.run(current, 10, 0);
+    }
+
+    const Stats stats = pair.sender.get_stats();
+
+    ASSERT_NEAR(stats.delivery_rate, 100000.0, 10000.0);
+    ASSERT_EQ(stats.loss_rate, 0.0);
+}
+
+TEST(Stats_Tests, ConsistentSnapshotsFromAnotherThread) {
+    struct Value final {
+        u64 a = 0;
+        u64 b = 0;
+        u32 c = 0;
+    };
+
+    SeqLock<Value> lock;
+    std::atomic<bool> done{false};
+    u64 torn = 0;
+
+    std::thread reader([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            const Value value = lock.load();
+
+            if (value.a != value.b || value.a != value.c) {
+                torn++;
+            }
+        }
+    });
+
+    for (u32 i = 0; i < 200000; ++i) {
+        lock.store(Value{ i, i, i });
+    }
+
+    done = true;
+    reader.join();
+
+    ASSERT_EQ(torn, 0);
+    ASSERT_EQ(lock.load().a, 199999);
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "imkcpp.hpp"
+
+class TailLossProberTest : public testing::Test {
+protected:
+    imkcpp::TailLossProber prober;
+
+    void SetUp() override {
+        prober.set_enabled(true);
+    }
+};
+
+TEST_F(TailLossProberTest, DisabledByDefault) {
+    const imkcpp::TailLossProber default_prober;
+    ASSERT_FALSE(default_prober.is_enabled());
+    ASSERT_FALSE(default_prober.should_probe(1000, 0, 5000, 40));
+}
+
+TEST_F(TailLossProberTest, CalculatePto) {
+    using namespace imkcpp;
+
+    ASSERT_EQ(TailLossProber::calculate_pto(0, 10), 10);
+    ASSERT_EQ(TailLossProber::calculate_pto(20, 10), 40);
+    ASSERT_EQ(TailLossProber::calculate_pto(20, 100), 100);
+}
+
+TEST_F(TailLossProberTest, ProbesAfterPto) {
+    prober.ack_progress(100);
+
+    ASSERT_FALSE(prober.should_probe(130, 100, 500, 40));
+    ASSERT_TRUE(prober.should_probe(140, 100, 500, 40));
+}
+
+TEST_F(TailLossProberTest, UsesLatestOfSendAndProgress) {
+    prober.ack_progress(100);
+
+    ASSERT_FALSE(prober.should_probe(140, 120, 500, 40));
+    ASSERT_TRUE(prober.should_probe(160, 120, 500, 40));
+}
+
+TEST_F(TailLossProberTest, SingleProbeUntilProgress) {
+    prober.ack_progress(100);
+    ASSERT_TRUE(prober.should_probe(140, 100, 500, 40));
+
+    prober.probe_sent();
+    ASSERT_FALSE(prober.should_probe(200, 100, 500, 40));
+
+    prober.ack_progress(200);
+    ASSERT_TRUE(prober.should_probe(240, 100, 500, 40));
+}
+
+TEST_F(TailLossProberTest, DoesNotProbeIfRtoFiresFirst) {
+    prober.ack_progress(100);
+    ASSERT_FALSE(prober.should_probe(140, 100, 130, 40));
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "thread_safe_handle.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+}
+
+TEST(SpscQueue_Tests, PushPop) {
+    SpscQueue<u32> queue(4);
+
+    for (u32 i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.try_push(i));
+    }
+
+    ASSERT_TRUE(queue.full());
+    ASSERT_FALSE(queue.try_push(4));
+
+    ASSERT_EQ(queue.try_pop(), 0);
+    ASSERT_TRUE(queue.try_push(4));
+
+    for (u32 i = 1; i < 5; ++i) {
+        ASSERT_EQ(queue.try_pop(), i);
+    }
+
+    ASSERT_FALSE(queue.try_pop().has_value());
+}
+
+TEST(SpscQueue_Tests, ProducerConsumer) {
+    constexpr u32 COUNT = 100000;
+
+    SpscQueue<u32> queue(64);
+
+    std::thread producer([&queue] {
+        for (u32 i = 0; i < COUNT; ++i) {
+            while (!queue.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (u32 expected = 0; expected < COUNT;) {
+        const auto value = queue.try_pop();
+
+        if (!value.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        ASSERT_EQ(value.value(), expected);
+        expected++;
+    }
+
+    producer.join();
+}
+
+TEST(ThreadSafeHandle_Tests, PumpMovesMessages) {
+    ImKcpp<MTU> sender_kcp(Conv{1});
+    ImKcpp<MTU> receiver_kcp(Conv{1});
+
+    ThreadSafeHandle<MTU> sender_handle;
+    ThreadSafeHandle<MTU> receiver_handle;
+
+    for (u32 i = 0; i < 10; ++i) {
+        ASSERT_TRUE(sender_handle.try_send(std::vector<std::byte>(100 + i, static_cast<std::byte>(i))));
+    }
+
+    const PumpResult pumped = sender_handle.pump(sender_kcp);
+    ASSERT_EQ(pumped.sent_count, 10);
+    ASSERT_EQ(sender_kcp.get_waiting_send_count(), 10);
+
+    const auto deliver = [&](const std::span<const std::byte> data) {
+        ASSERT_TRUE(receiver_kcp.input(data).has_value());
+    };
+
+    // The congestion window is opened by the first flush
+    sender_kcp.update(0, deliver);
+    sender_kcp.update(100, deliver);
+
+    ASSERT_FALSE(receiver_handle.try_recv().has_value());
+    ASSERT_EQ(receiver_handle.pump(receiver_kcp).received_count, 1);
+
+    const auto message = receiver_handle.try_recv();
+    ASSERT_TRUE(message.has_value());
+    ASSERT_EQ(message->size(), 100);
+}
+
+TEST(ThreadSafeHandle_Tests, WaitingSegmentsLimit) {
+    ImKcpp<MTU> kcp(Conv{1});
+    ThreadSafeHandle<MTU> handle({ .max_waiting_segments = 3 });
+
+    for (u32 i = 0; i < 5; ++i) {
+        ASSERT_TRUE(handle.try_send(std::vector<std::byte>(10)));
+    }
+
+    ASSERT_EQ(handle.pump(kcp).sent_count, 3);
+    ASSERT_EQ(handle.pump(kcp).sent_count, 0);
+}
+
+TEST(ThreadSafeHandle_Tests, ApplicationThreads) {
+    constexpr u32 PRODUCERS = 3;
+    constexpr u32 PER_PRODUCER = 2000;
+
+    ImKcpp<MTU> client(Conv{1});
+    ImKcpp<MTU> server(Conv{1});
+
+    for (auto* kcp : { &client, &server }) {
+        kcp->set_nodelay(1);
+        kcp->set_interval(10);
+        kcp->set_send_window(512);
+        kcp->set_receive_window(512);
+    }
+
+    ThreadSafeHandle<MTU> client_handle;
+    ThreadSafeHandle<MTU> server_handle;
+
+    std::atomic<bool> running{true};
+
+    // Network thread owning both connections
+    std::thread network([&] {
+        std::vector<std::vector<std::byte>> to_server;
+        std::vector<std::vector<std::byte>> to_client;
+        u32 current = 0;
+
+        while (running) {
+            client_handle.pump(client);
+            client.update(current, [&](const std::span<const std::byte> data) { to_server.emplace_back(data.begin(), data.end()); });
+
+            for (const auto& datagram : to_server) {
+                (void)server.input(datagram);
+            }
+            to_server.clear();
+
+            server_handle.pump(server);
+            server.update(current, [&](const std::span<const std::byte> data) { to_client.emplace_back(data.begin(), data.end()); });
+
+            for (const auto& datagram : to_client) {
+                (void)client.input(datagram);
+            }
+            to_client.clear();
+
+            current += 10;
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> producers;
+
+    for (u32 p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&client_handle, p] {
+            for (u32 i = 0; i < PER_PRODUCER; ++i) {
+                std::vector<std::byte> message(8);
+                std::memcpy(message.data(), &p, sizeof(p));
+                std::memcpy(message.data() + 4, &i, sizeof(i));
+
+                while (!client_handle.try_send(std::move(message))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Messages of each producer arrive in order
+    std::vector<u32> next(PRODUCERS, 0);
+    u32 received = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+
+    while (received < PRODUCERS * PER_PRODUCER && std::chrono::steady_clock::now() < deadline) {
+        const auto message = server_handle.try_recv();
+
+        if (!message.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        u32 p = 0;
+        u32 i = 0;
+        std::memcpy(&p, message->data(), sizeof(p));
+        std::memcpy(&i, message->data() + 4, sizeof(i));
+
+        ASSERT_LT(p, PRODUCERS);
+        ASSERT_EQ(i, next[p]);
+        next[p]++;
+        received++;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    running = false;
+    network.join();
+
+    ASSERT_EQ(received, PRODUCERS * PER_PRODUCER);
+}
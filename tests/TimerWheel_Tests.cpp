@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "timer_wheel.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    struct TestTimer final : TimerNode {
+        u32 id = 0;
+    };
+
+    std::vector<u32> advance(TimerWheel& wheel, const u32 current) {
+        std::vector<TimerNode*> expired;
+        wheel.advance(current, expired);
+
+        std::vector<u32> ids;
+        for (TimerNode* node : expired) {
+            ids.push_back(static_cast<TestTimer*>(node)->id);
+        }
+
+        std::ranges::sort(ids);
+        return ids;
+    }
+}
+
+TEST(TimerWheel_Tests, ExpiresAtDeadline) {
+    TimerWheel wheel;
+    TestTimer timer;
+    timer.id = 1;
+
+    wheel.schedule(timer, 10);
+    ASSERT_TRUE(timer.is_scheduled());
+
+    ASSERT_TRUE(advance(wheel, 9).empty());
+    ASSERT_EQ(advance(wheel, 10), std::vector<u32>{1});
+    ASSERT_FALSE(timer.is_scheduled());
+    ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel_Tests, PastDeadlineExpiresOnNextTick) {
+    TimerWheel wheel(100);
+    TestTimer timer;
+    timer.id = 1;
+
+    wheel.schedule(timer, 50);
+
+    ASSERT_EQ(advance(wheel, 100), std::vector<u32>{1});
+}
+
+TEST(TimerWheel_Tests, Cancel) {
+    TimerWheel wheel;
+    TestTimer a, b;
+    a.id = 1;
+    b.id = 2;
+
+    wheel.schedule(a, 5);
+    wheel.schedule(b, 5);
+    wheel.cancel(a);
+    wheel.cancel(a);
+
+    ASSERT_EQ(wheel.size(), 1);
+    ASSERT_EQ(advance(wheel, 5), std::vector<u32>{2});
+}
+
+TEST(TimerWheel_Tests, Reschedule) {
+    TimerWheel wheel;
+    TestTimer timer;
+    timer.id = 1;
+
+    wheel.schedule(timer, 5000);
+    wheel.schedule(timer, 20);
+
+    ASSERT_EQ(wheel.size(), 1);
+    ASSERT_EQ(advance(wheel, 20), std::vector<u32>{1});
+    ASSERT_TRUE(advance(wheel, 6000).empty());
+}
+
+TEST(TimerWheel_Tests, CascadesFromHigherLevels) {
+    TimerWheel wheel(7);
+
+    const std::vector<u32> deadlines = { 63, 64, 65, 4095, 4096, 4097, 300000, 16777300, 20000000 };
+    std::vector<TestTimer> timers(deadlines.size());
+
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        timers[i].id = static_cast<u32>(i);
+        wheel.schedule(timers[i], deadlines[i]);
+    }
+
+    // Advance in irregular steps and make sure every timer fires exactly at its deadline
+    u32 current = 7;
+    size_t fired = 0;
+    while (fired < deadlines.size()) {
+        const u32 next = current + 1 + (current % 97);
+        const auto ids = advance(wheel, next);
+
+        for (const u32 id : ids) {
+            ASSERT_GT(deadlines[id], current);
+            ASSERT_LE(deadlines[id], next);
+        }
+
+        fired += ids.size();
+        current = next;
+    }
+
+    ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel_Tests, LargeJump) {
+    TimerWheel wheel;
+    TestTimer timer;
+    timer.id = 1;
+
+    wheel.schedule(timer, 2000000000u);
+
+    ASSERT_TRUE(advance(wheel, 1999999999u).empty());
+    ASSERT_EQ(advance(wheel, 2000000000u), std::vector<u32>{1});
+}
+
+TEST(TimerWheel_Tests, Wraparound) {
+    TimerWheel wheel(0xFFFFFFF0u);
+    TestTimer timer;
+    timer.id = 1;
+
+    wheel.schedule(timer, 0x10);
+
+    ASSERT_TRUE(advance(wheel, 0x0F).empty());
+    ASSERT_EQ(advance(wheel, 0x10), std::vector<u32>{1});
+}
+
+TEST(TimerWheel_Tests, NextExpiry) {
+    TimerWheel wheel(10);
+    TestTimer a, b;
+
+    ASSERT_FALSE(wheel.next_expiry().has_value());
+
+    wheel.schedule(a, 5000);
+    const u32 hint = wheel.next_expiry().value();
+    ASSERT_GT(hint, 10);
+    ASSERT_LE(hint, 5000);
+
+    wheel.schedule(b, 30);
+    ASSERT_EQ(wheel.next_expiry(), 30);
+
+    // Slots before the current index belong to the next rotation
+    ASSERT_EQ(advance(wheel, 40), std::vector<u32>{0});
+    wheel.schedule(b, 70);
+    ASSERT_EQ(wheel.next_expiry(), 70);
+
+    // Expiring hints never skip a node
+    u32 current = 40;
+    while (!wheel.empty()) {
+        const u32 next = wheel.next_expiry().value();
+        ASSERT_TRUE(advance(wheel, next - 1).empty());
+        current = next;
+        advance(wheel, current);
+    }
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include "imkcpp.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    using TracedKcp = ImKcpp<MTU, RingBufferTracer<4096>>;
+
+    void configure(TracedKcp& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        kcp.set_fastresend(2);
+    }
+
+    std::vector<TraceRecord> records_of(TracedKcp& kcp, const TraceEvent event) {
+        std::vector<TraceRecord> result;
+
+        kcp.get_tracer().for_each([&result, event](const TraceRecord& record) {
+            if (record.event == event) {
+                result.push_back(record);
+            }
+        });
+
+        return result;
+    }
+}
+
+static_assert(std::is_empty_v<NoopTracer>);
+static_assert(TracerPolicy<RingBufferTracer<16>>);
+
+TEST(Tracing_Tests, LossyTransfer) {
+    TracedKcp sender(Conv{1});
+    TracedKcp receiver(Conv{1});
+    configure(sender);
+    configure(receiver);
+
+    const std::vector<std::byte> message(10000);
+    ASSERT_TRUE(sender.send(message).has_value());
+
+    u32 counter = 0;
+    std::vector<std::vector<std::byte>> to_receiver;
+    std::vector<std::vector<std::byte>> to_sender;
+
+    for (u32 current = 0; current < 5000; current += 10) {
+        sender.update(current, [&](const std::span<const std::byte> data) {
+            // Drop the second datagram, which carries the second segment
+            if (++counter != 2) {
+                to_receiver.emplace_back(data.begin(), data.end());
+            }
+        });
+        receiver.update(current, [&](const std::span<const std::byte> data) { to_sender.emplace_back(data.begin(), data.end()); });
+
+        for (const auto& datagram : to_receiver) {
+            (void)receiver.input(datagram);
+        }
+        for (const auto& datagram : to_sender) {
+            (void)sender.input(datagram);
+        }
+
+        to_receiver.clear();
+        to_sender.clear();
+    }
+
+    const size_t segments = sender.estimate_segments_count(message.size());
+
+    const auto sent = records_of(sender, TraceEvent::SegmentSent);
+    ASSERT_EQ(sent.size(), segments);
+    for (size_t i = 0; i < sent.size(); ++i) {
+        ASSERT_EQ(sent[i].a, i);
+        ASSERT_EQ(sent[i].b, i + 1 < segments ? MTU - 24 : message.size() - (segments - 1) * (MTU - 24));
+    }
+
+    const auto resent = records_of(sender, TraceEvent::SegmentRetransmitted);
+    ASSERT_FALSE(resent.empty());
+    ASSERT_EQ(resent.front().a, 1);
+    ASSERT_EQ(resent.front().b, 2);
+    ASSERT_NE(static_cast<RetransmitCause>(resent.front().detail), RetransmitCause::Nack);
+
+    // Segments covered by una before their own ack arrives aren't reported as acked
+    const auto acks = records_of(sender, TraceEvent::AckReceived);
+    ASSERT_FALSE(acks.empty());
+    ASSERT_LE(acks.size(), segments);
+
+    const auto una = records_of(sender, TraceEvent::UnaAdvanced);
+    ASSERT_FALSE(una.empty());
+    ASSERT_EQ(una.back().a, segments);
+    for (size_t i = 1; i < una.size(); ++i) {
+        ASSERT_GT(una[i].a, una[i - 1].a);
+    }
+
+    ASSERT_FALSE(records_of(sender, TraceEvent::CwndChanged).empty());
+
+    // Nothing was sent by the receiver
+    ASSERT_TRUE(records_of(receiver, TraceEvent::SegmentSent).empty());
+}
+
+TEST(Tracing_Tests, WindowProbes) {
+    TracedKcp sender(Conv{1});
+    TracedKcp receiver(Conv{1});
+    configure(sender);
+    configure(receiver);
+
+    // The receiver never reads, so its window closes and the sender has to ask for it
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(sender.send(std::vector<std::byte>(100)).has_value());
+    }
+
+    std::vector<std::vector<std::byte>> to_receiver;
+    std::vector<std::vector<std::byte>> to_sender;
+
+    for (u32 current = 0; current < 20000; current += 10) {
+        sender.update(current, [&](const std::span<const std::byte> data) { to_receiver.emplace_back(data.begin(), data.end()); });
+        receiver.update(current, [&](const std::span<const std::byte> data) { to_sender.emplace_back(data.begin(), data.end()); });
+
+        for (const auto& datagram : to_receiver) {
+            (void)receiver.input(datagram);
+        }
+        for (const auto& datagram : to_sender) {
+            (void)sender.input(datagram);
+        }
+
+        to_receiver.clear();
+        to_sender.clear();
+    }
+
+    const auto asked = records_of(sender, TraceEvent::WindowProbe);
+    ASSERT_FALSE(asked.empty());
+    ASSERT_EQ(asked.front().a, 1);
+    ASSERT_EQ(Cmd(asked.front().detail), commands::WASK);
+
+    const auto told = records_of(receiver, TraceEvent::WindowProbe);
+    ASSERT_FALSE(told.empty());
+    ASSERT_EQ(told.front().a, 0);
+    ASSERT_EQ(Cmd(told.front().detail), commands::WASK);
+}
+
+TEST(Tracing_Tests, RingBufferOverwritesOldest) {
+    RingBufferTracer<4> tracer;
+
+    for (u32 i = 0; i < 10; ++i) {
+        tracer.una_advanced(i, i);
+    }
+
+    ASSERT_EQ(tracer.size(), 4);
+    ASSERT_EQ(tracer.get_overwritten(), 6);
+
+    std::vector<u32> una;
+    tracer.for_each([&una](const TraceRecord& record) { una.push_back(record.a); });
+    ASSERT_EQ(una, (std::vector<u32>{6, 7, 8, 9}));
+
+    tracer.clear();
+    ASSERT_EQ(tracer.size(), 0);
+}
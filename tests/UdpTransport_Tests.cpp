@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+
+#include "transport/linux_udp.hpp"
+
+using namespace imkcpp;
+using namespace imkcpp::transport;
+
+namespace {
+    constexpr size_t MTU = 1400;
+
+    std::unique_ptr<UdpTransport<MTU>> open_loopback(const bool accept, const bool offload = false) {
+        UdpConfig config;
+        config.bind_address = UdpAddress::ipv4("127.0.0.1", 0).value();
+        config.accept_connections = accept;
+        config.gso = offload;
+        config.gro = offload;
+
+        auto transport = UdpTransport<MTU>::open(config);
+        return transport.has_value() ? std::move(transport.value()) : nullptr;
+    }
+
+    /// Sends a datagram from a plain socket, bypassing any connection.
+    void send_raw(const UdpAddress& to, const std::span<const std::byte> data) {
+        const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(::sendto(fd, data.data(), data.size(), 0, to.get(), to.length), static_cast<ssize_t>(data.size()));
+        ::close(fd);
+    }
+}
+
+TEST(UdpTransport_Tests, LoopbackExchange) {
+    auto server = open_loopback(true);
+    auto client = open_loopback(false);
+
+    if (server == nullptr || client == nullptr) {
+        GTEST_SKIP() << "UDP sockets are not available";
+    }
+
+    std::vector<std::byte> received;
+
+    server->set_receive_callback([&received](UdpTransport<MTU>& transport, const Conv conv) {
+        std::array<std::byte, 8192> buffer{};
+
+        if (const auto size = transport.recv(conv, buffer); size.has_value()) {
+            received.assign(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(size.value()));
+        }
+    });
+
+    bool accepted = false;
+    server->set_accept_callback([&accepted](UdpTransport<MTU>&, Conv, ImKcpp<MTU>& kcp) {
+        kcp.set_nodelay(1);
+        kcp.set_interval(10);
+        accepted = true;
+    });
+
+    const auto kcp = client->connect(Conv{7}, server->local_address());
+    ASSERT_TRUE(kcp.has_value());
+    kcp.value()->set_nodelay(1);
+    kcp.value()->set_interval(10);
+
+    ASSERT_EQ(client->connect(Conv{7}, server->local_address()).error(), error::conv_already_exists);
+
+    std::vector<std::byte> message(5000);
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<std::byte>(i);
+    }
+
+    ASSERT_TRUE(client->send(Conv{7}, message).has_value());
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received.empty() && std::chrono::steady_clock::now() < deadline) {
+        client->poll(1);
+        server->poll(1);
+    }
+
+    ASSERT_TRUE(accepted);
+    ASSERT_EQ(received, message);
+    ASSERT_GT(client->get_stats().datagrams_sent, 0);
+    ASSERT_GT(server->get_stats().datagrams_received, 0);
+}
+
+TEST(UdpTransport_Tests, SegmentationOffload) {
+    auto server = open_loopback(true, true);
+    auto client = open_loopback(false, true);
+
+    if (server == nullptr || client == nullptr) {
+        GTEST_SKIP() << "UDP sockets are not available";
+    }
+
+    if (!client->is_gso_enabled() || !server->is_gro_enabled()) {
+        GTEST_SKIP() << "UDP GSO / GRO is not supported by the kernel";
+    }
+
+    constexpr size_t MESSAGE_SIZE = 100 * 1000;
+    size_t received = 0;
+
+    server->set_accept_callback([](UdpTransport<MTU>&, Conv, ImKcpp<MTU>& kcp) {
+        kcp.set_send_window(256);
+        kcp.set_receive_window(256);
+    });
+
+    server->set_receive_callback([&received](UdpTransport<MTU>& transport, const Conv conv) {
+        std::vector<std::byte> buffer(MESSAGE_SIZE);
+
+        if (const auto size = transport.recv(conv, buffer); size.has_value()) {
+            received = size.value();
+        }
+    });
+
+    const auto kcp = client->connect(Conv{3}, server->local_address());
+    ASSERT_TRUE(kcp.has_value());
+    kcp.value()->set_congestion_window_enabled(false);
+    kcp.value()->set_send_window(256);
+    kcp.value()->set_receive_window(256);
+
+    ASSERT_TRUE(client->send(Conv{3}, std::vector<std::byte>(MESSAGE_SIZE, std::byte{1})).has_value());
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received == 0 && std::chrono::steady_clock::now() < deadline) {
+        client->poll(1);
+        server->poll(1);
+    }
+
+    ASSERT_EQ(received, MESSAGE_SIZE);
+
+    // Full segments to the same peer are coalesced
+    ASSERT_GT(client->get_stats().gso_buffers_sent, 0);
+    ASSERT_LT(client->get_stats().send_syscalls, client->get_stats().datagrams_sent);
+}
+
+TEST(UdpTransport_Tests, RejectsUnknownConv) {
+    auto server = open_loopback(false);
+    auto client = open_loopback(false);
+
+    if (server == nullptr || client == nullptr) {
+        GTEST_SKIP() << "UDP sockets are not available";
+    }
+
+    ASSERT_TRUE(client->connect(Conv{1}, server->local_address()).has_value());
+    ASSERT_TRUE(client->send(Conv{1}, std::vector<std::byte>(10)).has_value());
+
+    for (int i = 0; i < 50 && server->get_stats().datagrams_rejected == 0; ++i) {
+        client->poll(1);
+        server->poll(1);
+    }
+
+    ASSERT_GT(server->get_stats().datagrams_rejected, 0);
+    ASSERT_EQ(server->find(Conv{1}), nullptr);
+}
+
+TEST(UdpTransport_Tests, InvalidFirstDatagramIsNotAccepted) {
+    auto server = open_loopback(true);
+
+    if (server == nullptr) {
+        GTEST_SKIP() << "UDP sockets are not available";
+    }
+
+    size_t accepted = 0;
+    server->set_accept_callback([&accepted](UdpTransport<MTU>&, Conv, ImKcpp<MTU>&) {
+        accepted++;
+    });
+
+    // Conv 0xFFFFFFFF with an unknown command
+    const std::vector<std::byte> junk(64, std::byte{0xFF});
+    send_raw(server->local_address(), junk);
+
+    for (int i = 0; i < 50 && server->get_stats().datagrams_rejected == 0; ++i) {
+        server->poll(1);
+    }
+
+    ASSERT_EQ(server->get_stats().datagrams_rejected, 1);
+    ASSERT_EQ(server->find(Conv{0xFFFFFFFF}), nullptr);
+    ASSERT_EQ(accepted, 0);
+}
+
+#endif
@@ -0,0 +1,144 @@
+// Replays a capture written by CaptureWriter into a fresh connection, e.g. under perf or valgrind.
+// Usage: imkcpp_capture_replay <capture> [--repeat N] [--nodelay N] [--interval N] [--resend N] [--nc]
+//                              [--sndwnd N] [--rcvwnd N] [--nack]
+// The connection must be configured like the captured one, otherwise outputs are reported as mismatched.
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+
+#include "imkcpp.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    struct Options final {
+        const char* path = nullptr;
+        u32 repeat = 1;
+
+        // Only the given options are applied, everything else keeps ImKcpp's defaults
+        std::optional<u32> nodelay{};
+        std::optional<u32> interval{};
+        std::optional<u32> resend{};
+        bool nc = false;
+        std::optional<u32> sndwnd{};
+        std::optional<u32> rcvwnd{};
+        bool nack = false;
+    };
+
+    bool parse(const int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const auto value = [&]() -> u32 {
+                return i + 1 < argc ? static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)) : 0;
+            };
+
+            if (std::strcmp(argv[i], "--repeat") == 0) {
+                options.repeat = value();
+            } else if (std::strcmp(argv[i], "--nodelay") == 0) {
+                options.nodelay = value();
+            } else if (std::strcmp(argv[i], "--interval") == 0) {
+                options.interval = value();
+            } else if (std::strcmp(argv[i], "--resend") == 0) {
+                options.resend = value();
+            } else if (std::strcmp(argv[i], "--nc") == 0) {
+                options.nc = true;
+            } else if (std::strcmp(argv[i], "--sndwnd") == 0) {
+                options.sndwnd = value();
+            } else if (std::strcmp(argv[i], "--rcvwnd") == 0) {
+                options.rcvwnd = value();
+            } else if (std::strcmp(argv[i], "--nack") == 0) {
+                options.nack = true;
+            } else if (argv[i][0] != '-' && options.path == nullptr) {
+                options.path = argv[i];
+            } else {
+                return false;
+            }
+        }
+
+        return options.path != nullptr && options.repeat > 0 && options.sndwnd != 0u && options.rcvwnd != 0u;
+    }
+
+    template <size_t MTU>
+    int run(CaptureReader& reader, const Options& options) {
+        ReplayResult result{};
+        const auto start = std::chrono::steady_clock::now();
+
+        for (u32 i = 0; i < options.repeat; ++i) {
+            reader.rewind();
+
+            ImKcpp<MTU> kcp(reader.get_info().conv);
+
+            if (options.nodelay.has_value()) {
+                kcp.set_nodelay(*options.nodelay);
+            }
+            if (options.interval.has_value()) {
+                kcp.set_interval(*options.interval);
+            }
+            if (options.resend.has_value()) {
+                kcp.set_fastresend(*options.resend);
+            }
+            if (options.nc) {
+                kcp.set_congestion_window_enabled(false);
+            }
+            if (options.sndwnd.has_value()) {
+                kcp.set_send_window(*options.sndwnd);
+            }
+            if (options.rcvwnd.has_value()) {
+                kcp.set_receive_window(*options.rcvwnd);
+            }
+            if (options.nack) {
+                kcp.set_nack_enabled(true);
+            }
+
+            result = replay(reader, kcp);
+        }
+
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (reader.is_malformed()) {
+            std::fprintf(stderr, "Warning: the capture ends with a truncated or invalid record\n");
+        }
+
+        std::printf("updates %llu, flushes %llu, inputs %llu, sends %llu, recvs %llu\n",
+                    static_cast<unsigned long long>(result.updates), static_cast<unsigned long long>(result.flushes),
+                    static_cast<unsigned long long>(result.inputs),
+                    static_cast<unsigned long long>(result.sends), static_cast<unsigned long long>(result.recvs));
+        std::printf("outputs %llu (captured %llu, mismatched %llu)\n",
+                    static_cast<unsigned long long>(result.outputs), static_cast<unsigned long long>(result.captured_outputs),
+                    static_cast<unsigned long long>(result.mismatched_outputs));
+        std::printf("%u replays in %.3f s, %.3f ms per replay\n", options.repeat, elapsed, elapsed * 1000.0 / options.repeat);
+
+        return result.mismatched_outputs == 0 ? 0 : 3;
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+
+    if (!parse(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s <capture> [--repeat N] [--nodelay N] [--interval N] [--resend N] [--nc] [--sndwnd N] [--rcvwnd N] [--nack]\n", argv[0]);
+        return 2;
+    }
+
+    auto reader = CaptureReader::open(options.path);
+
+    if (!reader.has_value()) {
+        std::fprintf(stderr, "Failed to read %s: %s\n", options.path, err_to_str(reader.error()).c_str());
+        return 1;
+    }
+
+    // ImKcpp's MTU is a template parameter, so only common values are supported
+    switch (reader->get_info().mtu) {
+        case 512: return run<512>(*reader, options);
+        case 1200: return run<1200>(*reader, options);
+        case 1400: return run<1400>(*reader, options);
+        case 1472: return run<1472>(*reader, options);
+        case 8192: return run<8192>(*reader, options);
+        default:
+            std::fprintf(stderr, "Unsupported MTU %u\n", reader->get_info().mtu);
+            return 1;
+    }
+}
@@ -0,0 +1,74 @@
+// Prints the timeline stored in a file written by FlightRecorder::dump().
+// Usage: imkcpp_flight_decoder <dump> [conv]
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+#include "flight_recorder.hpp"
+#include "commands.hpp"
+
+using namespace imkcpp;
+
+namespace {
+    const char* command_name(const u8 cmd) {
+        switch (cmd) {
+            case commands::PUSH.get(): return "PUSH";
+            case commands::ACK.get(): return "ACK";
+            case commands::WASK.get(): return "WASK";
+            case commands::WINS.get(): return "WINS";
+            case commands::NACK.get(): return "NACK";
+            default: return "?";
+        }
+    }
+
+    void print(const FlightRecord& record) {
+        std::printf("%10u  conv %-10u ", record.time, record.conv);
+
+        switch (record.event) {
+            case FlightEvent::HeaderSent:
+            case FlightEvent::HeaderReceived:
+                std::printf("%s %-4s sn=%u una=%u ts=%u len=%u wnd=%u frg=%u\n",
+                            record.event == FlightEvent::HeaderSent ? "-->" : "<--",
+                            command_name(record.cmd), record.b, record.c, record.a, record.d, record.e, record.frg);
+                break;
+            case FlightEvent::Flushed:
+                std::printf("flush bytes=%u push=%u retransmitted=%u rto=%u srtt=%u cwnd=%u\n",
+                            record.a, record.e, record.f, record.b, record.c, record.d);
+                break;
+            case FlightEvent::DeadLink:
+                std::printf("DEAD LINK snd_una=%u snd_nxt=%u\n", record.a, record.b);
+                break;
+            default:
+                std::printf("unknown event %u\n", static_cast<unsigned>(record.event));
+                break;
+        }
+    }
+}
+
+int main(const int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <dump> [conv]\n", argv[0]);
+        return 2;
+    }
+
+    const auto dump = FlightRecorder::load(argv[1]);
+
+    if (!dump.has_value()) {
+        std::fprintf(stderr, "Failed to read %s: %s\n", argv[1], err_to_str(dump.error()).c_str());
+        return 1;
+    }
+
+    const bool filter = argc > 2;
+    const u32 conv = filter ? static_cast<u32>(std::strtoul(argv[2], nullptr, 10)) : 0;
+
+    std::printf("%zu records, %llu older ones were overwritten\n", dump->records.size(), static_cast<unsigned long long>(dump->overwritten));
+
+    for (const FlightRecord& record : dump->records) {
+        if (!filter || record.conv == conv) {
+            print(record);
+        }
+    }
+
+    return 0;
+}